@@ -0,0 +1,329 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+/*
+  The part of the Avisynth+ plugin API which RawSource uses, for running
+  it without Avisynth (see avisynth_host.cpp). Names and signatures are
+  the ones of avisynth.h, the values of the constants are not.
+*/
+#ifndef RAWSOURCE_COMPAT_AVISYNTH_H
+#define RAWSOURCE_COMPAT_AVISYNTH_H
+
+
+#include <cstdint>
+#include <atomic>
+
+
+enum {
+    AVISYNTH_INTERFACE_VERSION = 6,
+};
+
+enum {
+    PLANAR_Y = 1 << 0,
+    PLANAR_U = 1 << 1,
+    PLANAR_V = 1 << 2,
+    PLANAR_A = 1 << 4,
+    PLANAR_R = 1 << 5,
+    PLANAR_G = 1 << 6,
+    PLANAR_B = 1 << 7,
+};
+
+enum {
+    SAMPLE_INT8 = 1 << 0,
+    SAMPLE_INT16 = 1 << 1,
+    SAMPLE_INT24 = 1 << 2,
+    SAMPLE_INT32 = 1 << 3,
+    SAMPLE_FLOAT = 1 << 4,
+};
+
+enum MtMode {
+    MT_INVALID = 0,
+    MT_NICE_FILTER = 1,
+    MT_MULTI_INSTANCE = 2,
+    MT_SERIALIZED = 3,
+};
+
+// the values of the Avisynth+ header which the plugin uses.
+enum CachePolicyHint {
+    CACHE_NOTHING = 10,
+    CACHE_WINDOW = 11,
+    CACHE_GENERIC = 12,
+    CACHE_FORCE_GENERIC = 13,
+    CACHE_GET_POLICY = 30,
+    CACHE_GET_WINDOW = 31,
+    CACHE_GET_RANGE = 32,
+    CACHE_AVSPLUS_CONSTANTS = 500,
+    CACHE_DONT_CACHE_ME,
+    CACHE_SET_MIN_CAPACITY,
+    CACHE_SET_MAX_CAPACITY,
+    CACHE_GET_MIN_CAPACITY,
+    CACHE_GET_MAX_CAPACITY,
+    CACHE_GET_SIZE,
+    CACHE_GET_REQUESTED_CAP,
+    CACHE_GET_CAPACITY,
+    CACHE_GET_MTMODE,
+};
+
+
+struct VideoInfo {
+    int width;
+    int height;
+    unsigned fps_numerator;
+    unsigned fps_denominator;
+    int num_frames;
+    int pixel_type;
+    int audio_samples_per_second;
+    int sample_type;
+    int64_t num_audio_samples;
+    int nchannels;
+    int image_type;
+
+    enum {
+        CS_UNKNOWN = 0,
+        CS_BGR24, CS_BGR32, CS_YUY2,
+        CS_YV24, CS_YV16, CS_YV12, CS_I420, CS_YV411, CS_Y8,
+        CS_YUV444P10, CS_YUV444P12, CS_YUV444P14, CS_YUV444P16,
+        CS_YUV422P10, CS_YUV422P12, CS_YUV422P14, CS_YUV422P16,
+        CS_YUV420P10, CS_YUV420P12, CS_YUV420P14, CS_YUV420P16,
+        CS_Y10, CS_Y12, CS_Y14, CS_Y16,
+        CS_RGBP, CS_RGBP10, CS_RGBP12, CS_RGBP14, CS_RGBP16,
+        CS_YUVA444,
+        CS_RGBAP, CS_RGBAP10, CS_RGBAP12, CS_RGBAP14, CS_RGBAP16,
+        CS_IYUV = CS_I420,
+    };
+
+    enum {
+        IT_BFF = 1 << 0,
+        IT_TFF = 1 << 1,
+        IT_FIELDBASED = 1 << 2,
+    };
+
+    bool IsRGB() const;
+    bool IsYUY2() const;
+    bool IsY() const;
+    bool IsPlanar() const;
+    bool IsPlanarRGB() const;
+    bool IsPlanarRGBA() const;
+    bool IsYUVA() const;
+    bool IsTFF() const;
+    bool IsBFF() const;
+    int NumComponents() const;
+    int ComponentSize() const;
+    int BitsPerComponent() const;
+    int BitsPerPixel() const;
+    int GetPlaneWidthSubsampling(int plane) const;
+    int GetPlaneHeightSubsampling(int plane) const;
+    int BytesPerChannelSample() const;
+    int BytesPerAudioSample() const;
+    void SetFPS(unsigned numerator, unsigned denominator);
+    void SetFieldBased(bool isfieldbased);
+};
+
+
+class VideoFrame {
+    std::atomic<int> refcount;
+    uint8_t* data;
+    size_t size;
+    int offset[4];
+    int pitch[4];
+    int rowSize[4];
+    int height[4];
+
+    friend class PVideoFrame;
+    friend VideoFrame* new_video_frame(const VideoInfo& vi, int align);
+    friend void release_video_frame(VideoFrame* frame);
+    static int index(int plane);
+
+public:
+    int GetPitch(int plane = 0) const { return pitch[index(plane)]; }
+    int GetRowSize(int plane = 0) const { return rowSize[index(plane)]; }
+    int GetHeight(int plane = 0) const { return height[index(plane)]; }
+    const uint8_t* GetReadPtr(int plane = 0) const
+    {
+        return data + offset[index(plane)];
+    }
+    uint8_t* GetWritePtr(int plane = 0) const
+    {
+        return data + offset[index(plane)];
+    }
+};
+
+
+class PVideoFrame {
+    VideoFrame* p;
+
+    void release();
+
+public:
+    PVideoFrame() : p(nullptr) {}
+    PVideoFrame(VideoFrame* f) : p(f) { if (p) ++p->refcount; }
+    PVideoFrame(const PVideoFrame& o) : p(o.p) { if (p) ++p->refcount; }
+    ~PVideoFrame() { release(); }
+    PVideoFrame& operator=(const PVideoFrame& o);
+
+    VideoFrame* operator->() const { return p; }
+    operator void*() const { return p; }
+};
+
+
+class IScriptEnvironment;
+
+
+class IClip {
+    std::atomic<int> refcount;
+    friend class PClip;
+
+public:
+    IClip() : refcount(0) {}
+    virtual ~IClip() {}
+
+    virtual int __stdcall GetVersion() { return AVISYNTH_INTERFACE_VERSION; }
+    virtual PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env) = 0;
+    virtual bool __stdcall GetParity(int n) = 0;
+    virtual void __stdcall GetAudio(void* buf, int64_t start, int64_t count,
+                                    IScriptEnvironment* env) = 0;
+    virtual int __stdcall SetCacheHints(int cachehints, int frame_range) = 0;
+    virtual const VideoInfo& __stdcall GetVideoInfo() = 0;
+};
+
+
+class PClip {
+    IClip* p;
+
+    void release();
+
+public:
+    PClip() : p(nullptr) {}
+    PClip(IClip* c) : p(c) { if (p) ++p->refcount; }
+    PClip(const PClip& o) : p(o.p) { if (p) ++p->refcount; }
+    ~PClip() { release(); }
+    PClip& operator=(const PClip& o);
+
+    IClip* operator->() const { return p; }
+    operator void*() const { return p; }
+};
+
+
+class GenericVideoFilter : public IClip {
+protected:
+    PClip child;
+    VideoInfo vi;
+
+public:
+    GenericVideoFilter(const PClip& c) : child(c), vi(c->GetVideoInfo()) {}
+
+    PVideoFrame __stdcall GetFrame(int n, IScriptEnvironment* env) override
+    {
+        return child->GetFrame(n, env);
+    }
+    bool __stdcall GetParity(int n) override { return child->GetParity(n); }
+    void __stdcall GetAudio(void* buf, int64_t start, int64_t count,
+                            IScriptEnvironment* env) override
+    {
+        child->GetAudio(buf, start, count, env);
+    }
+    int __stdcall SetCacheHints(int cachehints, int frame_range) override
+    {
+        return 0;
+    }
+    const VideoInfo& __stdcall GetVideoInfo() override { return vi; }
+};
+
+
+class AVSValue {
+    char type;  // 'v'oid, 'c'lip, 'b'ool, 'i'nt, 'f'loat, 's'tring, 'a'rray
+    short arraySize;
+    union {
+        bool boolean;
+        int integer;
+        float floating_pt;
+        const char* string;
+        const AVSValue* array;
+    };
+    PClip clip;
+
+public:
+    AVSValue() : type('v'), arraySize(0), integer(0) {}
+    AVSValue(IClip* c) : type('c'), arraySize(0), integer(0), clip(c) {}
+    AVSValue(const PClip& c) : type('c'), arraySize(0), integer(0), clip(c) {}
+    AVSValue(bool b) : type('b'), arraySize(0), boolean(b) {}
+    AVSValue(int i) : type('i'), arraySize(0), integer(i) {}
+    AVSValue(float f) : type('f'), arraySize(0), floating_pt(f) {}
+    AVSValue(double f) : type('f'), arraySize(0), floating_pt(float(f)) {}
+    AVSValue(const char* s) : type('s'), arraySize(0), string(s) {}
+    AVSValue(const AVSValue* a, int size) :
+        type('a'), arraySize(static_cast<short>(size)), array(a) {}
+
+    bool Defined() const { return type != 'v'; }
+    bool IsClip() const { return type == 'c'; }
+    bool IsBool() const { return type == 'b'; }
+    bool IsInt() const { return type == 'i'; }
+    bool IsFloat() const { return type == 'f' || type == 'i'; }
+    bool IsString() const { return type == 's'; }
+    bool IsArray() const { return type == 'a'; }
+
+    PClip AsClip() const { return IsClip() ? clip : PClip(); }
+    bool AsBool(bool def) const { return IsBool() ? boolean : def; }
+    int AsInt(int def) const { return IsInt() ? integer : def; }
+    double AsFloat(float def) const
+    {
+        return type == 'f' ? floating_pt : IsInt() ? integer : def;
+    }
+    const char* AsString(const char* def = nullptr) const
+    {
+        return IsString() ? string : def;
+    }
+
+    int ArraySize() const { return IsArray() ? arraySize : 1; }
+    const AVSValue& operator[](int index) const;
+};
+
+
+typedef AVSValue (__cdecl *apply_func_t)(AVSValue args, void* user_data,
+                                         IScriptEnvironment* env);
+
+
+class IScriptEnvironment {
+public:
+    virtual ~IScriptEnvironment() {}
+
+    virtual int __stdcall GetCPUFlags() = 0;
+    virtual void ThrowError(const char* fmt, ...) = 0;
+    virtual void __stdcall AddFunction(const char* name, const char* params,
+                                       apply_func_t apply,
+                                       void* user_data) = 0;
+    virtual bool __stdcall FunctionExists(const char* name) = 0;
+    virtual bool __stdcall SetGlobalVar(const char* name,
+                                        const AVSValue& val) = 0;
+    virtual AVSValue __stdcall Invoke(const char* name, const AVSValue args,
+                                      const char* const* arg_names = 0) = 0;
+    virtual PVideoFrame __stdcall NewVideoFrame(const VideoInfo& vi,
+                                                int align = 64) = 0;
+    virtual void __stdcall ApplyMessage(PVideoFrame* frame,
+                                        const VideoInfo& vi,
+                                        const char* message, int size,
+                                        int textcolor, int halocolor,
+                                        int bgcolor) = 0;
+};
+
+
+class IScriptEnvironment2 : public IScriptEnvironment {
+public:
+    virtual bool __stdcall SetFilterMTMode(const char* filter, MtMode mode,
+                                           bool force) = 0;
+};
+
+
+struct AVS_Linkage;
+
+IScriptEnvironment2* __stdcall CreateScriptEnvironment2(
+    int version = AVISYNTH_INTERFACE_VERSION);
+
+#endif //RAWSOURCE_COMPAT_AVISYNTH_H
@@ -0,0 +1,430 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <strings.h>
+#include <avisynth.h>
+#include <malloc.h>
+
+
+/*
+  A minimal Avisynth: colorspaces, frames and function calls by name.
+  Enough to load RawSource and call GetFrame() like a script does.
+*/
+
+struct colorspace {
+    int planes;         // 0 for interleaved
+    int bytes;          // per component
+    int bits;
+    int ssw;            // chroma subsampling (log2)
+    int ssh;
+    int packedBpp;      // bits per pixel of interleaved formats
+    bool rgb;
+};
+
+
+static const colorspace& get_colorspace(int pixel_type)
+{
+    static const colorspace unknown = {0, 1, 8, 0, 0, 0, false};
+    static const std::unordered_map<int, colorspace> table = {
+        {VideoInfo::CS_BGR24,       {0, 1,  8, 0, 0, 24, true }},
+        {VideoInfo::CS_BGR32,       {0, 1,  8, 0, 0, 32, true }},
+        {VideoInfo::CS_YUY2,        {0, 1,  8, 1, 0, 16, false}},
+        {VideoInfo::CS_YV24,        {3, 1,  8, 0, 0,  0, false}},
+        {VideoInfo::CS_YV16,        {3, 1,  8, 1, 0,  0, false}},
+        {VideoInfo::CS_YV12,        {3, 1,  8, 1, 1,  0, false}},
+        {VideoInfo::CS_I420,        {3, 1,  8, 1, 1,  0, false}},
+        {VideoInfo::CS_YV411,       {3, 1,  8, 2, 0,  0, false}},
+        {VideoInfo::CS_Y8,          {1, 1,  8, 0, 0,  0, false}},
+        {VideoInfo::CS_YUV444P10,   {3, 2, 10, 0, 0,  0, false}},
+        {VideoInfo::CS_YUV444P12,   {3, 2, 12, 0, 0,  0, false}},
+        {VideoInfo::CS_YUV444P14,   {3, 2, 14, 0, 0,  0, false}},
+        {VideoInfo::CS_YUV444P16,   {3, 2, 16, 0, 0,  0, false}},
+        {VideoInfo::CS_YUV422P10,   {3, 2, 10, 1, 0,  0, false}},
+        {VideoInfo::CS_YUV422P12,   {3, 2, 12, 1, 0,  0, false}},
+        {VideoInfo::CS_YUV422P14,   {3, 2, 14, 1, 0,  0, false}},
+        {VideoInfo::CS_YUV422P16,   {3, 2, 16, 1, 0,  0, false}},
+        {VideoInfo::CS_YUV420P10,   {3, 2, 10, 1, 1,  0, false}},
+        {VideoInfo::CS_YUV420P12,   {3, 2, 12, 1, 1,  0, false}},
+        {VideoInfo::CS_YUV420P14,   {3, 2, 14, 1, 1,  0, false}},
+        {VideoInfo::CS_YUV420P16,   {3, 2, 16, 1, 1,  0, false}},
+        {VideoInfo::CS_Y10,         {1, 2, 10, 0, 0,  0, false}},
+        {VideoInfo::CS_Y12,         {1, 2, 12, 0, 0,  0, false}},
+        {VideoInfo::CS_Y14,         {1, 2, 14, 0, 0,  0, false}},
+        {VideoInfo::CS_Y16,         {1, 2, 16, 0, 0,  0, false}},
+        {VideoInfo::CS_RGBP,        {3, 1,  8, 0, 0,  0, true }},
+        {VideoInfo::CS_RGBP10,      {3, 2, 10, 0, 0,  0, true }},
+        {VideoInfo::CS_RGBP12,      {3, 2, 12, 0, 0,  0, true }},
+        {VideoInfo::CS_RGBP14,      {3, 2, 14, 0, 0,  0, true }},
+        {VideoInfo::CS_RGBP16,      {3, 2, 16, 0, 0,  0, true }},
+        {VideoInfo::CS_YUVA444,     {4, 1,  8, 0, 0,  0, false}},
+        {VideoInfo::CS_RGBAP,       {4, 1,  8, 0, 0,  0, true }},
+        {VideoInfo::CS_RGBAP10,     {4, 2, 10, 0, 0,  0, true }},
+        {VideoInfo::CS_RGBAP12,     {4, 2, 12, 0, 0,  0, true }},
+        {VideoInfo::CS_RGBAP14,     {4, 2, 14, 0, 0,  0, true }},
+        {VideoInfo::CS_RGBAP16,     {4, 2, 16, 0, 0,  0, true }},
+    };
+    auto it = table.find(pixel_type);
+    return it == table.end() ? unknown : it->second;
+}
+
+
+bool VideoInfo::IsRGB() const { return get_colorspace(pixel_type).rgb; }
+bool VideoInfo::IsYUY2() const { return pixel_type == CS_YUY2; }
+bool VideoInfo::IsY() const { return get_colorspace(pixel_type).planes == 1; }
+bool VideoInfo::IsPlanar() const { return get_colorspace(pixel_type).planes > 0; }
+bool VideoInfo::IsPlanarRGB() const { return NumComponents() == 3 && IsPlanar() && IsRGB(); }
+bool VideoInfo::IsPlanarRGBA() const { return NumComponents() == 4 && IsPlanar() && IsRGB(); }
+bool VideoInfo::IsYUVA() const { return NumComponents() == 4 && IsPlanar() && !IsRGB(); }
+bool VideoInfo::IsTFF() const { return (image_type & IT_TFF) != 0; }
+bool VideoInfo::IsBFF() const { return (image_type & IT_BFF) != 0; }
+int VideoInfo::ComponentSize() const { return get_colorspace(pixel_type).bytes; }
+int VideoInfo::BitsPerComponent() const { return get_colorspace(pixel_type).bits; }
+
+
+int VideoInfo::NumComponents() const
+{
+    const colorspace& cs = get_colorspace(pixel_type);
+    return cs.planes > 0 ? cs.planes : pixel_type == CS_BGR32 ? 4 : 3;
+}
+
+
+int VideoInfo::BitsPerPixel() const
+{
+    const colorspace& cs = get_colorspace(pixel_type);
+    if (cs.planes == 0) {
+        return cs.packedBpp;
+    }
+    const int luma = cs.bytes * 8;
+    if (cs.planes == 1) {
+        return luma;
+    }
+    return luma + (luma * 2 >> (cs.ssw + cs.ssh)) + (cs.planes == 4 ? luma : 0);
+}
+
+
+int VideoInfo::GetPlaneWidthSubsampling(int plane) const
+{
+    return plane == PLANAR_U || plane == PLANAR_V
+           ? get_colorspace(pixel_type).ssw : 0;
+}
+
+
+int VideoInfo::GetPlaneHeightSubsampling(int plane) const
+{
+    return plane == PLANAR_U || plane == PLANAR_V
+           ? get_colorspace(pixel_type).ssh : 0;
+}
+
+
+int VideoInfo::BytesPerChannelSample() const
+{
+    switch (sample_type) {
+    case SAMPLE_INT8:
+        return 1;
+    case SAMPLE_INT16:
+        return 2;
+    case SAMPLE_INT24:
+        return 3;
+    default:
+        return 4;
+    }
+}
+
+
+int VideoInfo::BytesPerAudioSample() const
+{
+    return nchannels * BytesPerChannelSample();
+}
+
+
+void VideoInfo::SetFPS(unsigned numerator, unsigned denominator)
+{
+    fps_numerator = numerator;
+    fps_denominator = denominator;
+}
+
+
+void VideoInfo::SetFieldBased(bool isfieldbased)
+{
+    if (isfieldbased) {
+        image_type |= IT_FIELDBASED;
+    } else {
+        image_type &= ~IT_FIELDBASED;
+    }
+}
+
+
+// planes of planar RGB are G, B, R like in Avisynth+.
+int VideoFrame::index(int plane)
+{
+    switch (plane) {
+    case PLANAR_U:
+    case PLANAR_B:
+        return 1;
+    case PLANAR_V:
+    case PLANAR_R:
+        return 2;
+    case PLANAR_A:
+        return 3;
+    default:
+        return 0;
+    }
+}
+
+
+/*
+  Released frames are kept for reuse like the frame cache of Avisynth
+  does, so the benchmark does not measure the allocator.
+*/
+static std::mutex pool_mtx;
+static std::vector<VideoFrame*> frame_pool;
+
+
+VideoFrame* new_video_frame(const VideoInfo& vi, int align)
+{
+    const colorspace& cs = get_colorspace(vi.pixel_type);
+    int rows[4] = {};
+    int heights[4] = {};
+    if (cs.planes == 0) {
+        rows[0] = vi.width * cs.packedBpp / 8;
+        heights[0] = vi.height;
+    } else {
+        for (int i = 0; i < cs.planes; ++i) {
+            const bool chroma = i > 0 && i < 3 && !cs.rgb;
+            rows[i] = (vi.width >> (chroma ? cs.ssw : 0)) * cs.bytes;
+            heights[i] = vi.height >> (chroma ? cs.ssh : 0);
+        }
+    }
+
+    int pitches[4];
+    int offsets[4];
+    size_t size = 0;
+    for (int i = 0; i < 4; ++i) {
+        pitches[i] = (rows[i] + align - 1) / align * align;
+        offsets[i] = static_cast<int>(size);
+        size += static_cast<size_t>(pitches[i]) * heights[i];
+    }
+
+    VideoFrame* frame = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(pool_mtx);
+        for (size_t i = 0; i < frame_pool.size(); ++i) {
+            if (frame_pool[i]->size == size) {
+                frame = frame_pool[i];
+                frame_pool.erase(frame_pool.begin() + i);
+                break;
+            }
+        }
+    }
+    if (!frame) {
+        frame = new VideoFrame;
+        frame->data = static_cast<uint8_t*>(_aligned_malloc(size, align));
+        frame->size = size;
+        if (!frame->data) {
+            delete frame;
+            throw std::runtime_error("out of memory.");
+        }
+    }
+
+    frame->refcount = 0;
+    for (int i = 0; i < 4; ++i) {
+        frame->offset[i] = offsets[i];
+        frame->pitch[i] = pitches[i];
+        frame->rowSize[i] = rows[i];
+        frame->height[i] = heights[i];
+    }
+    return frame;
+}
+
+
+void release_video_frame(VideoFrame* frame)
+{
+    std::lock_guard<std::mutex> lock(pool_mtx);
+    frame_pool.push_back(frame);
+}
+
+
+void PVideoFrame::release()
+{
+    if (p && --p->refcount == 0) {
+        release_video_frame(p);
+    }
+    p = nullptr;
+}
+
+
+PVideoFrame& PVideoFrame::operator=(const PVideoFrame& o)
+{
+    if (o.p) {
+        ++o.p->refcount;
+    }
+    release();
+    p = o.p;
+    return *this;
+}
+
+
+void PClip::release()
+{
+    if (p && --p->refcount == 0) {
+        delete p;
+    }
+    p = nullptr;
+}
+
+
+PClip& PClip::operator=(const PClip& o)
+{
+    if (o.p) {
+        ++o.p->refcount;
+    }
+    release();
+    p = o.p;
+    return *this;
+}
+
+
+const AVSValue& AVSValue::operator[](int index) const
+{
+    static const AVSValue undefined;
+    if (!IsArray()) {
+        return index == 0 ? *this : undefined;
+    }
+    return index < arraySize ? array[index] : undefined;
+}
+
+
+class HostEnvironment : public IScriptEnvironment2 {
+
+    struct function {
+        std::string params;
+        apply_func_t apply;
+        void* userData;
+    };
+
+    std::unordered_map<std::string, function> functions;
+
+public:
+    int __stdcall GetCPUFlags() override { return 0; }
+
+    void ThrowError(const char* fmt, ...) override
+    {
+        char msg[1024];
+        va_list args;
+        va_start(args, fmt);
+        vsnprintf(msg, sizeof(msg), fmt, args);
+        va_end(args);
+        throw std::runtime_error(msg);
+    }
+
+    void __stdcall AddFunction(const char* name, const char* params,
+                               apply_func_t apply, void* user_data) override
+    {
+        functions[name] = {params, apply, user_data};
+    }
+
+    bool __stdcall FunctionExists(const char* name) override
+    {
+        return functions.count(name) > 0;
+    }
+
+    // nothing reads script variables here.
+    bool __stdcall SetGlobalVar(const char* name, const AVSValue& val) override
+    {
+        return true;
+    }
+
+    AVSValue __stdcall Invoke(const char* name, const AVSValue args,
+                              const char* const* arg_names) override;
+
+    PVideoFrame __stdcall NewVideoFrame(const VideoInfo& vi,
+                                        int align) override
+    {
+        return PVideoFrame(new_video_frame(vi, align));
+    }
+
+    void __stdcall ApplyMessage(PVideoFrame* frame, const VideoInfo& vi,
+                                const char* message, int size, int textcolor,
+                                int halocolor, int bgcolor) override {}
+
+    bool __stdcall SetFilterMTMode(const char* filter, MtMode mode,
+                                   bool force) override
+    {
+        return true;
+    }
+};
+
+
+/*
+  Calls a function like a script does. Unnamed arguments are taken in
+  order, named ones (arg_names[i] != nullptr) go to the parameter of that
+  name, e.g. "[width]i" of the params string given to AddFunction().
+*/
+AVSValue __stdcall HostEnvironment::Invoke(const char* name,
+                                           const AVSValue args,
+                                           const char* const* arg_names)
+{
+    auto it = functions.find(name);
+    if (it == functions.end()) {
+        ThrowError("%s: no such function.", name);
+    }
+
+    std::vector<std::string> params;
+    for (const char* p = it->second.params.c_str(); *p; ) {
+        std::string param;
+        if (*p == '[') {
+            const char* end = strchr(p, ']');
+            param.assign(p + 1, end);
+            p = end + 1;
+        }
+        params.push_back(param);
+        ++p;    // type
+        while (*p == '*' || *p == '+') ++p;
+    }
+
+    std::vector<AVSValue> values(params.size());
+    for (int i = 0, next = 0; i < args.ArraySize(); ++i) {
+        int pos = next++;
+        if (arg_names && arg_names[i]) {
+            pos = -1;
+            for (size_t j = 0; j < params.size(); ++j) {
+                if (!strcasecmp(params[j].c_str(), arg_names[i])) {
+                    pos = static_cast<int>(j);
+                }
+            }
+            if (pos < 0) {
+                ThrowError("%s does not have a named argument \"%s\".", name,
+                           arg_names[i]);
+            }
+        }
+        if (pos >= static_cast<int>(values.size())) {
+            ThrowError("%s: too many arguments.", name);
+        }
+        values[pos] = args[i];
+    }
+
+    return it->second.apply(
+        AVSValue(values.data(), static_cast<int>(values.size())),
+        it->second.userData, this);
+}
+
+
+IScriptEnvironment2* __stdcall CreateScriptEnvironment2(int version)
+{
+    return new HostEnvironment;
+}
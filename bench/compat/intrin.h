@@ -0,0 +1,40 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+// the cpuid intrinsics of MSVC on top of the ones of GCC/clang.
+#ifndef RAWSOURCE_COMPAT_INTRIN_H
+#define RAWSOURCE_COMPAT_INTRIN_H
+
+
+#include <cpuid.h>
+#include <immintrin.h>
+
+#undef __cpuid
+
+static inline void __cpuid(int regs[4], int leaf)
+{
+    __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+}
+
+#ifndef __cpuidex
+#define __cpuidex(regs, leaf, subleaf) \
+    __cpuid_count(leaf, subleaf, (regs)[0], (regs)[1], (regs)[2], (regs)[3])
+#endif
+
+// without -mxsave, which the generic sources are not built with.
+#define _xgetbv rawsource_xgetbv
+static inline unsigned long long rawsource_xgetbv(unsigned index)
+{
+    unsigned eax, edx;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+}
+
+#endif //RAWSOURCE_COMPAT_INTRIN_H
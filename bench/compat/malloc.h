@@ -0,0 +1,21 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+// _aligned_malloc() of the MSVC runtime, implemented in win32_posix.cpp.
+#ifndef RAWSOURCE_COMPAT_MALLOC_H
+#define RAWSOURCE_COMPAT_MALLOC_H
+
+
+#include_next <malloc.h>
+
+void* _aligned_malloc(size_t size, size_t alignment);
+void _aligned_free(void* p);
+
+#endif //RAWSOURCE_COMPAT_MALLOC_H
@@ -0,0 +1,39 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+/*
+  Included before every source when building with GCC/clang: the MSVC
+  keywords and CRT names which RawSource uses.
+*/
+#ifndef RAWSOURCE_COMPAT_MSVC_H
+#define RAWSOURCE_COMPAT_MSVC_H
+
+
+#include <cstring>
+#include <strings.h>
+
+#define __stdcall
+#define __cdecl
+#define __declspec(x)
+
+static inline int stricmp(const char* a, const char* b)
+{
+    return strcasecmp(a, b);
+}
+
+static inline int strnicmp(const char* a, const char* b, size_t n)
+{
+    return strncasecmp(a, b, n);
+}
+
+// glibc declares rindex(), which hides struct rindex of common.h.
+#define rindex rawsource_rindex
+
+#endif //RAWSOURCE_COMPAT_MSVC_H
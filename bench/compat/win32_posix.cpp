@@ -0,0 +1,442 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <windows.h>
+#include <malloc.h>
+
+
+/*
+  A HANDLE points to one of these. Events are never waited on, since
+  every read is complete when ReadFile() returns.
+*/
+struct posix_handle {
+    enum kind_t { FILE_HANDLE, MAPPING_HANDLE, EVENT_HANDLE, FIND_HANDLE };
+    kind_t kind;
+    int fd;
+    DIR* dir;
+    std::string path;
+};
+
+static thread_local DWORD last_error = 0;
+
+static std::mutex views_mtx;
+static std::unordered_map<const void*, size_t> views;
+
+
+static posix_handle* to_handle(HANDLE h) noexcept
+{
+    return reinterpret_cast<posix_handle*>(h);
+}
+
+
+static BOOL fail(int err) noexcept
+{
+    last_error = static_cast<DWORD>(err);
+    return FALSE;
+}
+
+
+static void to_filetime(const timespec& t, FILETIME& ft) noexcept
+{
+    const uint64_t v = static_cast<uint64_t>(t.tv_sec) * 10000000
+                       + t.tv_nsec / 100;
+    ft.dwLowDateTime = static_cast<DWORD>(v & 0xFFFFFFFF);
+    ft.dwHighDateTime = static_cast<DWORD>(v >> 32);
+}
+
+
+void* _aligned_malloc(size_t size, size_t alignment)
+{
+    void* p = nullptr;
+    if (alignment < sizeof(void*)) {
+        alignment = sizeof(void*);
+    }
+    if (posix_memalign(&p, alignment, size ? size : 1) != 0) {
+        return nullptr;
+    }
+    return p;
+}
+
+
+void _aligned_free(void* p)
+{
+    free(p);
+}
+
+
+// FILE_FLAG_NO_BUFFERING is O_DIRECT. file systems without it (tmpfs)
+// are opened buffered.
+HANDLE CreateFile(const char* name, DWORD access, DWORD share, void* sa,
+                  DWORD disposition, DWORD flags, HANDLE tmpl)
+{
+    int oflags = access & GENERIC_WRITE ? O_RDWR : O_RDONLY;
+    if (disposition == CREATE_ALWAYS) {
+        oflags |= O_CREAT | O_TRUNC;
+    }
+    int fd = -1;
+    if (flags & FILE_FLAG_NO_BUFFERING) {
+        fd = open(name, oflags | O_DIRECT, 0644);
+    }
+    if (fd < 0) {
+        fd = open(name, oflags, 0644);
+    }
+    if (fd < 0) {
+        fail(errno);
+        return INVALID_HANDLE_VALUE;
+    }
+    return new posix_handle{posix_handle::FILE_HANDLE, fd, nullptr, name};
+}
+
+
+BOOL ReadFile(HANDLE file, void* buff, DWORD size, DWORD* read,
+              OVERLAPPED* ov)
+{
+    const int fd = to_handle(file)->fd;
+    off_t pos = ov ? (static_cast<off_t>(ov->OffsetHigh) << 32) | ov->Offset
+                   : lseek(fd, 0, SEEK_CUR);
+    size_t done = 0;
+    while (done < size) {
+        ssize_t r = pread(fd, static_cast<uint8_t*>(buff) + done,
+                          size - done, pos + done);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r < 0 && done == 0) {
+            return fail(errno);
+        }
+        if (r <= 0) {
+            // the end of an O_DIRECT file is not aligned.
+            break;
+        }
+        done += r;
+    }
+    if (!ov) {
+        lseek(fd, pos + done, SEEK_SET);
+    } else {
+        ov->InternalHigh = done;
+    }
+    if (read) {
+        *read = static_cast<DWORD>(done);
+    }
+    return TRUE;
+}
+
+
+BOOL WriteFile(HANDLE file, const void* buff, DWORD size, DWORD* written,
+               OVERLAPPED* ov)
+{
+    const int fd = to_handle(file)->fd;
+    size_t done = 0;
+    while (done < size) {
+        ssize_t r = ov
+            ? pwrite(fd, static_cast<const uint8_t*>(buff) + done,
+                     size - done, ((static_cast<off_t>(ov->OffsetHigh) << 32)
+                                   | ov->Offset) + done)
+            : write(fd, static_cast<const uint8_t*>(buff) + done, size - done);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r < 0) {
+            return fail(errno);
+        }
+        done += r;
+    }
+    if (ov) {
+        ov->InternalHigh = done;
+    }
+    if (written) {
+        *written = static_cast<DWORD>(done);
+    }
+    return TRUE;
+}
+
+
+BOOL GetOverlappedResult(HANDLE file, OVERLAPPED* ov, DWORD* transferred,
+                         BOOL wait)
+{
+    *transferred = static_cast<DWORD>(ov->InternalHigh);
+    return TRUE;
+}
+
+
+BOOL GetFileSizeEx(HANDLE file, LARGE_INTEGER* size)
+{
+    struct stat st;
+    if (fstat(to_handle(file)->fd, &st) != 0) {
+        return fail(errno);
+    }
+    size->QuadPart = st.st_size;
+    return TRUE;
+}
+
+
+BOOL SetFilePointerEx(HANDLE file, LARGE_INTEGER distance,
+                      LARGE_INTEGER* new_pos, DWORD method)
+{
+    const off_t pos = lseek(to_handle(file)->fd, distance.QuadPart,
+                            method == FILE_BEGIN ? SEEK_SET : SEEK_CUR);
+    if (pos < 0) {
+        return fail(errno);
+    }
+    if (new_pos) {
+        new_pos->QuadPart = pos;
+    }
+    return TRUE;
+}
+
+
+// the file ends at the current position, like after SetFilePointerEx().
+BOOL SetEndOfFile(HANDLE file)
+{
+    const int fd = to_handle(file)->fd;
+    const off_t pos = lseek(fd, 0, SEEK_CUR);
+    return pos >= 0 && ftruncate(fd, pos) == 0 ? TRUE : fail(errno);
+}
+
+
+BOOL CloseHandle(HANDLE h)
+{
+    posix_handle* ph = to_handle(h);
+    if (!ph || h == INVALID_HANDLE_VALUE) {
+        return FALSE;
+    }
+    if (ph->kind == posix_handle::FILE_HANDLE) {
+        close(ph->fd);
+    }
+    delete ph;
+    return TRUE;
+}
+
+
+DWORD GetLastError()
+{
+    return last_error;
+}
+
+
+HANDLE CreateEvent(void* sa, BOOL manual_reset, BOOL initial,
+                   const char* name)
+{
+    return new posix_handle{posix_handle::EVENT_HANDLE, -1, nullptr, ""};
+}
+
+
+HANDLE CreateFileMapping(HANDLE file, void* sa, DWORD protect,
+                         DWORD size_high, DWORD size_low, const char* name)
+{
+    return new posix_handle{posix_handle::MAPPING_HANDLE, to_handle(file)->fd,
+                            nullptr, ""};
+}
+
+
+LPVOID MapViewOfFile(HANDLE mapping, DWORD access, DWORD offset_high,
+                     DWORD offset_low, SIZE_T size)
+{
+    const int fd = to_handle(mapping)->fd;
+    const off_t offset = (static_cast<off_t>(offset_high) << 32) | offset_low;
+    if (size == 0) {
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= offset) {
+            fail(errno);
+            return nullptr;
+        }
+        size = static_cast<SIZE_T>(st.st_size - offset);
+    }
+    void* p = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, offset);
+    if (p == MAP_FAILED) {
+        fail(errno);
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(views_mtx);
+    views[p] = size;
+    return p;
+}
+
+
+BOOL UnmapViewOfFile(const void* view)
+{
+    size_t size;
+    {
+        std::lock_guard<std::mutex> lock(views_mtx);
+        auto it = views.find(view);
+        if (it == views.end()) {
+            return FALSE;
+        }
+        size = it->second;
+        views.erase(it);
+    }
+    return munmap(const_cast<void*>(view), size) == 0;
+}
+
+
+// unlocking pages which are not locked takes them out of the working set.
+BOOL VirtualUnlock(LPVOID address, SIZE_T size)
+{
+    madvise(address, size, MADV_DONTNEED);
+    return fail(ERROR_NOT_LOCKED);
+}
+
+
+void GetSystemInfo(SYSTEM_INFO* si)
+{
+    si->dwPageSize = static_cast<DWORD>(sysconf(_SC_PAGESIZE));
+    si->dwAllocationGranularity = 65536;
+    si->dwNumberOfProcessors = static_cast<DWORD>(
+        sysconf(_SC_NPROCESSORS_ONLN));
+}
+
+
+HANDLE GetCurrentProcess()
+{
+    return nullptr;
+}
+
+
+// no optional kernel32 functions (e.g. PrefetchVirtualMemory) on Linux.
+HMODULE GetModuleHandle(const char* name)
+{
+    return nullptr;
+}
+
+
+FARPROC GetProcAddress(HMODULE module, const char* name)
+{
+    return nullptr;
+}
+
+
+DWORD GetTickCount()
+{
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return static_cast<DWORD>(t.tv_sec * 1000 + t.tv_nsec / 1000000);
+}
+
+
+void Sleep(DWORD ms)
+{
+    usleep(static_cast<useconds_t>(ms) * 1000);
+}
+
+
+BOOL GetFileAttributesEx(const char* name, int level, void* info)
+{
+    struct stat st;
+    if (stat(name, &st) != 0) {
+        return fail(errno);
+    }
+    auto* fa = static_cast<WIN32_FILE_ATTRIBUTE_DATA*>(info);
+    memset(fa, 0, sizeof(*fa));
+    fa->dwFileAttributes = S_ISDIR(st.st_mode) ? FILE_ATTRIBUTE_DIRECTORY
+                                               : FILE_ATTRIBUTE_NORMAL;
+    fa->nFileSizeHigh = static_cast<DWORD>(st.st_size >> 32);
+    fa->nFileSizeLow = static_cast<DWORD>(st.st_size & 0xFFFFFFFF);
+    to_filetime(st.st_mtim, fa->ftLastWriteTime);
+    return TRUE;
+}
+
+
+// O_DIRECT on Linux needs the logical block size, at most 4096.
+BOOL GetDiskFreeSpace(const char* root, DWORD* sectors_per_cluster,
+                      DWORD* bytes_per_sector, DWORD* free_clusters,
+                      DWORD* clusters)
+{
+    *sectors_per_cluster = 8;
+    *bytes_per_sector = 512;
+    *free_clusters = 0;
+    *clusters = 0;
+    return TRUE;
+}
+
+
+BOOL GetVolumePathName(const char* name, char* path, DWORD size)
+{
+    snprintf(path, size, "/");
+    return TRUE;
+}
+
+
+BOOL MoveFileEx(const char* from, const char* to, DWORD flags)
+{
+    return rename(from, to) == 0 ? TRUE : fail(errno);
+}
+
+
+BOOL DeleteFile(const char* name)
+{
+    return unlink(name) == 0 ? TRUE : fail(errno);
+}
+
+
+static bool next_entry(posix_handle* h, WIN32_FIND_DATA* data) noexcept
+{
+    while (dirent* e = readdir(h->dir)) {
+        struct stat st;
+        if (stat((h->path + e->d_name).c_str(), &st) != 0) {
+            continue;
+        }
+        memset(data, 0, sizeof(*data));
+        data->dwFileAttributes = S_ISDIR(st.st_mode) ? FILE_ATTRIBUTE_DIRECTORY
+                                                     : FILE_ATTRIBUTE_NORMAL;
+        data->nFileSizeHigh = static_cast<DWORD>(st.st_size >> 32);
+        data->nFileSizeLow = static_cast<DWORD>(st.st_size & 0xFFFFFFFF);
+        to_filetime(st.st_mtim, data->ftLastWriteTime);
+        snprintf(data->cFileName, MAX_PATH, "%s", e->d_name);
+        return true;
+    }
+    return false;
+}
+
+
+// only "<dir>*" patterns, which is what RawSource lists.
+HANDLE FindFirstFileEx(const char* pattern, int level, void* data,
+                       int search, void* filter, DWORD flags)
+{
+    std::string dir(pattern);
+    dir.erase(dir.find_last_of('*'));
+    DIR* d = opendir(dir.empty() ? "." : dir.c_str());
+    if (!d) {
+        fail(errno);
+        return INVALID_HANDLE_VALUE;
+    }
+    auto* h = new posix_handle{posix_handle::FIND_HANDLE, -1, d, dir};
+    if (!next_entry(h, static_cast<WIN32_FIND_DATA*>(data))) {
+        FindClose(h);
+        return INVALID_HANDLE_VALUE;
+    }
+    return h;
+}
+
+
+BOOL FindNextFile(HANDLE find, WIN32_FIND_DATA* data)
+{
+    return next_entry(to_handle(find), data);
+}
+
+
+BOOL FindClose(HANDLE find)
+{
+    closedir(to_handle(find)->dir);
+    delete to_handle(find);
+    return TRUE;
+}
@@ -0,0 +1,171 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+/*
+  The part of the Win32 API which RawSource uses, for building the
+  benchmark on Linux. The functions are implemented with POSIX calls in
+  win32_posix.cpp. Overlapped reads complete before ReadFile() returns.
+*/
+#ifndef RAWSOURCE_COMPAT_WINDOWS_H
+#define RAWSOURCE_COMPAT_WINDOWS_H
+
+
+#include <cstddef>
+#include <cstdint>
+
+
+#define WINAPI
+#define TRUE  1
+#define FALSE 0
+#define MAX_PATH 260
+
+typedef void* HANDLE;
+typedef void* HMODULE;
+typedef void* FARPROC;
+typedef void* LPVOID;
+typedef void* PVOID;
+typedef int BOOL;
+typedef long LONG;
+typedef unsigned long ULONG;
+typedef uint32_t DWORD;
+typedef int64_t LONGLONG;
+typedef uintptr_t ULONG_PTR;
+typedef size_t SIZE_T;
+
+#define INVALID_HANDLE_VALUE (reinterpret_cast<HANDLE>(-1))
+
+typedef union {
+    struct {
+        DWORD LowPart;
+        LONG HighPart;
+    };
+    LONGLONG QuadPart;
+} LARGE_INTEGER;
+
+typedef struct {
+    ULONG_PTR Internal;
+    ULONG_PTR InternalHigh;
+    DWORD Offset;
+    DWORD OffsetHigh;
+    HANDLE hEvent;
+} OVERLAPPED;
+
+typedef struct {
+    DWORD dwLowDateTime;
+    DWORD dwHighDateTime;
+} FILETIME;
+
+typedef struct {
+    DWORD dwFileAttributes;
+    FILETIME ftCreationTime;
+    FILETIME ftLastAccessTime;
+    FILETIME ftLastWriteTime;
+    DWORD nFileSizeHigh;
+    DWORD nFileSizeLow;
+} WIN32_FILE_ATTRIBUTE_DATA;
+
+typedef struct {
+    DWORD dwFileAttributes;
+    FILETIME ftCreationTime;
+    FILETIME ftLastAccessTime;
+    FILETIME ftLastWriteTime;
+    DWORD nFileSizeHigh;
+    DWORD nFileSizeLow;
+    DWORD dwReserved0;
+    DWORD dwReserved1;
+    char cFileName[MAX_PATH];
+    char cAlternateFileName[14];
+} WIN32_FIND_DATA;
+
+typedef struct {
+    DWORD dwPageSize;
+    DWORD dwAllocationGranularity;
+    DWORD dwNumberOfProcessors;
+} SYSTEM_INFO;
+
+enum {
+    GetFileExInfoStandard,
+};
+
+enum {
+    FindExInfoStandard,
+    FindExInfoBasic,
+};
+
+enum {
+    FindExSearchNameMatch,
+};
+
+#define GENERIC_READ                0x80000000
+#define GENERIC_WRITE               0x40000000
+#define FILE_SHARE_READ             0x00000001
+#define FILE_SHARE_WRITE            0x00000002
+#define FILE_SHARE_DELETE           0x00000004
+#define CREATE_ALWAYS               2
+#define OPEN_EXISTING               3
+#define FILE_ATTRIBUTE_DIRECTORY    0x00000010
+#define FILE_ATTRIBUTE_NORMAL       0x00000080
+#define FILE_FLAG_NO_BUFFERING      0x20000000
+#define FILE_FLAG_OVERLAPPED        0x40000000
+#define FIND_FIRST_EX_LARGE_FETCH   0x00000002
+#define PAGE_READONLY               0x02
+#define FILE_MAP_READ               0x0004
+#define MOVEFILE_REPLACE_EXISTING   0x00000001
+#define FILE_BEGIN                  0
+#define ERROR_HANDLE_EOF            38
+#define ERROR_NOT_LOCKED            158
+#define ERROR_IO_PENDING            997
+
+HANDLE CreateFile(const char* name, DWORD access, DWORD share, void* sa,
+                  DWORD disposition, DWORD flags, HANDLE tmpl);
+BOOL ReadFile(HANDLE file, void* buff, DWORD size, DWORD* read,
+              OVERLAPPED* ov);
+BOOL WriteFile(HANDLE file, const void* buff, DWORD size, DWORD* written,
+               OVERLAPPED* ov);
+BOOL GetOverlappedResult(HANDLE file, OVERLAPPED* ov, DWORD* transferred,
+                         BOOL wait);
+BOOL GetFileSizeEx(HANDLE file, LARGE_INTEGER* size);
+BOOL SetFilePointerEx(HANDLE file, LARGE_INTEGER distance,
+                      LARGE_INTEGER* new_pos, DWORD method);
+BOOL SetEndOfFile(HANDLE file);
+BOOL CloseHandle(HANDLE h);
+DWORD GetLastError();
+
+HANDLE CreateEvent(void* sa, BOOL manual_reset, BOOL initial,
+                   const char* name);
+
+HANDLE CreateFileMapping(HANDLE file, void* sa, DWORD protect,
+                         DWORD size_high, DWORD size_low, const char* name);
+LPVOID MapViewOfFile(HANDLE mapping, DWORD access, DWORD offset_high,
+                     DWORD offset_low, SIZE_T size);
+BOOL UnmapViewOfFile(const void* view);
+BOOL VirtualUnlock(LPVOID address, SIZE_T size);
+
+void GetSystemInfo(SYSTEM_INFO* si);
+HANDLE GetCurrentProcess();
+HMODULE GetModuleHandle(const char* name);
+FARPROC GetProcAddress(HMODULE module, const char* name);
+DWORD GetTickCount();
+void Sleep(DWORD ms);
+
+BOOL GetFileAttributesEx(const char* name, int level, void* info);
+BOOL GetDiskFreeSpace(const char* root, DWORD* sectors_per_cluster,
+                      DWORD* bytes_per_sector, DWORD* free_clusters,
+                      DWORD* clusters);
+BOOL GetVolumePathName(const char* name, char* path, DWORD size);
+BOOL MoveFileEx(const char* from, const char* to, DWORD flags);
+BOOL DeleteFile(const char* name);
+
+HANDLE FindFirstFileEx(const char* pattern, int level, void* data,
+                       int search, void* filter, DWORD flags);
+BOOL FindNextFile(HANDLE find, WIN32_FIND_DATA* data);
+BOOL FindClose(HANDLE find);
+
+#endif //RAWSOURCE_COMPAT_WINDOWS_H
@@ -0,0 +1,1167 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+/*
+  rawbench - measures RawSource outside of Avisynth.
+
+  Reader runs load the plugin into a small host (compat/avisynth_host.cpp)
+  and call GetFrame() of RawSource("file", ...) like a script does, for
+  each read mode, access pattern and cache state. Kernel runs call every
+  write_* kernel of pixel_formats[] on a frame which is already in memory,
+  the C version and each SIMD version the cpu can run. Writer runs pass
+  the clip through RawWrite() in the same pixel_type, with and without
+  direct, and check that the file comes out as it went in. With
+  --archive the readers also read an archive of each file, which
+  RawWrite(compress=true) makes, after checking that it gives back the
+  frames of the file. The random frames do not compress, --graphics
+  fills them with flat areas which do.
+  --verify does not measure anything. It compares the output of every
+  SIMD kernel with the one of the C kernel, at widths which leave all
+  kinds of row tails, checks that the top-down rows of MOV 'raw ' files
+  come out the right way up, and exits with 1 if any of them differs.
+*/
+
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <malloc.h>
+#include "common.h"
+
+
+extern "C" const char* __stdcall
+AvisynthPluginInit3(ise_t* env, const AVS_Linkage* const vectors);
+
+
+typedef std::chrono::steady_clock clock_type;
+
+
+struct options {
+    std::vector<std::string> formats;
+    int width = 1920;
+    int height = 1080;
+    int frames = 100;
+    int stride = 3;
+    int radius = 3;
+    int prefetch = 0;
+    int cacheMem = 0;
+    int iterations = 0;
+    std::string dir = ".";
+    std::vector<std::string> modes = {"read", "mmap", "direct"};
+    std::vector<std::string> access = {"seq", "rev", "random", "stride",
+                                          "temporal"};
+    std::vector<std::string> caches = {"hot", "cold"};
+    bool readers = true;
+    bool kernels = true;
+    bool writers = true;
+    bool archive = false;
+    bool graphics = false;
+    bool planar = false;
+    bool verify = false;
+    bool json = false;
+    bool keep = false;
+    std::string output;
+};
+
+
+struct result {
+    std::string format;
+    std::string kernel;
+    std::string mode;
+    std::string access;
+    std::string cache;
+    int width;
+    int height;
+    size_t frameBytes;
+    int frames;
+    double seconds;
+    std::vector<double> latencies;  // ms
+};
+
+
+static void usage()
+{
+    fprintf(stderr,
+        "usage: rawbench [options]\n"
+        "  --formats LIST      pixel types (default: all of pixel_formats[])\n"
+        "  --width N           frame width (1920)\n"
+        "  --height N          frame height (1080)\n"
+        "  --frames N          frames per file (100)\n"
+        "  --dir PATH          where the test files are written (.)\n"
+        "  --mode LIST         read, mmap, direct (all)\n"
+        "  --prefetch N        prefetch of RawSource (0)\n"
+        "  --cache-mem N       cache_mem of RawSource in MB (0)\n"
+        "  --access LIST       seq, rev, random, stride, temporal (all)\n"
+        "  --stride N          frame step of stride access (3)\n"
+        "  --radius N          frames on each side of temporal access (3)\n"
+        "  --cache LIST        hot, cold (both)\n"
+        "  --iterations N      calls per kernel (frames)\n"
+        "  --no-readers        only run the kernels\n"
+        "  --no-kernels        only run the readers\n"
+        "  --no-writers        do not run RawWrite\n"
+        "  --archive           also read an archive of each file\n"
+        "  --graphics          frames of flat areas instead of noise\n"
+        "  --planar-output     read packed 4:2:2 and RGB as planes (planar_output)\n"
+        "  --verify            compare the SIMD kernels with the C ones, check\n"
+        "                      the rows of MOV files and exit\n"
+        "  --format csv|json   output format (csv)\n"
+        "  --output FILE       write results to FILE instead of stdout\n"
+        "  --keep              keep the test files\n"
+        "LIST is comma separated.\n");
+}
+
+
+static std::vector<std::string> split(const std::string& s)
+{
+    std::vector<std::string> v;
+    size_t start = 0;
+    while (start <= s.size()) {
+        size_t end = s.find(',', start);
+        if (end == std::string::npos) {
+            end = s.size();
+        }
+        if (end > start) {
+            v.push_back(s.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    return v;
+}
+
+
+static bool parse_options(int argc, char** argv, options& opt)
+{
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        auto needs_value = [&] {
+            if (!v) {
+                fprintf(stderr, "rawbench: %s needs a value.\n", a.c_str());
+                return false;
+            }
+            ++i;
+            return true;
+        };
+
+        if (a == "--no-readers") {
+            opt.readers = false;
+        } else if (a == "--no-kernels") {
+            opt.kernels = false;
+        } else if (a == "--no-writers") {
+            opt.writers = false;
+        } else if (a == "--archive") {
+            opt.archive = true;
+        } else if (a == "--graphics") {
+            opt.graphics = true;
+        } else if (a == "--planar-output") {
+            opt.planar = true;
+        } else if (a == "--verify") {
+            opt.verify = true;
+        } else if (a == "--keep") {
+            opt.keep = true;
+        } else if (a == "--help" || a == "-h") {
+            return false;
+        } else if (!needs_value()) {
+            return false;
+        } else if (a == "--formats") {
+            opt.formats = split(v);
+        } else if (a == "--width") {
+            opt.width = atoi(v);
+        } else if (a == "--height") {
+            opt.height = atoi(v);
+        } else if (a == "--frames") {
+            opt.frames = atoi(v);
+        } else if (a == "--dir") {
+            opt.dir = v;
+        } else if (a == "--mode") {
+            opt.modes = split(v);
+        } else if (a == "--prefetch") {
+            opt.prefetch = atoi(v);
+        } else if (a == "--cache-mem") {
+            opt.cacheMem = atoi(v);
+        } else if (a == "--access") {
+            opt.access = split(v);
+        } else if (a == "--stride") {
+            opt.stride = atoi(v);
+        } else if (a == "--radius") {
+            opt.radius = atoi(v);
+        } else if (a == "--cache") {
+            opt.caches = split(v);
+        } else if (a == "--iterations") {
+            opt.iterations = atoi(v);
+        } else if (a == "--format") {
+            opt.json = !strcmp(v, "json");
+        } else if (a == "--output") {
+            opt.output = v;
+        } else {
+            fprintf(stderr, "rawbench: unknown option %s\n", a.c_str());
+            return false;
+        }
+    }
+
+    if (opt.width < static_cast<int>(MIN_WIDTH)
+            || opt.height < static_cast<int>(MIN_HEIGHT)
+            || opt.frames < 1 || opt.stride < 1 || opt.radius < 0) {
+        fprintf(stderr, "rawbench: invalid size, frames, stride or radius.\n");
+        return false;
+    }
+    if (opt.iterations < 1) {
+        opt.iterations = opt.frames;
+    }
+    return true;
+}
+
+
+static void fill_random(uint8_t* p, size_t size, uint64_t& state)
+{
+    for (size_t i = 0; i < size; ++i) {
+        // xorshift64, much faster than <random> for hundreds of MB.
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        p[i] = static_cast<uint8_t>(state);
+    }
+}
+
+
+// bands of one value with a little noise, like rendered graphics.
+static void fill_graphics(uint8_t* p, size_t size, int frame,
+                          uint64_t& state)
+{
+    fill_random(p, size, state);
+    for (size_t i = 0; i < size; ++i) {
+        if (p[i] >= 8) {
+            p[i] = static_cast<uint8_t>((i / 1024 + frame) * 7);
+        }
+    }
+}
+
+
+static std::string make_file(const options& opt, const char* name,
+                             size_t framesize)
+{
+    const std::string path = opt.dir + "/rawbench_" + name + ".raw";
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (!fp) {
+        throw std::runtime_error("cannot create " + path + ".");
+    }
+    std::vector<uint8_t> frame(framesize);
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < opt.frames; ++i) {
+        if (opt.graphics) {
+            fill_graphics(frame.data(), frame.size(), i, state);
+        } else {
+            fill_random(frame.data(), frame.size(), state);
+        }
+        fwrite(frame.data(), 1, frame.size(), fp);
+    }
+    fflush(fp);
+    fsync(fileno(fp));
+    fclose(fp);
+    return path;
+}
+
+
+// takes the file out of the page cache, so the next reads go to the disk.
+static void drop_cache(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+
+static std::vector<int> frame_order(const std::string& access, int frames,
+                                    int stride, int radius)
+{
+    std::vector<int> order;
+    if (access == "rev") {
+        for (int n = frames - 1; n >= 0; --n) {
+            order.push_back(n);
+        }
+    } else if (access == "random") {
+        for (int n = 0; n < frames; ++n) {
+            order.push_back(n);
+        }
+        std::mt19937 rng(1);
+        std::shuffle(order.begin(), order.end(), rng);
+    } else if (access == "stride") {
+        // every frame once, in stride passes of n, n + stride, ...
+        for (int s = 0; s < stride; ++s) {
+            for (int n = s; n < frames; n += stride) {
+                order.push_back(n);
+            }
+        }
+    } else if (access == "temporal") {
+        // n - radius to n + radius for every n, like a temporal filter.
+        for (int n = 0; n < frames; ++n) {
+            for (int d = -radius; d <= radius; ++d) {
+                order.push_back(std::min(std::max(n + d, 0), frames - 1));
+            }
+        }
+    } else {
+        for (int n = 0; n < frames; ++n) {
+            order.push_back(n);
+        }
+    }
+    return order;
+}
+
+
+static result run_reader(ise_t* env, const options& opt,
+                         const std::string& path, const pixel_format& fmt,
+                         size_t framesize, const std::string& mode,
+                         const std::string& access, const std::string& cache)
+{
+    if (cache == "cold") {
+        drop_cache(path);
+    }
+
+    const AVSValue args[] = {
+        path.c_str(), opt.width, opt.height, fmt.name, mode == "mmap",
+        opt.prefetch, false, mode == "direct", opt.planar, opt.cacheMem,
+    };
+    const char* const names[] = {
+        nullptr, "width", "height", "pixel_type", "mmap", "prefetch",
+        "index_cache", "direct", "planar_output", "cache_mem",
+    };
+    PClip clip = env->Invoke("RawSource", AVSValue(args, 10), names).AsClip();
+
+    const std::vector<int> order = frame_order(access, opt.frames, opt.stride,
+                                               opt.radius);
+    if (cache == "hot") {
+        for (int n : order) {
+            clip->GetFrame(n, env);
+        }
+    }
+
+    result r = {fmt.name, "auto", mode, access, cache, opt.width, opt.height,
+                framesize, static_cast<int>(order.size()), 0.0, {}};
+    const auto start = clock_type::now();
+    for (int n : order) {
+        const auto t = clock_type::now();
+        PVideoFrame frame = clip->GetFrame(n, env);
+        r.latencies.push_back(std::chrono::duration<double, std::milli>(
+            clock_type::now() - t).count());
+    }
+    r.seconds = std::chrono::duration<double>(clock_type::now() - start)
+                .count();
+    return r;
+}
+
+
+static bool same_file(const std::string& a, const std::string& b)
+{
+    FILE* fa = fopen(a.c_str(), "rb");
+    FILE* fb = fopen(b.c_str(), "rb");
+    bool same = fa && fb;
+    std::vector<uint8_t> ba(1 << 20);
+    std::vector<uint8_t> bb(1 << 20);
+    while (same) {
+        const size_t na = fread(ba.data(), 1, ba.size(), fa);
+        const size_t nb = fread(bb.data(), 1, bb.size(), fb);
+        same = na == nb && !memcmp(ba.data(), bb.data(), na);
+        if (na == 0) {
+            break;
+        }
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
+
+// true if every row of every plane of a and b is the same.
+static bool same_frame(const PVideoFrame& a, const PVideoFrame& b,
+                       const VideoInfo& vi)
+{
+    static const int yuv[] = {PLANAR_Y, PLANAR_U, PLANAR_V, PLANAR_A};
+    static const int rgb[] = {PLANAR_G, PLANAR_B, PLANAR_R, PLANAR_A};
+    const int count = vi.IsPlanar() ? vi.NumComponents() : 1;
+    for (int i = 0; i < count; ++i) {
+        const int p = !vi.IsPlanar() ? 0 : vi.IsRGB() ? rgb[i] : yuv[i];
+        for (int y = 0; y < a->GetHeight(p); ++y) {
+            if (memcmp(a->GetReadPtr(p) + y * a->GetPitch(p),
+                       b->GetReadPtr(p) + y * b->GetPitch(p),
+                       a->GetRowSize(p))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+
+/*
+  RawWrite(RawSource(path), pixel_type) of every frame in order. The time
+  includes closing the writer, which waits for the queued frames, and the
+  latencies show how long GetFrame() was held up by the writes. The
+  source file is in the cache.
+*/
+static result run_writer(ise_t* env, const options& opt,
+                         const std::string& path, const pixel_format& fmt,
+                         size_t framesize, const std::string& mode)
+{
+    const std::string out = path + ".out";
+    const AVSValue src_args[] = {
+        path.c_str(), opt.width, opt.height, fmt.name,
+    };
+    const char* const src_names[] = {
+        nullptr, "width", "height", "pixel_type",
+    };
+    PClip clip = env->Invoke("RawSource", AVSValue(src_args, 4),
+                             src_names).AsClip();
+    for (int n = 0; n < opt.frames; ++n) {
+        clip->GetFrame(n, env);
+    }
+
+    result r = {fmt.name, "rawwrite", mode, "seq", "hot", opt.width,
+                opt.height, framesize, opt.frames, 0.0, {}};
+    const auto start = clock_type::now();
+    {
+        const AVSValue args[] = {
+            clip, out.c_str(), fmt.name, false, mode == "write_direct",
+        };
+        const char* const names[] = {
+            nullptr, nullptr, "pixel_type", "y4m", "direct",
+        };
+        PClip writer = env->Invoke("RawWrite", AVSValue(args, 5),
+                                   names).AsClip();
+        for (int n = 0; n < opt.frames; ++n) {
+            const auto t = clock_type::now();
+            PVideoFrame frame = writer->GetFrame(n, env);
+            r.latencies.push_back(std::chrono::duration<double, std::milli>(
+                clock_type::now() - t).count());
+        }
+    }
+    r.seconds = std::chrono::duration<double>(clock_type::now() - start)
+                .count();
+
+    // 16bit samples which are not plain LSB data lose their unused bits.
+    const bool lossless = !sample_needs_conversion(fmt.order[3])
+                          || (fmt.func != write_planar16
+                              && fmt.func != write_semi_planar);
+    const bool ok = !lossless || same_file(path, out);
+    remove(out.c_str());
+    if (!ok) {
+        throw std::runtime_error(std::string("RawWrite of ") + fmt.name
+                                 + " did not reproduce the source file.");
+    }
+    return r;
+}
+
+
+// RawWrite(RawSource(path), compress=true), the archive of the file.
+static std::string make_archive(ise_t* env, const options& opt,
+                                const std::string& path,
+                                const pixel_format& fmt)
+{
+    const std::string out = path + ".rsa";
+    const AVSValue src_args[] = {
+        path.c_str(), opt.width, opt.height, fmt.name,
+    };
+    const char* const src_names[] = {
+        nullptr, "width", "height", "pixel_type",
+    };
+    PClip clip = env->Invoke("RawSource", AVSValue(src_args, 4),
+                             src_names).AsClip();
+    const AVSValue args[] = {clip, out.c_str(), fmt.name, true};
+    const char* const names[] = {nullptr, nullptr, "pixel_type", "compress"};
+    PClip writer = env->Invoke("RawWrite", AVSValue(args, 4),
+                               names).AsClip();
+    for (int n = 0; n < opt.frames; ++n) {
+        writer->GetFrame(n, env);
+    }
+    return out;
+}
+
+
+/*
+  Every frame of the archive has to be the one of the raw file, read as
+  it is, cropped (by values which fit every subsampling and v210) and
+  with planar_output. Otherwise a broken archive would only look fast.
+*/
+static void check_archive(ise_t* env, const options& opt,
+                          const std::string& path,
+                          const std::string& archive,
+                          const pixel_format& fmt)
+{
+    // a size which is no multiple of the chroma subsampling leaves samples
+    // which the kernels do not write, they may differ.
+    VideoInfo vi = {};
+    vi.pixel_type = fmt.avs_pix_type;
+    if (opt.width % (1 << vi.GetPlaneWidthSubsampling(PLANAR_U)) != 0
+            || opt.height % (1 << vi.GetPlaneHeightSubsampling(PLANAR_U))
+               != 0) {
+        return;
+    }
+
+    // the cropped size is a multiple of 4 pixels and 2 rows.
+    const int c = opt.width >= 24 && opt.height >= 16 ? 4 : 0;
+    const int right = c + (opt.width - c * 4) % 4;
+    const int bottom = c + (opt.height - c * 2) % 2;
+    const struct {
+        const char* name;
+        int left, top, right, bottom;
+        bool planar;
+    } reads[] = {
+        {"plain",         0,     0, 0,     0,      false},
+        {"cropped",       c * 3, c, right, bottom, false},
+        {"planar_output", 0,     0, 0,     0,      true },
+    };
+    const char* const names[] = {
+        nullptr, "width", "height", "pixel_type", "index_cache",
+        "crop_left", "crop_top", "crop_right", "crop_bottom",
+        "planar_output",
+    };
+
+    for (const auto& r : reads) {
+        PClip clips[2];
+        const std::string* files[] = {&path, &archive};
+        for (int i = 0; i < 2; ++i) {
+            const AVSValue args[] = {
+                files[i]->c_str(), opt.width, opt.height, fmt.name, false,
+                r.left, r.top, r.right, r.bottom, r.planar,
+            };
+            clips[i] = env->Invoke("RawSource", AVSValue(args, 10),
+                                   names).AsClip();
+        }
+        const VideoInfo& rvi = clips[0]->GetVideoInfo();
+        const VideoInfo& avi = clips[1]->GetVideoInfo();
+        bool ok = avi.width == rvi.width && avi.height == rvi.height
+                  && avi.pixel_type == rvi.pixel_type
+                  && avi.num_frames == rvi.num_frames;
+        for (int n = 0; ok && n < rvi.num_frames; ++n) {
+            ok = same_frame(clips[0]->GetFrame(n, env),
+                            clips[1]->GetFrame(n, env), rvi);
+        }
+        if (!ok) {
+            throw std::runtime_error(std::string("the archive of ")
+                                     + fmt.name + " does not give back the "
+                                     "frames of the file (" + r.name + ").");
+        }
+    }
+}
+
+
+static const char* kernel_name(write_frame_t f)
+{
+    static const struct { write_frame_t func; const char* name; } names[] = {
+        {write_packed,               "packed"              },
+        {write_packed_reorder,       "packed_reorder"      },
+        {write_packed_reorder_ssse3, "packed_reorder_ssse3"},
+        {write_packed_reorder_avx2,  "packed_reorder_avx2" },
+        {write_planar,               "planar"              },
+        {write_planar16,             "planar16"            },
+        {write_planar16_sse2,        "planar16_sse2"       },
+        {write_planar16_avx2,        "planar16_avx2"       },
+        {write_semi_planar,          "semi_planar"         },
+        {write_semi_planar_sse2,     "semi_planar_sse2"    },
+        {write_semi_planar_avx2,     "semi_planar_avx2"    },
+        {write_v210,                 "v210"                },
+        {write_v210_ssse3,           "v210_ssse3"          },
+        {write_y210,                 "y210"                },
+        {write_y210_ssse3,           "y210_ssse3"          },
+        {write_rgb10,                "rgb10"               },
+        {write_rgb10_ssse3,          "rgb10_ssse3"         },
+        {write_packed422,            "packed422"           },
+        {write_packed422_ssse3,      "packed422_ssse3"     },
+        {write_packed444,            "packed444"           },
+        {write_packed444_ssse3,      "packed444_ssse3"     },
+        {write_packed444_avx2,       "packed444_avx2"      },
+        {write_packed_rgbp,          "packed_rgbp"         },
+        {write_packed_rgbp_ssse3,    "packed_rgbp_ssse3"   },
+        {write_packed_rgbp_avx2,     "packed_rgbp_avx2"    },
+    };
+    for (const auto& n : names) {
+        if (n.func == f) {
+            return n.name;
+        }
+    }
+    return "unknown";
+}
+
+
+/*
+  The C kernel, pixel type and order of fmt. With --planar-output packed
+  4:2:2 and RGB are split into planes like planar_output=true does.
+*/
+static write_frame_t kernel_of(const options& opt, const pixel_format& fmt,
+                               int& pixel_type, int* order)
+{
+    memcpy(order, fmt.order, sizeof(int) * 4);
+    pixel_type = fmt.avs_pix_type;
+    if (opt.planar && pixel_type == VideoInfo::CS_YUY2) {
+        pixel_type = VideoInfo::CS_YV16;
+        return write_packed422;
+    }
+    if (opt.planar && (pixel_type == VideoInfo::CS_BGR24
+                       || pixel_type == VideoInfo::CS_BGR32)) {
+        std::swap(order[0], order[1]);
+        pixel_type = fmt.cnt == 4 ? VideoInfo::CS_RGBAP : VideoInfo::CS_RGBP;
+        return write_packed_rgbp;
+    }
+    return fmt.func;
+}
+
+
+// every kernel of fmt which this cpu can run, the C version first.
+static std::vector<write_frame_t> kernels_of(const options& opt,
+                                             const pixel_format& fmt)
+{
+    int pixel_type;
+    int order[4];
+    const write_frame_t func = kernel_of(opt, fmt, pixel_type, order);
+    const int cpu = get_cpu_features();
+    const int levels[] = {0, cpu & ~(CPU_SSE41 | CPU_AVX2), cpu & ~CPU_AVX2,
+                          cpu};
+    std::vector<write_frame_t> v;
+    for (int level : levels) {
+        write_frame_t f = get_kernel(func, level);
+        if (std::find(v.begin(), v.end(), f) == v.end()) {
+            v.push_back(f);
+        }
+    }
+    return v;
+}
+
+
+static result run_kernel(ise_t* env, const options& opt,
+                         const pixel_format& fmt, size_t framesize,
+                         write_frame_t kernel)
+{
+    VideoInfo vi = {};
+    vi.width = opt.width;
+    vi.height = opt.height;
+    int order[4];
+    kernel_of(opt, fmt, vi.pixel_type, order);
+
+    std::vector<uint8_t> src(framesize);
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    fill_random(src.data(), src.size(), state);
+    MemoryReader rd(src.data(), 0, framesize);
+
+    std::unique_ptr<uint8_t, decltype(&_aligned_free)> buff(
+        static_cast<uint8_t*>(_aligned_malloc(framesize, 64)), _aligned_free);
+
+    PVideoFrame dst = env->NewVideoFrame(vi);
+    kernel(rd, 0, dst, buff.get(), order, fmt.cnt, env);
+
+    result r = {fmt.name, kernel_name(kernel), "memory", "seq", "hot",
+                opt.width, opt.height, framesize, opt.iterations, 0.0, {}};
+    const auto start = clock_type::now();
+    for (int i = 0; i < opt.iterations; ++i) {
+        const auto t = clock_type::now();
+        kernel(rd, 0, dst, buff.get(), order, fmt.cnt, env);
+        r.latencies.push_back(std::chrono::duration<double, std::milli>(
+            clock_type::now() - t).count());
+    }
+    r.seconds = std::chrono::duration<double>(clock_type::now() - start)
+                .count();
+    return r;
+}
+
+
+/*
+  Runs every kernel of fmt, with and without --planar-output, on one
+  random frame of each width and compares the frames with the one of the
+  C kernel. The widths are no multiples of the 16 and 32 byte steps, of
+  the 5 pixels of 24bit RGB or of the 48 pixel groups of v210, so the
+  tails of the rows are covered. Returns the number of frames which
+  differ, checked counts all compared ones.
+*/
+static int verify_kernels(ise_t* env, const options& opt,
+                          const pixel_format& fmt, int& checked)
+{
+    static const int widths[] = {
+        8, 9, 13, 17, 22, 31, 33, 47, 49, 64, 65, 95, 97, 130, 191, 258,
+        1283,
+    };
+    int mismatches = 0;
+    for (bool planar : {false, true}) {
+        options o = opt;
+        o.planar = planar;
+        VideoInfo vi = {};
+        int order[4];
+        if (kernel_of(o, fmt, vi.pixel_type, order) == fmt.func && planar) {
+            continue;   // planar_output does not change fmt.
+        }
+        const std::vector<write_frame_t> kernels = kernels_of(o, fmt);
+
+        VideoInfo src_vi = {};
+        src_vi.pixel_type = fmt.avs_pix_type;
+        src_vi.height = vi.height = 10;
+        const int step = 1 << src_vi.GetPlaneWidthSubsampling(PLANAR_U);
+        int last = 0;
+        for (int w : widths) {
+            src_vi.width = vi.width = (w + step - 1) / step * step;
+            if (vi.width == last) {
+                continue;
+            }
+            last = vi.width;
+
+            const size_t framesize = get_frame_size(src_vi, fmt);
+            std::vector<uint8_t> src(framesize);
+            uint64_t state = 0x9E3779B97F4A7C15ull + vi.width;
+            fill_random(src.data(), src.size(), state);
+            MemoryReader rd(src.data(), 0, framesize);
+            std::unique_ptr<uint8_t, decltype(&_aligned_free)> buff(
+                static_cast<uint8_t*>(_aligned_malloc(framesize, 64)),
+                _aligned_free);
+
+            PVideoFrame ref = env->NewVideoFrame(vi);
+            kernels[0](rd, 0, ref, buff.get(), order, fmt.cnt, env);
+            for (size_t k = 1; k < kernels.size(); ++k) {
+                PVideoFrame dst = env->NewVideoFrame(vi);
+                kernels[k](rd, 0, dst, buff.get(), order, fmt.cnt, env);
+                ++checked;
+                if (!same_frame(ref, dst, vi)) {
+                    fprintf(stderr, "rawbench: %s%s: %s differs from %s "
+                            "at width %d.\n", fmt.name,
+                            planar ? " (planar_output)" : "",
+                            kernel_name(kernels[k]), kernel_name(kernels[0]),
+                            vi.width);
+                    ++mismatches;
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+
+static void put_be(std::vector<uint8_t>& v, uint32_t x, int bytes)
+{
+    for (int i = bytes - 1; i >= 0; --i) {
+        v.push_back(static_cast<uint8_t>(x >> (i * 8)));
+    }
+}
+
+
+// an atom of type around payload.
+static std::vector<uint8_t> mov_atom(const char* type,
+                                     const std::vector<uint8_t>& payload)
+{
+    std::vector<uint8_t> atom;
+    put_be(atom, static_cast<uint32_t>(payload.size() + 8), 4);
+    atom.insert(atom.end(), type, type + 4);
+    atom.insert(atom.end(), payload.begin(), payload.end());
+    return atom;
+}
+
+
+static std::vector<uint8_t> mov_parent(
+    const char* type, std::initializer_list<std::vector<uint8_t>> children)
+{
+    std::vector<uint8_t> payload;
+    for (const auto& c : children) {
+        payload.insert(payload.end(), c.begin(), c.end());
+    }
+    return mov_atom(type, payload);
+}
+
+
+/*
+  Writes a QuickTime file of one 'raw ' video track, the frames in one
+  chunk of an mdat before the moov atom.
+*/
+static void write_mov(const std::string& path, int width, int height,
+                      int depth, const std::vector<uint8_t>& frames,
+                      int count)
+{
+    std::vector<uint8_t> hdlr(8);
+    hdlr.insert(hdlr.end(), {'v', 'i', 'd', 'e'});
+    hdlr.resize(hdlr.size() + 13);
+
+    std::vector<uint8_t> mdhd(12);
+    put_be(mdhd, 30000, 4);
+    put_be(mdhd, 1001 * count, 4);
+    put_be(mdhd, 0, 4);
+
+    std::vector<uint8_t> stsd(4);
+    put_be(stsd, 1, 4);
+    put_be(stsd, 86, 4);
+    stsd.insert(stsd.end(), {'r', 'a', 'w', ' '});
+    stsd.resize(stsd.size() + 6);
+    put_be(stsd, 1, 2);
+    stsd.resize(stsd.size() + 16);
+    put_be(stsd, width, 2);
+    put_be(stsd, height, 2);
+    put_be(stsd, 72 << 16, 4);
+    put_be(stsd, 72 << 16, 4);
+    put_be(stsd, 0, 4);
+    put_be(stsd, 1, 2);
+    stsd.resize(stsd.size() + 32);
+    put_be(stsd, depth, 2);
+    put_be(stsd, 0xFFFF, 2);
+
+    const uint32_t framesize = static_cast<uint32_t>(frames.size() / count);
+    std::vector<uint8_t> stts(4), stsc(4), stsz(4), stco(4);
+    put_be(stts, 1, 4);
+    put_be(stts, count, 4);
+    put_be(stts, 1001, 4);
+    put_be(stsc, 1, 4);
+    put_be(stsc, 1, 4);
+    put_be(stsc, count, 4);
+    put_be(stsc, 1, 4);
+    put_be(stsz, framesize, 4);
+    put_be(stsz, count, 4);
+    put_be(stco, 1, 4);
+    put_be(stco, 8, 4);     // right after the header of the mdat
+
+    const std::vector<uint8_t> mdat = mov_atom("mdat", frames);
+    const std::vector<uint8_t> moov = mov_parent("moov", {
+        mov_parent("trak", {
+            mov_parent("mdia", {
+                mov_atom("mdhd", mdhd), mov_atom("hdlr", hdlr),
+                mov_parent("minf", {
+                    mov_parent("stbl", {
+                        mov_atom("stsd", stsd), mov_atom("stts", stts),
+                        mov_atom("stsc", stsc), mov_atom("stsz", stsz),
+                        mov_atom("stco", stco),
+                    }),
+                }),
+            }),
+        }),
+    });
+
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (!fp) {
+        throw std::runtime_error("cannot create " + path + ".");
+    }
+    fwrite(mdat.data(), 1, mdat.size(), fp);
+    fwrite(moov.data(), 1, moov.size(), fp);
+    fclose(fp);
+}
+
+
+/*
+  The frames of a MOV file are stored top-down. 'raw ' files of 24 and
+  32bit, read with the pixel_type of their codec, have to give the top row
+  of the picture from the first row of the frame (RGB and ARGB to the
+  BGR(A) of RGB24/RGB32). Read as it is, cropped and with planar_output,
+  in each read mode, they also have to give the frames of a raw file of
+  the same frames stored bottom-up. Returns the number of frames which
+  differ, checked counts all compared ones.
+*/
+static int verify_mov(ise_t* env, const options& opt, int& checked)
+{
+    const int width = 64;
+    const int height = 36;
+    const int count = 3;
+    const struct {
+        int depth;
+        const char* pixType;
+        int src[4];     // the byte of a pixel in the file of each one in
+                        // the frame.
+    } codecs[] = {
+        {24, "RGB",  {2, 1, 0}},
+        {32, "ARGB", {3, 2, 1, 0}},
+    };
+    const struct {
+        const char* name;
+        int left, top, right, bottom;
+        bool planar;
+    } reads[] = {
+        {"plain",         0, 0, 0, 0, false},
+        {"cropped",       4, 2, 8, 4, false},
+        {"planar_output", 0, 0, 0, 0, true },
+    };
+
+    int mismatches = 0;
+    for (const auto& c : codecs) {
+        const int bpp = c.depth / 8;
+        const size_t row = static_cast<size_t>(width) * bpp;
+        const size_t framesize = row * height;
+        std::vector<uint8_t> frames(framesize * count);
+        uint64_t state = 0x9E3779B97F4A7C15ull + c.depth;
+        fill_random(frames.data(), frames.size(), state);
+
+        const std::string mov = opt.dir + "/rawbench_" + c.pixType + ".mov";
+        const std::string raw = opt.dir + "/rawbench_" + c.pixType
+                                + "_bottom_up.raw";
+        write_mov(mov, width, height, c.depth, frames, count);
+        FILE* fp = fopen(raw.c_str(), "wb");
+        if (!fp) {
+            throw std::runtime_error("cannot create " + raw + ".");
+        }
+        for (int n = 0; n < count; ++n) {
+            for (int y = height - 1; y >= 0; --y) {
+                fwrite(frames.data() + framesize * n + row * y, 1, row, fp);
+            }
+        }
+        fclose(fp);
+
+        for (const auto& mode : opt.modes) {
+            for (const auto& r : reads) {
+                const AVSValue mov_args[] = {
+                    mov.c_str(), "mov", mode == "mmap", mode == "direct",
+                    r.left, r.top, r.right, r.bottom, r.planar,
+                };
+                const char* const mov_names[] = {
+                    nullptr, "container", "mmap", "direct", "crop_left",
+                    "crop_top", "crop_right", "crop_bottom", "planar_output",
+                };
+                PClip clip = env->Invoke("RawSource", AVSValue(mov_args, 9),
+                                         mov_names).AsClip();
+                const AVSValue raw_args[] = {
+                    raw.c_str(), width, height, c.pixType, false,
+                    r.left, r.top, r.right, r.bottom, r.planar,
+                };
+                const char* const raw_names[] = {
+                    nullptr, "width", "height", "pixel_type", "index_cache",
+                    "crop_left", "crop_top", "crop_right", "crop_bottom",
+                    "planar_output",
+                };
+                PClip ref = env->Invoke("RawSource", AVSValue(raw_args, 10),
+                                        raw_names).AsClip();
+
+                const VideoInfo& vi = clip->GetVideoInfo();
+                const VideoInfo& rvi = ref->GetVideoInfo();
+                bool ok = vi.width == rvi.width && vi.height == rvi.height
+                          && vi.pixel_type == rvi.pixel_type
+                          && vi.num_frames == count;
+                for (int n = 0; ok && n < count; ++n) {
+                    PVideoFrame f = clip->GetFrame(n, env);
+                    ok = same_frame(f, ref->GetFrame(n, env), vi);
+                    if (ok && !strcmp(r.name, "plain")) {
+                        // RGB24/RGB32 keep the top row last.
+                        const uint8_t* top = f->GetReadPtr()
+                                             + (height - 1) * f->GetPitch();
+                        const uint8_t* first = frames.data() + framesize * n;
+                        for (int x = 0; ok && x < width; ++x) {
+                            for (int k = 0; ok && k < bpp; ++k) {
+                                ok = top[x * bpp + k]
+                                     == first[x * bpp + c.src[k]];
+                            }
+                        }
+                    }
+                    ++checked;
+                }
+                if (!ok) {
+                    fprintf(stderr, "rawbench: MOV 'raw ' %d (%s, %s) is not "
+                            "read top-down.\n", c.depth, mode.c_str(),
+                            r.name);
+                    ++mismatches;
+                }
+            }
+        }
+        if (!opt.keep) {
+            remove(mov.c_str());
+            remove(raw.c_str());
+        }
+    }
+    return mismatches;
+}
+
+
+static double percentile(std::vector<double> v, double p)
+{
+    if (v.empty()) {
+        return 0.0;
+    }
+    std::sort(v.begin(), v.end());
+    size_t i = static_cast<size_t>(p / 100.0 * (v.size() - 1) + 0.5);
+    return v[std::min(i, v.size() - 1)];
+}
+
+
+static void write_results(FILE* out, const std::vector<result>& results,
+                          bool json)
+{
+    static const char* keys[] = {
+        "format", "kernel", "mode", "access", "cache", "width", "height",
+        "frame_bytes", "frames", "seconds", "fps", "mb_per_s", "lat_p50_ms",
+        "lat_p90_ms", "lat_p99_ms", "lat_max_ms",
+    };
+
+    if (json) {
+        fprintf(out, "[\n");
+    } else {
+        for (size_t k = 0; k < 16; ++k) {
+            fprintf(out, k ? ",%s" : "%s", keys[k]);
+        }
+        fprintf(out, "\n");
+    }
+
+    for (size_t i = 0; i < results.size(); ++i) {
+        const result& r = results[i];
+        const double fps = r.seconds > 0 ? r.frames / r.seconds : 0.0;
+        const double mbps = fps * r.frameBytes / (1024.0 * 1024.0);
+        const double p50 = percentile(r.latencies, 50);
+        const double p90 = percentile(r.latencies, 90);
+        const double p99 = percentile(r.latencies, 99);
+        const double max = percentile(r.latencies, 100);
+        if (json) {
+            fprintf(out,
+                "  {\"%s\": \"%s\", \"%s\": \"%s\", \"%s\": \"%s\", "
+                "\"%s\": \"%s\", \"%s\": \"%s\", \"%s\": %d, \"%s\": %d, "
+                "\"%s\": %zu, \"%s\": %d, \"%s\": %.6f, \"%s\": %.2f, "
+                "\"%s\": %.2f, \"%s\": %.4f, \"%s\": %.4f, \"%s\": %.4f, "
+                "\"%s\": %.4f}%s\n",
+                keys[0], r.format.c_str(), keys[1], r.kernel.c_str(),
+                keys[2], r.mode.c_str(), keys[3], r.access.c_str(),
+                keys[4], r.cache.c_str(), keys[5], r.width, keys[6], r.height,
+                keys[7], r.frameBytes, keys[8], r.frames, keys[9], r.seconds,
+                keys[10], fps, keys[11], mbps, keys[12], p50, keys[13], p90,
+                keys[14], p99, keys[15], max,
+                i + 1 < results.size() ? "," : "");
+        } else {
+            fprintf(out, "%s,%s,%s,%s,%s,%d,%d,%zu,%d,%.6f,%.2f,%.2f,%.4f,"
+                    "%.4f,%.4f,%.4f\n",
+                    r.format.c_str(), r.kernel.c_str(), r.mode.c_str(),
+                    r.access.c_str(), r.cache.c_str(), r.width, r.height,
+                    r.frameBytes, r.frames, r.seconds, fps, mbps, p50, p90,
+                    p99, max);
+        }
+    }
+
+    if (json) {
+        fprintf(out, "]\n");
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    options opt;
+    if (!parse_options(argc, argv, opt)) {
+        usage();
+        return 1;
+    }
+
+    std::vector<const pixel_format*> formats;
+    if (opt.formats.empty()) {
+        for (const pixel_format* f = pixel_formats; f->name; ++f) {
+            formats.push_back(f);
+        }
+    }
+    for (const auto& name : opt.formats) {
+        const pixel_format* f = find_pixel_format(name.c_str());
+        if (!f) {
+            fprintf(stderr, "rawbench: unknown pixel type %s\n", name.c_str());
+            return 1;
+        }
+        formats.push_back(f);
+    }
+
+    std::unique_ptr<IScriptEnvironment2> env(CreateScriptEnvironment2());
+    AvisynthPluginInit3(env.get(), nullptr);
+
+    std::vector<result> results;
+    try {
+        if (opt.verify) {
+            int checked = 0;
+            int mismatches = 0;
+            for (const pixel_format* fmt : formats) {
+                mismatches += verify_kernels(env.get(), opt, *fmt, checked);
+            }
+            fprintf(stderr, "rawbench: %d frames of SIMD kernels compared, "
+                    "%d differ.\n", checked, mismatches);
+            int mov_checked = 0;
+            const int mov_mismatches = verify_mov(env.get(), opt,
+                                                  mov_checked);
+            fprintf(stderr, "rawbench: %d frames of MOV files compared, "
+                    "%d reads differ.\n", mov_checked, mov_mismatches);
+            return mismatches + mov_mismatches > 0 ? 1 : 0;
+        }
+
+        for (const pixel_format* fmt : formats) {
+            VideoInfo vi = {};
+            vi.width = opt.width;
+            vi.height = opt.height;
+            vi.pixel_type = fmt->avs_pix_type;
+            const size_t framesize = get_frame_size(vi, *fmt);
+            fprintf(stderr, "%s...\n", fmt->name);
+
+            if (opt.kernels) {
+                for (write_frame_t k : kernels_of(opt, *fmt)) {
+                    results.push_back(run_kernel(env.get(), opt, *fmt,
+                                                 framesize, k));
+                }
+            }
+
+            // with planar_output the clip is not in the layout of fmt.
+            const bool write = opt.writers && !opt.planar
+                               && get_packer(fmt->func);
+            if (!opt.readers && !write) {
+                continue;
+            }
+            const std::string path = make_file(opt, fmt->name, framesize);
+            for (const auto& mode : opt.modes) {
+                for (const auto& access : opt.access) {
+                    for (const auto& cache : opt.caches) {
+                        if (!opt.readers) {
+                            break;
+                        }
+                        results.push_back(run_reader(env.get(), opt, path,
+                                                     *fmt, framesize, mode,
+                                                     access, cache));
+                    }
+                }
+            }
+            if (write) {
+                for (const char* mode : {"write", "write_direct"}) {
+                    results.push_back(run_writer(env.get(), opt, path, *fmt,
+                                                 framesize, mode));
+                }
+            }
+            if (opt.readers && opt.archive && get_packer(fmt->func)) {
+                // frame_bytes and mb_per_s are the ones of the raw frames.
+                const std::string archive = make_archive(env.get(), opt,
+                                                         path, *fmt);
+                check_archive(env.get(), opt, path, archive, *fmt);
+                for (const auto& mode : opt.modes) {
+                    for (const auto& access : opt.access) {
+                        for (const auto& cache : opt.caches) {
+                            result r = run_reader(env.get(), opt, archive,
+                                                  *fmt, framesize, mode,
+                                                  access, cache);
+                            r.kernel = "archive";
+                            results.push_back(r);
+                        }
+                    }
+                }
+                if (!opt.keep) {
+                    remove(archive.c_str());
+                }
+            }
+            if (!opt.keep) {
+                remove(path.c_str());
+            }
+        }
+    } catch (std::exception& e) {
+        fprintf(stderr, "rawbench: %s\n", e.what());
+        return 1;
+    }
+
+    FILE* out = opt.output.empty() ? stdout : fopen(opt.output.c_str(), "w");
+    if (!out) {
+        fprintf(stderr, "rawbench: cannot create %s\n", opt.output.c_str());
+        return 1;
+    }
+    write_results(out, results, opt.json);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
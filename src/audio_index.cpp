@@ -0,0 +1,94 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <algorithm>
+#include "audio_index.h"
+
+
+static const audio_format audio_formats[] = {
+    {"u8",    SAMPLE_INT8,  1, false},
+    {"s16le", SAMPLE_INT16, 2, false},
+    {"s16be", SAMPLE_INT16, 2, true },
+    {"s24le", SAMPLE_INT24, 3, false},
+    {"s24be", SAMPLE_INT24, 3, true },
+    {"s32le", SAMPLE_INT32, 4, false},
+    {"s32be", SAMPLE_INT32, 4, true },
+    {"f32le", SAMPLE_FLOAT, 4, false},
+    {"f32be", SAMPLE_FLOAT, 4, true },
+    {nullptr, 0,            0, false},
+};
+
+
+const audio_format* find_audio_format(const char* name) noexcept
+{
+    for (const audio_format* f = audio_formats; f->name; ++f) {
+        if (!stricmp(name, f->name)) {
+            return f;
+        }
+    }
+    return nullptr;
+}
+
+
+void swap_audio_bytes(uint8_t* buff, size_t size, int bytes) noexcept
+{
+    for (size_t i = 0; i + bytes <= size; i += bytes) {
+        std::reverse(buff + i, buff + i + bytes);
+    }
+}
+
+
+AudioIndex::AudioIndex(const FrameIndex& index, int num_frames,
+                       int64_t framesize, int64_t start, int64_t skip) :
+    totalSize(0)
+{
+    int64_t end = start;
+    for (int n = 0; n < num_frames; ++n) {
+        const int64_t pos = index.lookup(n);
+        if (end >= 0 && pos > end) {
+            chunks.push_back({totalSize, end, pos - end});
+            totalSize += pos - end;
+        }
+        end = pos + framesize + skip;
+    }
+}
+
+
+/*
+  Reads size bytes of the stream from offset into buff. The pieces of all
+  gaps which it covers are read as one batch in file order, so they are
+  in flight together. No hint() is given, it describes the video frame
+  of the thread. Returns the bytes which were read.
+*/
+size_t AudioIndex::read(SourceReader& rd, uint8_t* buff, size_t size,
+                        int64_t offset) const noexcept
+{
+    static thread_local std::vector<read_request> batch;
+    batch.clear();
+
+    auto it = std::upper_bound(chunks.begin(), chunks.end(), offset,
+        [](int64_t v, const audio_chunk& c) { return v < c.offset; });
+    if (it != chunks.begin()) {
+        --it;
+    }
+
+    const int64_t end = offset + static_cast<int64_t>(size);
+    for (int64_t v = offset; v < end && it != chunks.end(); ++it) {
+        const int64_t skip = v - it->offset;
+        const int64_t n = std::min(it->size - skip, end - v);
+        if (n <= 0) {
+            continue;
+        }
+        batch.push_back({buff + (v - offset), static_cast<size_t>(n),
+                         it->pos + skip});
+        v += n;
+    }
+    return batch.empty() ? 0 : rd.read_batch(batch.data(), batch.size());
+}
@@ -0,0 +1,63 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#ifndef RAWSOURCE_AUDIO_INDEX_H
+#define RAWSOURCE_AUDIO_INDEX_H
+
+
+#include "common.h"
+
+
+/*
+  An entry of the audio_format table. bytes is the size of one sample of
+  a channel, bigEndian samples are byte-swapped after they are read.
+*/
+struct audio_format {
+    const char* name;
+    int sampleType;
+    int bytes;
+    bool bigEndian;
+};
+
+const audio_format* find_audio_format(const char* name) noexcept;
+
+void swap_audio_bytes(uint8_t* buff, size_t size, int bytes) noexcept;
+
+
+// a piece of the audio stream: size bytes from offset are at pos.
+struct audio_chunk {
+    int64_t offset;
+    int64_t pos;
+    int64_t size;
+};
+
+
+/*
+  Where the PCM audio of the file is. The audio is the data in the gaps
+  between the video frames of the index (less skip bytes of headers at
+  the start of each gap), and the data from start up to the first frame.
+  The gaps are joined into one stream in file order, so a sample may
+  begin in one gap and end in the next one.
+*/
+class AudioIndex {
+
+    std::vector<audio_chunk> chunks;
+    int64_t totalSize;
+
+public:
+    AudioIndex(const FrameIndex& index, int num_frames, int64_t framesize,
+               int64_t start, int64_t skip);
+
+    int64_t size() const noexcept { return totalSize; }
+    size_t read(SourceReader& rd, uint8_t* buff, size_t size, int64_t offset)
+        const noexcept;
+};
+
+#endif //RAWSOURCE_AUDIO_INDEX_H
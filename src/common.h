@@ -1,83 +1,336 @@
-/*
-RawSource26 - reads raw video data files
-
-Author: Oka Motofumi (chikuzen.mo at gmail dot com)
-
-This program is rewriting of RawSource.dll(original author is Ernst Pech)
-for avisynth2.6x/Avisynth+.
-*/
-
-
-#ifndef RAWSOURCE_COMMON_H
-#define RAWSOURCE_COMMON_H
-
-
-#include <cstring>
-#include <vector>
-#include <stdexcept>
-#define WIN32_LEAN_AND_MEAN
-#define VC_EXTRALEAN
-#define NOMINMAX
-#define NOGDI
-#include <windows.h>
-#include <avisynth.h>
-
-#pragma warning(disable: 4996)
-
-
-typedef IScriptEnvironment ise_t;
-
-constexpr unsigned MIN_WIDTH = 8;
-constexpr unsigned MIN_HEIGHT = 8;
-constexpr unsigned MAX_WIDTH = 65536;
-constexpr unsigned MAX_HEIGHT = 65536;
-
-
-struct rindex {
-    int number;
-    int64_t bytepos;
-    rindex(int x, int64_t y) : number(x), bytepos(y) {}
-};
-
-struct i_struct {
-    int64_t index;
-    char type; //Key, Delta, Bigdelta
-    i_struct() : index(0), type(0) {}
-};
-
-
-bool parse_y4m(std::vector<char>& header, VideoInfo& vi,
-               int64_t& header_offset, int64_t& frame_offset);
-
-void set_rawindex(std::vector<rindex>& r, const char* index,
-                  int64_t header_offset, int64_t frame_offset,
-                  size_t framesize);
-
-int generate_index(std::vector<i_struct>& index, std::vector<rindex>& rawindex,
-                   size_t framesize, int64_t filesize);
-
-void __stdcall
-write_NV420(int fd, PVideoFrame& dst, uint8_t* buff, int* order, int count,
-            ise_t* env) noexcept;
-
-void __stdcall
-write_planar(int fd, PVideoFrame& dst, uint8_t* buff, int* order, int count,
-             ise_t* env) noexcept;
-
-void __stdcall
-write_packed(int fd, PVideoFrame& dst, uint8_t* buff, int* order, int count,
-             ise_t* env) noexcept;
-
-void __stdcall
-write_packed_reorder(int fd, PVideoFrame& dst, uint8_t* buff, int* order,
-                     int count, ise_t* env) noexcept;
-
-void __stdcall write_black_frame(PVideoFrame& dst, const VideoInfo& vi) noexcept;
-
-
-static inline void validate(bool cond, const char* msg)
-{
-    if (cond) throw std::runtime_error(msg);
-}
-
-#endif //RAWSOURCE_COMMON_H
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#ifndef RAWSOURCE_COMMON_H
+#define RAWSOURCE_COMMON_H
+
+
+#include <cstring>
+#include <vector>
+#include <stdexcept>
+#define WIN32_LEAN_AND_MEAN
+#define VC_EXTRALEAN
+#define NOMINMAX
+#define NOGDI
+#include <windows.h>
+#include <avisynth.h>
+#include "reader.h"
+#include "frame_index.h"
+
+#pragma warning(disable: 4996)
+
+
+typedef IScriptEnvironment ise_t;
+
+constexpr unsigned MIN_WIDTH = 8;
+constexpr unsigned MIN_HEIGHT = 8;
+constexpr unsigned MAX_WIDTH = 65536;
+constexpr unsigned MAX_HEIGHT = 65536;
+
+
+struct rindex {
+    int number;
+    int64_t bytepos;
+    rindex(int x, int64_t y) : number(x), bytepos(y) {}
+};
+
+
+// what the positions of the frames are taken from.
+enum {
+    CONTAINER_RAW,
+    CONTAINER_MOV,
+};
+
+
+enum {
+    CPU_SSE2  = 0x01,
+    CPU_SSSE3 = 0x02,
+    CPU_SSE41 = 0x04,
+    CPU_AVX2  = 0x08,
+};
+
+int get_cpu_features() noexcept;
+
+bool read_y4m_header(RawReader& rd, int64_t filesize,
+                     std::vector<char>& header);
+
+bool parse_y4m(std::vector<char>& header, VideoInfo& vi,
+               int64_t& header_offset);
+
+int scan_y4m_frames(RawReader& rd, int64_t filesize, int64_t pos,
+                    size_t framesize, FrameIndex& index);
+
+void set_rawindex(std::vector<rindex>& r, const char* index,
+                  size_t framesize);
+
+int generate_index(FrameIndex& index, std::vector<rindex>& rawindex,
+                   size_t framesize, int64_t filesize, int maxframe);
+
+/*
+  Sample format of 16bit data, kept in order[3] of the pixelformats table.
+  The low byte is the number of significant bits. SAMPLE_MSB means they
+  are stored in the upper bits of each word, SAMPLE_BE means big endian.
+  Plain little endian data is read as is.
+*/
+enum {
+    SAMPLE_MSB = 0x100,
+    SAMPLE_BE  = 0x200,
+};
+
+static inline bool sample_needs_conversion(int fmt)
+{
+    return (fmt & (SAMPLE_MSB | SAMPLE_BE)) != 0;
+}
+
+static inline int sample_shift(int fmt)
+{
+    return fmt & SAMPLE_MSB ? 16 - (fmt & 0xFF) : 0;
+}
+
+static inline uint16_t sample_mask(int fmt)
+{
+    return static_cast<uint16_t>(0xFFFF >> (16 - (fmt & 0xFF)));
+}
+
+static inline uint16_t convert_sample(uint16_t v, bool swap, int shift,
+                                      uint16_t mask)
+{
+    if (swap) {
+        v = static_cast<uint16_t>((v >> 8) | (v << 8));
+    }
+    return (v >> shift) & mask;
+}
+
+/*
+  Row functions of the 16bit planar and semi-planar kernels. n is the
+  number of samples in one output row. 16bit samples are byte-swapped,
+  shifted and masked by fmt while they are copied.
+*/
+typedef void (*convert_row_t)(const uint8_t* srcp, uint8_t* dstp, int n,
+                              int fmt);
+typedef void (*split_uv_t)(const uint8_t* srcp, uint8_t* dstp0,
+                           uint8_t* dstp1, int n, int fmt);
+
+struct row_funcs {
+    convert_row_t convert16;
+    split_uv_t split8;
+    split_uv_t split16;
+};
+
+void write_planar16_common(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                           uint8_t* buff, int* order, int count,
+                           const row_funcs& funcs) noexcept;
+
+void write_semi_planar_common(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                              uint8_t* buff, int* order, int count,
+                              const row_funcs& funcs) noexcept;
+
+void __stdcall
+write_planar16(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+               int* order, int count, ise_t* env) noexcept;
+
+void __stdcall
+write_planar16_sse2(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                    uint8_t* buff, int* order, int count, ise_t* env)
+                    noexcept;
+
+void __stdcall
+write_planar16_avx2(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                    uint8_t* buff, int* order, int count, ise_t* env)
+                    noexcept;
+
+void __stdcall
+write_semi_planar(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+                  int* order, int count, ise_t* env) noexcept;
+
+void __stdcall
+write_semi_planar_sse2(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                       uint8_t* buff, int* order, int count, ise_t* env)
+                       noexcept;
+
+void __stdcall
+write_semi_planar_avx2(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                       uint8_t* buff, int* order, int count, ise_t* env)
+                       noexcept;
+
+void __stdcall
+write_planar(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+             int* order, int count, ise_t* env) noexcept;
+
+void __stdcall
+write_packed(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+             int* order, int count, ise_t* env) noexcept;
+
+void __stdcall
+write_packed_reorder(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                     uint8_t* buff, int* order, int count, ise_t* env) noexcept;
+
+void __stdcall
+write_packed_reorder_ssse3(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                           uint8_t* buff, int* order, int count, ise_t* env)
+                           noexcept;
+
+void __stdcall
+write_packed_reorder_avx2(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                          uint8_t* buff, int* order, int count, ise_t* env)
+                          noexcept;
+
+/*
+  Packed YUV and RGB read into planar frames. write_packed422 splits YUY2
+  style data (order gives the bytes of Y0, U, Y1 and V of a pixel pair)
+  into YV16. The packed444 kernels split count bytes per pixel (order
+  gives the bytes of Y, U, V and A) into YV24 or YUVA444, the rgbp ones
+  (order gives the bytes of G, B, R and A) into RGBP or RGBAP.
+*/
+void __stdcall
+write_packed422(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+                int* order, int count, ise_t* env) noexcept;
+
+void __stdcall
+write_packed422_ssse3(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                      uint8_t* buff, int* order, int count, ise_t* env)
+                      noexcept;
+
+void unpack_packed422_row_c(const uint8_t* srcp, uint8_t* dsty, uint8_t* dstu,
+                            uint8_t* dstv, int x, int width, const int* order)
+                            noexcept;
+
+void unpack_packed444_row_c(const uint8_t* srcp, uint8_t* const* dstp, int x,
+                            int width, const int* order, int count) noexcept;
+
+typedef void (*unpack444_row_t)(const uint8_t* srcp, uint8_t* const* dstp,
+                                int width, const int* order, int count);
+
+void write_packed444_common(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                            uint8_t* buff, const int* order, int count,
+                            bool rgb, unpack444_row_t unpack) noexcept;
+
+void __stdcall
+write_packed444(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+                int* order, int count, ise_t* env) noexcept;
+
+void __stdcall
+write_packed444_ssse3(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                      uint8_t* buff, int* order, int count, ise_t* env)
+                      noexcept;
+
+void __stdcall
+write_packed444_avx2(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                     uint8_t* buff, int* order, int count, ise_t* env)
+                     noexcept;
+
+void __stdcall
+write_packed_rgbp(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+                  int* order, int count, ise_t* env) noexcept;
+
+void __stdcall
+write_packed_rgbp_ssse3(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                        uint8_t* buff, int* order, int count, ise_t* env)
+                        noexcept;
+
+void __stdcall
+write_packed_rgbp_avx2(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                       uint8_t* buff, int* order, int count, ise_t* env)
+                       noexcept;
+
+/*
+  Source row sizes of the word packed 10bit formats. v210 rows are padded
+  to 48 pixels (128 bytes). r210 rows are padded to 64 pixels and R10k
+  rows are not padded, the table gives this as order[3].
+*/
+static inline size_t v210_row_size(int width)
+{
+    return static_cast<size_t>((width + 47) / 48) * 128;
+}
+
+static inline size_t rgb10_row_size(int width, int align)
+{
+    return static_cast<size_t>((width + align - 1) / align * align) * 4;
+}
+
+void unpack_v210_row_c(const uint8_t* srcp, uint16_t* dsty, uint16_t* dstu,
+                       uint16_t* dstv, int x, int width) noexcept;
+
+void unpack_y210_row_c(const uint8_t* srcp, uint16_t* dsty, uint16_t* dstu,
+                       uint16_t* dstv, int x, int width, int fmt) noexcept;
+
+void unpack_rgb10_row_c(const uint8_t* srcp, uint16_t* dstr, uint16_t* dstg,
+                        uint16_t* dstb, int x, int width, const int* order)
+                        noexcept;
+
+void __stdcall
+write_v210(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+           int* order, int count, ise_t* env) noexcept;
+
+void __stdcall
+write_v210_ssse3(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+                 int* order, int count, ise_t* env) noexcept;
+
+void __stdcall
+write_y210(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+           int* order, int count, ise_t* env) noexcept;
+
+void __stdcall
+write_y210_ssse3(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+                 int* order, int count, ise_t* env) noexcept;
+
+void __stdcall
+write_rgb10(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+            int* order, int count, ise_t* env) noexcept;
+
+void __stdcall
+write_rgb10_ssse3(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+                  int* order, int count, ise_t* env) noexcept;
+
+void __stdcall write_black_frame(PVideoFrame& dst, const VideoInfo& vi) noexcept;
+
+typedef void (__stdcall *write_frame_t)(
+    RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff, int* order,
+    int count, ise_t* env);
+
+/*
+  An entry of the pixel_type table. order gives the planes or bytes of the
+  source in the output (order[3] is the sample format of 16bit data), cnt
+  is the number of planes/bytes and func the C kernel which reads a frame.
+  The table ends with an entry whose name is nullptr.
+*/
+struct pixel_format {
+    const char* name;
+    int avs_pix_type;
+    int order[4];
+    int cnt;
+    write_frame_t func;
+};
+
+extern const pixel_format pixel_formats[];
+
+const pixel_format* find_pixel_format(const char* name) noexcept;
+
+size_t get_frame_size(const VideoInfo& vi, const pixel_format& fmt) noexcept;
+
+write_frame_t get_kernel(write_frame_t func, int cpu) noexcept;
+
+/*
+  The reverse of a kernel for RawWrite: packs a frame into the layout of
+  the file at dstp (get_frame_size() bytes). order and count are the
+  ones of the pixel_type table entry.
+*/
+typedef void (*pack_frame_t)(const PVideoFrame& src, uint8_t* dstp,
+                             const int* order, int count);
+
+pack_frame_t get_packer(write_frame_t func) noexcept;
+
+
+static inline void validate(bool cond, const char* msg)
+{
+    if (cond) throw std::runtime_error(msg);
+}
+
+#endif //RAWSOURCE_COMMON_H
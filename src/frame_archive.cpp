@@ -0,0 +1,317 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <algorithm>
+#include <system_error>
+#include "frame_archive.h"
+#include "lz4_block.h"
+
+
+static const char ARCHIVE_MAGIC[8] = {'R', 'S', 'A', 'R', 'C', 0, 0, 0};
+static const char ARCHIVE_TABLE_MAGIC[4] = {'R', 'S', 'A', 'T'};
+constexpr uint32_t ARCHIVE_VERSION = 1;
+
+// the chunks of a frame this large are (de)compressed by threads of their
+// own. below this, starting a thread costs more than it saves.
+constexpr size_t ARCHIVE_PARALLEL_SIZE = 1 << 20;
+
+static const char* archive_error =
+    "the seek table of the archive is broken.";
+
+
+/*
+  The chunks a frame of fmt is split into: the planes of planar formats,
+  the luma and the chroma pairs of semi-planar ones, otherwise the whole
+  frame. Returns the number of chunks.
+*/
+int get_chunk_sizes(const VideoInfo& vi, const pixel_format& fmt,
+                    size_t* sizes) noexcept
+{
+    const size_t framesize = get_frame_size(vi, fmt);
+    if (fmt.func == write_planar || fmt.func == write_planar16) {
+        for (int i = 0; i < fmt.cnt; ++i) {
+            const int plane = i < 3 ? fmt.order[i] : PLANAR_A;
+            sizes[i] = static_cast<size_t>(
+                vi.width >> vi.GetPlaneWidthSubsampling(plane))
+                * (vi.height >> vi.GetPlaneHeightSubsampling(plane))
+                * vi.ComponentSize();
+        }
+        return fmt.cnt;
+    }
+    if (fmt.func == write_semi_planar) {
+        sizes[0] = static_cast<size_t>(vi.width) * vi.height * fmt.cnt;
+        sizes[1] = framesize - sizes[0];
+        return 2;
+    }
+    sizes[0] = framesize;
+    return 1;
+}
+
+
+// runs func(k) for every chunk, in parallel if the frame is large.
+template <typename F>
+static void for_each_chunk(int count, size_t bytes, F func) noexcept
+{
+    std::thread threads[ARCHIVE_MAX_CHUNKS];
+    if (bytes >= ARCHIVE_PARALLEL_SIZE) {
+        for (int k = 1; k < count; ++k) {
+            try {
+                threads[k] = std::thread(func, k);
+            } catch (std::system_error&) {
+                func(k);
+            }
+        }
+    }
+    func(0);
+    for (int k = 1; k < count; ++k) {
+        if (threads[k].joinable()) {
+            threads[k].join();
+        } else if (bytes < ARCHIVE_PARALLEL_SIZE) {
+            func(k);
+        }
+    }
+}
+
+
+static size_t chunk_bytes(uint32_t size) noexcept
+{
+    return size & ~ARCHIVE_STORED;
+}
+
+
+bool FrameArchive::is_archive(RawReader& rd, int64_t filesize) noexcept
+{
+    char magic[8];
+    return filesize >= static_cast<int64_t>(sizeof(archive_header))
+           && rd.read(reinterpret_cast<uint8_t*>(magic), sizeof(magic), 0)
+              == sizeof(magic)
+           && !memcmp(magic, ARCHIVE_MAGIC, sizeof(magic));
+}
+
+
+/*
+  Reads the header and the seek table at the end of the file. Every
+  chunk needs to be inside the frame data and no larger than the LZ4
+  bound of its size.
+*/
+FrameArchive::FrameArchive(RawReader& rd, int64_t filesize) : maxFrameSize(0)
+{
+    rd.read(reinterpret_cast<uint8_t*>(&header), sizeof(header), 0);
+    validate(header.version != ARCHIVE_VERSION,
+             "the archive has an unknown version.");
+    validate(header.codec != ARCHIVE_CODEC_LZ4,
+             "the archive uses an unknown codec.");
+    validate(header.numChunks < 1 || header.numChunks > ARCHIVE_MAX_CHUNKS
+             || header.numFrames < 1, "the archive header is broken.");
+    header.pixType[sizeof(header.pixType) - 1] = '\0';
+    for (int k = 0; k < header.numChunks; ++k) {
+        validate(header.chunkSize[k] == 0
+                 || header.chunkSize[k] >= ARCHIVE_STORED,
+                 "the archive header is broken.");
+    }
+
+    const int64_t data_start = sizeof(archive_header);
+    const int64_t trailer_size = sizeof(archive_trailer);
+    archive_trailer trailer = {};
+    validate(filesize < data_start + trailer_size,
+             "the archive has no seek table. it may not be finished.");
+    rd.read(reinterpret_cast<uint8_t*>(&trailer), sizeof(trailer),
+            filesize - trailer_size);
+    validate(memcmp(trailer.magic, ARCHIVE_TABLE_MAGIC, 4) != 0,
+             "the archive has no seek table. it may not be finished.");
+    const int64_t table_size = static_cast<int64_t>(header.numFrames)
+        * static_cast<int64_t>(sizeof(archive_entry));
+    validate(trailer.numFrames != header.numFrames
+             || trailer.tablePos < data_start
+             || trailer.tablePos + table_size + trailer_size != filesize,
+             archive_error);
+
+    table.resize(header.numFrames);
+    validate(rd.read(reinterpret_cast<uint8_t*>(table.data()),
+                     static_cast<size_t>(table_size), trailer.tablePos)
+             != static_cast<size_t>(table_size), archive_error);
+
+    for (const auto& e : table) {
+        if (e.pos == 0) {
+            continue;
+        }
+        int64_t size = 0;
+        for (int k = 0; k < header.numChunks; ++k) {
+            const size_t bytes = chunk_bytes(e.size[k]);
+            const size_t chunk = chunk_size(k);
+            validate(e.size[k] & ARCHIVE_STORED ? bytes != chunk
+                     : bytes == 0 || bytes > chunk + chunk / 255 + 16,
+                     archive_error);
+            size += bytes;
+        }
+        validate(e.pos < data_start || e.pos + size > trailer.tablePos,
+                 archive_error);
+        maxFrameSize = std::max(maxFrameSize, static_cast<size_t>(size));
+    }
+}
+
+
+// the bytes of frame n in the file, 0 if it was never written.
+size_t FrameArchive::frame_size(int n) const noexcept
+{
+    const archive_entry& e = table[n];
+    if (e.pos == 0) {
+        return 0;
+    }
+    size_t size = 0;
+    for (int k = 0; k < header.numChunks; ++k) {
+        size += chunk_bytes(e.size[k]);
+    }
+    return size;
+}
+
+
+void FrameArchive::fill_index(FrameIndex& index) const
+{
+    for (int n = 0; n < header.numFrames; ++n) {
+        index.add(n, table[n].pos, 'Z');
+    }
+}
+
+
+/*
+  Decodes chunk k into planes[k]. A chunk goes straight into its plane if
+  the rows of the plane follow each other, otherwise it is decoded into
+  stage (at the offset of the chunk in the frame) and copied row by row.
+*/
+bool FrameArchive::decode(int n, const uint8_t* src,
+                          const archive_plane* planes, uint8_t* stage)
+                          const noexcept
+{
+    const archive_entry& e = table[n];
+    const uint8_t* chunk_src[ARCHIVE_MAX_CHUNKS];
+    uint8_t* chunk_stage[ARCHIVE_MAX_CHUNKS];
+    size_t offset = 0;
+    for (int k = 0; k < header.numChunks; ++k) {
+        chunk_src[k] = src;
+        chunk_stage[k] = stage + offset;
+        src += chunk_bytes(e.size[k]);
+        offset += chunk_size(k);
+    }
+
+    bool ok[ARCHIVE_MAX_CHUNKS] = {};
+    for_each_chunk(header.numChunks, offset, [&](int k) {
+        const archive_plane& p = planes[k];
+        const size_t size = chunk_size(k);
+        const bool contiguous = p.pitch == p.rowsize || p.height == 1;
+        const uint8_t* data = chunk_src[k];
+        if (!(e.size[k] & ARCHIVE_STORED)) {
+            uint8_t* dstp = contiguous ? p.dstp : chunk_stage[k];
+            if (!lz4_decompress(data, chunk_bytes(e.size[k]), dstp, size)) {
+                return;
+            }
+            data = dstp;
+        }
+        if (data != p.dstp) {
+            for (int y = 0; y < p.height; ++y) {
+                memcpy(p.dstp + static_cast<size_t>(y) * p.pitch,
+                       data + static_cast<size_t>(y) * p.rowsize, p.rowsize);
+            }
+        }
+        ok[k] = true;
+    });
+    return std::all_of(ok, ok + header.numChunks, [](bool b) { return b; });
+}
+
+
+ArchiveBuilder::ArchiveBuilder(const VideoInfo& vi, const pixel_format& fmt)
+    : dataEnd(sizeof(archive_header))
+{
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+    header.version = ARCHIVE_VERSION;
+    header.codec = ARCHIVE_CODEC_LZ4;
+    header.width = vi.width;
+    header.height = vi.height;
+    header.fpsNum = vi.fps_numerator;
+    header.fpsDen = vi.fps_denominator;
+    header.imageType = vi.image_type;
+    header.numFrames = vi.num_frames;
+    strncpy(header.pixType, fmt.name, sizeof(header.pixType) - 1);
+
+    size_t sizes[ARCHIVE_MAX_CHUNKS];
+    header.numChunks = get_chunk_sizes(vi, fmt, sizes);
+    for (int k = 0; k < header.numChunks; ++k) {
+        validate(sizes[k] >= ARCHIVE_STORED,
+                 "a plane is too large for an archive.");
+        header.chunkSize[k] = sizes[k];
+    }
+    table.resize(vi.num_frames, archive_entry());
+}
+
+
+/*
+  Compresses the chunks of the frame at src into dst (the frame size of
+  room) and packs them together. A chunk which does not get smaller is
+  stored as it is. Returns the size of the frame in the archive.
+*/
+size_t ArchiveBuilder::compress(const uint8_t* src, uint8_t* dst,
+                                archive_entry& entry) const noexcept
+{
+    size_t offset[ARCHIVE_MAX_CHUNKS];
+    size_t total = 0;
+    for (int k = 0; k < header.numChunks; ++k) {
+        offset[k] = total;
+        total += static_cast<size_t>(header.chunkSize[k]);
+    }
+
+    for_each_chunk(header.numChunks, total, [&](int k) {
+        const size_t size = static_cast<size_t>(header.chunkSize[k]);
+        const size_t packed = lz4_compress(src + offset[k], size,
+                                           dst + offset[k], size - 1);
+        if (packed > 0) {
+            entry.size[k] = static_cast<uint32_t>(packed);
+        } else {
+            memcpy(dst + offset[k], src + offset[k], size);
+            entry.size[k] = static_cast<uint32_t>(size) | ARCHIVE_STORED;
+        }
+    });
+
+    size_t pos = 0;
+    for (int k = 0; k < header.numChunks; ++k) {
+        const size_t bytes = chunk_bytes(entry.size[k]);
+        memmove(dst + pos, dst + offset[k], bytes);
+        pos += bytes;
+    }
+    return pos;
+}
+
+
+// the position of frame n, which takes size bytes.
+int64_t ArchiveBuilder::add(int n, archive_entry& entry, size_t size)
+noexcept
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    entry.pos = dataEnd;
+    dataEnd += static_cast<int64_t>(size);
+    table[n] = entry;
+    return entry.pos;
+}
+
+
+int64_t ArchiveBuilder::finish(std::vector<uint8_t>& tail)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    const size_t table_size = table.size() * sizeof(archive_entry);
+    archive_trailer trailer = {};
+    trailer.tablePos = dataEnd;
+    trailer.numFrames = header.numFrames;
+    memcpy(trailer.magic, ARCHIVE_TABLE_MAGIC, sizeof(trailer.magic));
+
+    tail.resize(table_size + sizeof(trailer));
+    memcpy(tail.data(), table.data(), table_size);
+    memcpy(tail.data() + table_size, &trailer, sizeof(trailer));
+    return dataEnd;
+}
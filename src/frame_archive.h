@@ -0,0 +1,136 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#ifndef RAWSOURCE_FRAME_ARCHIVE_H
+#define RAWSOURCE_FRAME_ARCHIVE_H
+
+
+#include "common.h"
+
+
+/*
+  A RawSource archive holds the frames of a pixel_type like a raw file
+  does, but every frame is split into chunks (the planes of the layout)
+  which are compressed on their own, so a frame, or a plane of it, is
+  decoded without any other. The file is
+    archive_header
+    the chunks of every frame, one frame after the other
+    an archive_entry of every frame (the seek table)
+    archive_trailer
+  in little endian. The frames may be in any order, the seek table is
+  written when all of them are there.
+*/
+constexpr int ARCHIVE_MAX_CHUNKS = 4;
+
+enum {
+    ARCHIVE_CODEC_LZ4 = 1,
+};
+
+// the size of a chunk which is kept uncompressed has this bit set.
+constexpr uint32_t ARCHIVE_STORED = 0x80000000;
+
+
+struct archive_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t codec;
+    int32_t width;
+    int32_t height;
+    uint32_t fpsNum;
+    uint32_t fpsDen;
+    int32_t imageType;
+    int32_t numFrames;
+    int32_t numChunks;
+    int32_t reserved;
+    char pixType[16];
+    uint64_t chunkSize[ARCHIVE_MAX_CHUNKS];
+};
+
+
+// pos is 0 for a frame which was never written.
+struct archive_entry {
+    int64_t pos;
+    uint32_t size[ARCHIVE_MAX_CHUNKS];
+};
+
+
+struct archive_trailer {
+    int64_t tablePos;
+    int32_t numFrames;
+    char magic[4];
+};
+
+
+// where a chunk is decoded to: height rows of rowsize bytes, pitch apart.
+struct archive_plane {
+    uint8_t* dstp;
+    int pitch;
+    int rowsize;
+    int height;
+};
+
+
+int get_chunk_sizes(const VideoInfo& vi, const pixel_format& fmt,
+                    size_t* sizes) noexcept;
+
+
+/*
+  The seek table of an archive which RawSource reads. decode() reads the
+  chunks of frame n from src (frame_size(n) bytes from its position).
+*/
+class FrameArchive {
+
+    archive_header header;
+    std::vector<archive_entry> table;
+    size_t maxFrameSize;
+
+public:
+    FrameArchive(RawReader& rd, int64_t filesize);
+
+    static bool is_archive(RawReader& rd, int64_t filesize) noexcept;
+
+    const archive_header& info() const noexcept { return header; }
+    int chunks() const noexcept { return header.numChunks; }
+    size_t chunk_size(int k) const noexcept
+    {
+        return static_cast<size_t>(header.chunkSize[k]);
+    }
+    size_t frame_size(int n) const noexcept;
+    size_t max_frame_size() const noexcept { return maxFrameSize; }
+
+    void fill_index(FrameIndex& index) const;
+    bool decode(int n, const uint8_t* src, const archive_plane* planes,
+                uint8_t* stage) const noexcept;
+};
+
+
+/*
+  Makes an archive for RawWrite. compress() packs a frame into dst and
+  add() gives it its position. finish() returns the seek table and the
+  trailer, which go to the position it gives.
+*/
+class ArchiveBuilder {
+
+    archive_header header;
+    std::vector<archive_entry> table;
+    int64_t dataEnd;
+    std::mutex mtx;
+
+public:
+    ArchiveBuilder(const VideoInfo& vi, const pixel_format& fmt);
+
+    const archive_header& info() const noexcept { return header; }
+    size_t compress(const uint8_t* src, uint8_t* dst, archive_entry& entry)
+        const noexcept;
+    int64_t add(int n, archive_entry& entry, size_t size) noexcept;
+    int64_t finish(std::vector<uint8_t>& tail);
+};
+
+#endif //RAWSOURCE_FRAME_ARCHIVE_H
@@ -0,0 +1,109 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <algorithm>
+#include <climits>
+#include "frame_cache.h"
+
+
+FrameCache::FrameCache(size_t budget, size_t frame_size) :
+    maxFrames(static_cast<int>(std::max<size_t>(
+        std::min<size_t>(budget / frame_size, INT_MAX), 1))),
+    policy(CACHE_GENERIC), window(0), capacity(maxFrames)
+{
+    map.reserve(maxFrames);
+}
+
+
+// drops the least recently used frames which are over capacity.
+void FrameCache::trim() noexcept
+{
+    while (static_cast<int>(frames.size()) > capacity) {
+        map.erase(frames.back().frame);
+        frames.pop_back();
+    }
+}
+
+
+bool FrameCache::get(int n, PVideoFrame& frame)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = map.find(n);
+    if (it == map.end()) {
+        return false;
+    }
+    frames.splice(frames.begin(), frames, it->second);
+    frame = it->second->data;
+    return true;
+}
+
+
+// a frame which two threads converted at once is kept once.
+void FrameCache::put(int n, const PVideoFrame& frame)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    if (capacity == 0 || map.find(n) != map.end()) {
+        return;
+    }
+    frames.push_front({n, frame});
+    map[n] = frames.begin();
+    trim();
+}
+
+
+/*
+  The video hints of SetCacheHints(). A number of frames asked for is
+  limited to the budget. CACHE_GENERIC does not shrink a larger window
+  which was asked for before, CACHE_FORCE_GENERIC does. Returns the
+  answer of the queries, 0 to the others.
+*/
+int FrameCache::hint(int cachehints, int frame_range)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    const int frames_asked = std::min(std::max(frame_range, 0), maxFrames);
+
+    switch (cachehints) {
+    case CACHE_NOTHING:
+        policy = CACHE_NOTHING;
+        window = 0;
+        capacity = 0;
+        break;
+    case CACHE_WINDOW:
+        policy = CACHE_WINDOW;
+        window = frames_asked;
+        capacity = frames_asked;
+        break;
+    case CACHE_GENERIC:
+        if (policy == CACHE_WINDOW) {
+            capacity = std::max(capacity, frames_asked);
+            break;
+        }
+        // fall through
+    case CACHE_FORCE_GENERIC:
+        policy = CACHE_GENERIC;
+        window = 0;
+        capacity = frames_asked;
+        break;
+    case CACHE_GET_POLICY:
+        return policy;
+    case CACHE_GET_WINDOW:
+        return window;
+    case CACHE_GET_RANGE:
+    case CACHE_GET_CAPACITY:
+        return capacity;
+    case CACHE_GET_SIZE:
+        return static_cast<int>(frames.size());
+    default:
+        return 0;
+    }
+
+    trim();
+    return 0;
+}
@@ -0,0 +1,53 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#ifndef RAWSOURCE_FRAME_CACHE_H
+#define RAWSOURCE_FRAME_CACHE_H
+
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include "common.h"
+
+
+/*
+  Converted frames of a clip, the least recently used one is dropped
+  first. It holds as many frames as fit into the memory budget, or fewer
+  if a filter asks for less with SetCacheHints (CACHE_WINDOW or
+  CACHE_GENERIC and a number of frames). The frames are shared with the
+  callers, Avisynth copies a frame before anything writes to it.
+*/
+class FrameCache {
+
+    struct entry {
+        int frame;
+        PVideoFrame data;
+    };
+
+    std::list<entry> frames;    // most recently used first
+    std::unordered_map<int, std::list<entry>::iterator> map;
+    std::mutex mtx;
+    const int maxFrames;        // of the budget
+    int policy;
+    int window;
+    int capacity;
+
+    void trim() noexcept;
+
+public:
+    FrameCache(size_t budget, size_t frame_size);
+
+    bool get(int n, PVideoFrame& frame);
+    void put(int n, const PVideoFrame& frame);
+    int hint(int cachehints, int frame_range);
+};
+
+#endif //RAWSOURCE_FRAME_CACHE_H
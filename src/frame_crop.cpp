@@ -0,0 +1,292 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <algorithm>
+#include <climits>
+#include "frame_crop.h"
+
+
+/*
+  A plane of a raw frame: unitBytes bytes hold unitPixels pixels of a row
+  (e.g. 6 pixels in 16 bytes for v210, 2 chroma pairs per 2 pixels for
+  NV12), and it has height >> yshift rows.
+*/
+struct plane_spec {
+    int unitPixels;
+    int unitBytes;
+    int yshift;
+};
+
+
+static size_t bytes_for(const plane_spec& s, int pixels) noexcept
+{
+    return static_cast<size_t>((pixels + s.unitPixels - 1) / s.unitPixels)
+           * s.unitBytes;
+}
+
+
+static size_t pitch_for(const pixel_format& fmt, const plane_spec& s,
+                        int width) noexcept
+{
+    if (fmt.func == write_v210) {
+        return v210_row_size(width);
+    }
+    if (fmt.func == write_rgb10) {
+        return rgb10_row_size(width, fmt.order[3]);
+    }
+    return bytes_for(s, width);
+}
+
+
+// the planes of a frame in the order they are stored in the file.
+static std::vector<plane_spec> get_planes(const pixel_format& fmt,
+                                          const VideoInfo& vi, int ssw,
+                                          int ssh)
+{
+    std::vector<plane_spec> planes;
+    if (fmt.func == write_v210) {
+        planes.push_back({6, 16, 0});
+    } else if (fmt.func == write_y210) {
+        planes.push_back({2, 8, 0});
+    } else if (fmt.func == write_rgb10) {
+        planes.push_back({1, 4, 0});
+    } else if (fmt.func == write_packed444) {
+        planes.push_back({1, fmt.cnt, 0});
+    } else if (fmt.func == write_semi_planar) {
+        planes.push_back({1, fmt.cnt, 0});
+        planes.push_back({2, fmt.cnt * 2, ssh});
+    } else if (fmt.func == write_planar || fmt.func == write_planar16) {
+        const int bytes = vi.ComponentSize();
+        planes.push_back({1, bytes, 0});
+        for (int i = 1; i < fmt.cnt; ++i) {
+            planes.push_back({1 << ssw, bytes, ssh});
+        }
+    } else if (vi.IsYUY2()) {
+        planes.push_back({2, 4, 0});
+    } else {
+        planes.push_back({1, vi.BitsPerPixel() / 8, 0});
+    }
+    return planes;
+}
+
+
+FrameCrop::FrameCrop(const pixel_format& fmt, const VideoInfo& vi, int left,
+                     int top, int right, int bottom, int field, bool flip)
+{
+    validate(left < 0 || top < 0 || right < 0 || bottom < 0,
+             "crop values need to be 0 or higher.");
+
+    int ssw = 0;
+    int ssh = 0;
+    if (vi.IsYUY2()) {
+        ssw = 1;
+    } else if (vi.IsPlanar() && !vi.IsY() && !vi.IsRGB()) {
+        ssw = vi.GetPlaneWidthSubsampling(PLANAR_U);
+        ssh = vi.GetPlaneHeightSubsampling(PLANAR_U);
+    }
+    const int fields = field == FIELD_NONE ? 1 : 2;
+    const int height = vi.height - top - bottom;
+    cropWidth = vi.width - left - right;
+    cropHeight = height / fields;
+
+    validate(cropWidth < static_cast<int>(MIN_WIDTH)
+             || cropHeight < static_cast<int>(MIN_HEIGHT),
+             "cropped frame is too small.");
+
+    // whole v210 blocks, whole chroma samples, and whole chroma rows of
+    // the field.
+    const int left_align = fmt.func == write_v210 ? 6 : 1 << ssw;
+    validate(left % left_align != 0 || cropWidth % (1 << ssw) != 0,
+             "crop_left and the cropped width need to be multiples of the"
+             " horizontal chroma subsampling (6 for crop_left of v210).");
+    validate(top % (fields << ssh) != 0 || height % (fields << ssh) != 0,
+             "crop_top and the cropped height need to be multiples of the"
+             " vertical chroma subsampling (twice that with field).");
+
+    const int parity = field == FIELD_BOTTOM ? 1 : 0;
+    int64_t src = 0;
+    int64_t dst = 0;
+    firstByte = INT64_MAX;
+    lastByte = 0;
+    for (const auto& s : get_planes(fmt, vi, ssw, ssh)) {
+        crop_plane p;
+        p.srcOffset = src;
+        p.dstOffset = dst;
+        p.srcPitch = pitch_for(fmt, s, vi.width);
+        p.rowSize = pitch_for(fmt, s, cropWidth);
+        p.fetchSize = std::min(bytes_for(s, cropWidth), p.rowSize);
+        p.left = bytes_for(s, left);
+        p.top = (top >> s.yshift) + parity;
+        p.step = fields;
+        p.rows = cropHeight >> s.yshift;
+        if (flip) {
+            // the crop is of the bottom-up frame, like with any packed RGB.
+            p.top = (vi.height >> s.yshift) - 1 - p.top;
+            p.step = -p.step;
+        }
+        planes.push_back(p);
+
+        const int last_row = p.top + (p.rows - 1) * p.step;
+        firstByte = std::min<int64_t>(firstByte, p.srcOffset
+            + std::min(p.top, last_row) * p.srcPitch + p.left);
+        lastByte = std::max<int64_t>(lastByte, p.srcOffset
+            + std::max(p.top, last_row) * p.srcPitch + p.left + p.fetchSize);
+        src += p.srcPitch * (vi.height >> s.yshift);
+        dst += p.rowSize * p.rows;
+    }
+    frameSize = static_cast<size_t>(dst);
+}
+
+
+static void add_request(std::vector<read_request>& batch, uint8_t* buff,
+                        size_t size, int64_t pos)
+{
+    if (!batch.empty()) {
+        read_request& last = batch.back();
+        if (last.buff + last.size == buff
+                && last.pos + static_cast<int64_t>(last.size) == pos) {
+            last.size += size;
+            return;
+        }
+    }
+    batch.push_back({buff, size, pos});
+}
+
+
+/*
+  Adds the reads of [offset, offset + size) of the cropped frame into buff
+  to batch, one per row, or fewer where rows are next to each other in
+  both. Row padding and bytes outside the frame are zeroed here.
+*/
+void FrameCrop::map(std::vector<read_request>& batch, uint8_t* buff,
+                    size_t size, int64_t offset, int64_t frame_pos)
+const noexcept
+{
+    const int64_t end = offset + static_cast<int64_t>(size);
+    if (offset < 0) {
+        memset(buff, 0, static_cast<size_t>(std::min<int64_t>(-offset, size)));
+    }
+    if (end > static_cast<int64_t>(frameSize)) {
+        const int64_t from = std::max<int64_t>(offset, frameSize);
+        memset(buff + (from - offset), 0, static_cast<size_t>(end - from));
+    }
+
+    for (const auto& p : planes) {
+        const int64_t plane_end = p.dstOffset
+            + static_cast<int64_t>(p.rowSize) * p.rows;
+        int64_t v = std::max(offset, p.dstOffset);
+        const int64_t stop = std::min(end, plane_end);
+        while (v < stop) {
+            const int64_t row = (v - p.dstOffset) / p.rowSize;
+            const size_t col = static_cast<size_t>((v - p.dstOffset)
+                                                   % p.rowSize);
+            const size_t n = static_cast<size_t>(std::min<int64_t>(
+                p.rowSize - col, stop - v));
+            uint8_t* dstp = buff + (v - offset);
+            const size_t real = col < p.fetchSize
+                                ? std::min(n, p.fetchSize - col) : 0;
+            if (real > 0) {
+                add_request(batch, dstp, real, frame_pos + p.srcOffset
+                            + (p.top + row * p.step) * p.srcPitch + p.left
+                            + col);
+            }
+            if (real < n) {
+                memset(dstp + real, 0, n - real);
+            }
+            v += n;
+        }
+    }
+}
+
+
+/*
+  Adds the reads of the source bytes which the crop uses from the frame at
+  frame_pos. They go to the same offsets in buff as in the frame, so buff
+  can be read with a MemoryReader and a CropReader like the file.
+*/
+void FrameCrop::add_frame(std::vector<read_request>& batch, uint8_t* buff,
+                          int64_t frame_pos) const
+{
+    for (const auto& p : planes) {
+        for (int y = 0; y < p.rows; ++y) {
+            const int64_t offset = p.srcOffset
+                + (p.top + y * p.step) * p.srcPitch + p.left;
+            add_request(batch, buff + offset, p.fetchSize, frame_pos + offset);
+        }
+    }
+}
+
+
+static size_t total_size(const std::vector<read_request>& batch) noexcept
+{
+    size_t total = 0;
+    for (const auto& r : batch) {
+        total += r.size;
+    }
+    return total;
+}
+
+
+// returns size less the bytes which were not read.
+size_t CropReader::fetch(uint8_t* buff, size_t size, int64_t pos) noexcept
+{
+    static thread_local std::vector<read_request> batch;
+    batch.clear();
+    crop.map(batch, buff, size, pos - framePos, framePos);
+    const size_t requested = total_size(batch);
+    return size - (requested - reader.read_batch(batch.data(), batch.size()));
+}
+
+
+size_t CropReader::read(uint8_t* buff, size_t size, int64_t pos) noexcept
+{
+    return fetch(buff, size, pos);
+}
+
+
+/*
+  If the range is in one piece in the source (e.g. whole rows of a crop of
+  the top and bottom only), it comes from the reader as it is, without a
+  copy with mmap. Otherwise the pieces are read into buff.
+*/
+const uint8_t* CropReader::get(uint8_t* buff, size_t size, int64_t pos)
+noexcept
+{
+    if (!buff) {
+        static thread_local std::vector<uint8_t> fallback;
+        fallback.resize(size);
+        buff = fallback.data();
+    }
+
+    static thread_local std::vector<read_request> batch;
+    batch.clear();
+    crop.map(batch, buff, size, pos - framePos, framePos);
+    if (batch.size() == 1 && batch[0].size == size) {
+        return reader.get(buff, size, batch[0].pos);
+    }
+    reader.read_batch(batch.data(), batch.size());
+    return buff;
+}
+
+
+size_t CropReader::read_batch(const read_request* reqs, size_t count)
+noexcept
+{
+    static thread_local std::vector<read_request> batch;
+    batch.clear();
+    size_t size = 0;
+    for (size_t i = 0; i < count; ++i) {
+        crop.map(batch, reqs[i].buff, reqs[i].size, reqs[i].pos - framePos,
+                 framePos);
+        size += reqs[i].size;
+    }
+    const size_t requested = total_size(batch);
+    return size - (requested - reader.read_batch(batch.data(), batch.size()));
+}
@@ -0,0 +1,102 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#ifndef RAWSOURCE_FRAME_CROP_H
+#define RAWSOURCE_FRAME_CROP_H
+
+
+#include "common.h"
+
+
+enum {
+    FIELD_NONE,
+    FIELD_TOP,
+    FIELD_BOTTOM,
+};
+
+
+/*
+  A plane of the cropped frame and where its rows are in the source frame.
+  Offsets are from the start of a frame. Only fetchSize bytes of a row
+  come from the source, the rest of rowSize is row padding (v210, r210).
+  step is negative when the rows are taken from the last one up.
+*/
+struct crop_plane {
+    int64_t srcOffset;
+    int64_t dstOffset;
+    size_t srcPitch;
+    size_t rowSize;
+    size_t fetchSize;
+    size_t left;
+    int top;
+    int step;
+    int rows;
+};
+
+
+/*
+  Describes a region of the source frames (and optionally one field of
+  it) as a frame of the same pixel format, laid out like a raw frame of
+  that size. The kernels convert that frame through a CropReader, which
+  reads only the rows and the bytes of a row inside the region.
+  With flip the rows of the source are read from the last one up, for
+  packed RGB which is stored top-down (MOV).
+*/
+class FrameCrop {
+
+    std::vector<crop_plane> planes;
+    int cropWidth;
+    int cropHeight;
+    size_t frameSize;
+    int64_t firstByte;
+    int64_t lastByte;
+
+public:
+    FrameCrop(const pixel_format& fmt, const VideoInfo& vi, int left, int top,
+              int right, int bottom, int field, bool flip);
+
+    int width() const noexcept { return cropWidth; }
+    int height() const noexcept { return cropHeight; }
+    size_t size() const noexcept { return frameSize; }
+    int64_t first() const noexcept { return firstByte; }
+    int64_t last() const noexcept { return lastByte; }
+
+    void map(std::vector<read_request>& batch, uint8_t* buff, size_t size,
+             int64_t offset, int64_t frame_pos) const noexcept;
+    void add_frame(std::vector<read_request>& batch, uint8_t* buff,
+                   int64_t frame_pos) const;
+};
+
+
+/*
+  Serves the cropped frame at framePos from reader. All reads of a
+  request (a row each, or a plane if rows are whole) are passed on as one
+  batch, so they can be in flight together.
+*/
+class CropReader : public RawReader {
+
+    RawReader& reader;
+    const FrameCrop& crop;
+    int64_t framePos;
+
+    size_t fetch(uint8_t* buff, size_t size, int64_t pos) noexcept;
+
+public:
+    CropReader(RawReader& rd, const FrameCrop& c, int64_t pos) :
+        reader(rd), crop(c), framePos(pos) {}
+
+    size_t read(uint8_t* buff, size_t size, int64_t pos) noexcept override;
+    const uint8_t* get(uint8_t* buff, size_t size, int64_t pos)
+        noexcept override;
+    size_t read_batch(const read_request* reqs, size_t count)
+        noexcept override;
+};
+
+#endif //RAWSOURCE_FRAME_CROP_H
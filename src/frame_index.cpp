@@ -0,0 +1,120 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <algorithm>
+#include "frame_index.h"
+
+
+static inline int64_t
+run_pos(const frame_run& r, int n, char* type) noexcept
+{
+    const int64_t i = n - r.frame;
+    if (i == 0) {
+        if (type) *type = r.type;
+        return r.pos;
+    }
+    if (r.period == 0) {
+        if (type) *type = r.stepType;
+        return r.pos + i * r.delta;
+    }
+    const int64_t m = i / r.period;
+    const int64_t k = i % r.period;
+    if (type) *type = k == 0 ? 'B' : r.stepType;
+    return r.pos + m * r.bigDelta + k * r.delta;
+}
+
+
+/*
+  Tries to put frames [frame, frame + n) at pos, pos + stride, ... into
+  the last run. The first frame is of type, the others are 'D'.
+  Returns how many of them follow the pattern of the run.
+*/
+int FrameIndex::extend(int frame, int64_t pos, char type, int n,
+                       int64_t stride) noexcept
+{
+    if (runs.empty() || frame != numFrames) {
+        return 0;
+    }
+
+    frame_run& r = runs.back();
+    const int64_t i = frame - r.frame;
+
+    if (i == 1) {
+        // the second frame gives the step.
+        if (type == 'B') {
+            return 0;
+        }
+        r.delta = pos - r.pos;
+        r.stepType = type;
+    } else if (r.period == 0 && type == 'B' && r.stepType == 'D') {
+        // the first big step gives the period.
+        r.period = static_cast<int32_t>(i);
+        r.bigDelta = pos - r.pos;
+    } else {
+        char t;
+        if (run_pos(r, frame, &t) != pos || t != type) {
+            return 0;
+        }
+    }
+
+    int accepted = 1;
+    if (n > 1 && r.stepType == 'D' && r.delta == stride) {
+        int64_t fit = n - 1;
+        if (r.period > 0) {
+            fit = std::min<int64_t>(fit, r.period - 1 - i % r.period);
+        }
+        accepted += static_cast<int>(fit);
+    }
+    numFrames = frame + accepted;
+    return accepted;
+}
+
+
+void FrameIndex::add(int frame, int64_t pos, char type, int n,
+                     int64_t stride)
+{
+    for (int i = 0; i < n; ) {
+        const int64_t p = pos + i * stride;
+        const char t = i == 0 ? type : 'D';
+        int done = extend(frame + i, p, t, n - i, stride);
+        if (done == 0) {
+            frame_run r = {};
+            r.pos = p;
+            r.frame = frame + i;
+            r.type = t;
+            runs.push_back(r);
+            numFrames = frame + i + 1;
+            done = 1;
+        }
+        i += done;
+    }
+    first = runs.data();
+    count = runs.size();
+}
+
+
+// uses runs which are kept elsewhere (a mapped index cache).
+void FrameIndex::assign(const frame_run* r, size_t n, int num_frames)
+noexcept
+{
+    runs.clear();
+    first = r;
+    count = n;
+    numFrames = num_frames;
+}
+
+
+int64_t FrameIndex::lookup(int n, char* type) const noexcept
+{
+    const frame_run* end = first + count;
+    const frame_run* r = std::upper_bound(first, end, n,
+        [](int v, const frame_run& x) { return v < x.frame; });
+    return run_pos(*(r - 1), n, type);
+}
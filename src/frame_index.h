@@ -0,0 +1,67 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#ifndef RAWSOURCE_FRAME_INDEX_H
+#define RAWSOURCE_FRAME_INDEX_H
+
+
+#include <cstdint>
+#include <vector>
+
+
+/*
+  A run of frames whose positions are arithmetic.
+  Frame i of the run (i = n - frame) is at
+    pos + (i / period) * bigDelta + (i % period) * delta
+  (pos + i * delta if period is 0). The first frame has type, the first
+  frame of every following period is a 'B' frame, the others stepType.
+*/
+struct frame_run {
+    int64_t pos;
+    int64_t delta;
+    int64_t bigDelta;
+    int32_t frame;
+    int32_t period;
+    char type;
+    char stepType;
+    char reserved[6];
+};
+
+
+/*
+  Position of every frame, kept as runs instead of one entry per frame.
+  Frames are added in order and merged into the last run while they
+  follow its pattern, so a regular file of any length takes a few runs.
+  Lookup is a binary search over the runs.
+*/
+class FrameIndex {
+
+    std::vector<frame_run> runs;
+    const frame_run* first;
+    size_t count;
+    int numFrames;
+
+    int extend(int frame, int64_t pos, char type, int n, int64_t stride)
+        noexcept;
+
+public:
+    FrameIndex() : first(nullptr), count(0), numFrames(0) {}
+
+    void add(int frame, int64_t pos, char type, int n = 1,
+             int64_t stride = 0);
+    void assign(const frame_run* r, size_t n, int num_frames) noexcept;
+
+    int64_t lookup(int n, char* type = nullptr) const noexcept;
+    int frames() const noexcept { return numFrames; }
+    const frame_run* data() const noexcept { return first; }
+    size_t size() const noexcept { return count; }
+};
+
+#endif //RAWSOURCE_FRAME_INDEX_H
@@ -0,0 +1,300 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include "frame_stats.h"
+
+
+static const char* const STAGE_NAMES[] = {"seek", "read", "convert", "total"};
+
+static const char* const ACCESS_NAMES[] = {
+    "sequential", "reverse", "repeat", "random"
+};
+
+
+// bucket 0 is below 1us, bucket i is from 2^(i-1) up to 2^i us.
+static int bucket_of(int64_t ns) noexcept
+{
+    int64_t us = ns / 1000;
+    int b = 0;
+    while (us > 0 && b < FrameStats::BUCKETS - 1) {
+        us >>= 1;
+        ++b;
+    }
+    return b;
+}
+
+
+static double ms(int64_t ns) noexcept
+{
+    return ns / 1000000.0;
+}
+
+
+FrameStats::FrameStats() :
+    frames(0), bytes(0), shortReads(0), cacheHits(0), frameCacheHits(0),
+    frameCacheMisses(0), lastFrame(-1),
+    lastAccess(ACCESS_SEQUENTIAL), created(std::chrono::steady_clock::now())
+{
+    for (int s = 0; s < STAGE_COUNT; ++s) {
+        time[s] = 0;
+        for (int b = 0; b < BUCKETS; ++b) {
+            histogram[s][b] = 0;
+        }
+    }
+    for (int a = 0; a < ACCESS_COUNT; ++a) {
+        accesses[a] = 0;
+    }
+}
+
+
+void FrameStats::add(int n, const frame_sample& s) noexcept
+{
+    const int prev = lastFrame.exchange(n, std::memory_order_relaxed);
+    const int a = n == prev + 1 ? ACCESS_SEQUENTIAL
+                : n == prev - 1 ? ACCESS_REVERSE
+                : n == prev ? ACCESS_REPEAT : ACCESS_RANDOM;
+    ++accesses[a];
+    lastAccess.store(a, std::memory_order_relaxed);
+
+    const int64_t t[STAGE_COUNT] = {s.seek, s.read, s.convert, s.total};
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        time[i].fetch_add(t[i], std::memory_order_relaxed);
+        histogram[i][bucket_of(t[i])].fetch_add(1, std::memory_order_relaxed);
+    }
+    bytes.fetch_add(s.bytes, std::memory_order_relaxed);
+    shortReads.fetch_add(s.shortReads, std::memory_order_relaxed);
+    if (s.cacheHit) {
+        cacheHits.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (s.frameCacheHit) {
+        frameCacheHits.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (s.frameCacheMiss) {
+        frameCacheMisses.fetch_add(1, std::memory_order_relaxed);
+    }
+    frames.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+// p is 0 to 100. returns milliseconds.
+double FrameStats::percentile(stage st, double p) const noexcept
+{
+    int64_t total = 0;
+    int64_t counts[BUCKETS];
+    for (int b = 0; b < BUCKETS; ++b) {
+        counts[b] = histogram[st][b].load(std::memory_order_relaxed);
+        total += counts[b];
+    }
+    if (total == 0) {
+        return 0.0;
+    }
+
+    const int64_t rank = std::max<int64_t>(
+        static_cast<int64_t>(total * p / 100.0 + 0.5), 1);
+    int64_t seen = 0;
+    for (int b = 0; b < BUCKETS; ++b) {
+        seen += counts[b];
+        if (seen >= rank) {
+            return (static_cast<int64_t>(1) << b) / 1000.0;
+        }
+    }
+    return (static_cast<int64_t>(1) << (BUCKETS - 1)) / 1000.0;
+}
+
+
+/*
+  Lines added to the show=true overlay: this frame's times, then the
+  50th, 90th and 99th percentile of all frames so far.
+*/
+std::string FrameStats::overlay(const frame_sample& s) const
+{
+    char line[160];
+    std::string text;
+
+    sprintf(line, "\nseek %.2f  read %.2f  conv %.2f  total %.2f ms",
+            ms(s.seek), ms(s.read), ms(s.convert), ms(s.total));
+    text += line;
+
+    for (int i = STAGE_READ; i < STAGE_COUNT; ++i) {
+        const stage st = static_cast<stage>(i);
+        sprintf(line, "\n%-7s p50 <%.3f  p90 <%.3f  p99 <%.3f ms",
+                STAGE_NAMES[i], percentile(st, 50), percentile(st, 90),
+                percentile(st, 99));
+        text += line;
+    }
+
+    const int64_t f = std::max<int64_t>(frames.load(), 1);
+    const double secs = time[STAGE_TOTAL].load() / 1e9;
+    sprintf(line, "\n%.1f MB/s  short %" PRIi64 "  hits %" PRIi64 "/%" PRIi64
+            "  %s", secs > 0 ? bytes.load() / secs / 1048576.0 : 0.0,
+            shortReads.load(), cacheHits.load(), f,
+            ACCESS_NAMES[lastAccess.load()]);
+    text += line;
+    return text;
+}
+
+
+/*
+  Script variables which runtime filters (ScriptClip etc.) can read after
+  a frame has been requested. The RawSource_last_* values are of the last
+  frame, the others are totals of all frames. GetFrame() of several
+  threads would otherwise leave a mix of their frames.
+*/
+void FrameStats::set_vars(const frame_sample& s, ise_t* env) const
+{
+    std::lock_guard<std::mutex> lock(varsMtx);
+    env->SetGlobalVar("RawSource_frames",
+                      AVSValue(static_cast<int>(frames.load())));
+    env->SetGlobalVar("RawSource_mbytes",
+                      AVSValue(static_cast<float>(bytes.load() / 1048576.0)));
+    env->SetGlobalVar("RawSource_short_reads",
+                      AVSValue(static_cast<int>(shortReads.load())));
+    env->SetGlobalVar("RawSource_cache_hits",
+                      AVSValue(static_cast<int>(cacheHits.load())));
+    env->SetGlobalVar("RawSource_frame_cache_hits",
+                      AVSValue(static_cast<int>(frameCacheHits.load())));
+    env->SetGlobalVar("RawSource_frame_cache_misses",
+                      AVSValue(static_cast<int>(frameCacheMisses.load())));
+    env->SetGlobalVar("RawSource_access",
+                      AVSValue(ACCESS_NAMES[lastAccess.load()]));
+    env->SetGlobalVar("RawSource_last_seek_ms",
+                      AVSValue(static_cast<float>(ms(s.seek))));
+    env->SetGlobalVar("RawSource_last_read_ms",
+                      AVSValue(static_cast<float>(ms(s.read))));
+    env->SetGlobalVar("RawSource_last_convert_ms",
+                      AVSValue(static_cast<float>(ms(s.convert))));
+    env->SetGlobalVar("RawSource_last_total_ms",
+                      AVSValue(static_cast<float>(ms(s.total))));
+    env->SetGlobalVar("RawSource_read_p99_ms",
+                      AVSValue(static_cast<float>(percentile(STAGE_READ,
+                                                             99))));
+    env->SetGlobalVar("RawSource_convert_p99_ms",
+                      AVSValue(static_cast<float>(percentile(STAGE_CONVERT,
+                                                             99))));
+}
+
+
+// writes a text summary of all frames, with the full histograms.
+bool FrameStats::dump(const char* path, const char* source) const noexcept
+{
+    FILE* fp = fopen(path, "w");
+    if (!fp) {
+        return false;
+    }
+
+    const int64_t f = frames.load();
+    const double wall = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - created).count();
+    const double busy = time[STAGE_TOTAL].load() / 1e9;
+
+    fprintf(fp, "source: %s\n", source);
+    fprintf(fp, "frames: %" PRIi64 "\n", f);
+    fprintf(fp, "bytes: %" PRIi64 "\n", bytes.load());
+    fprintf(fp, "short_reads: %" PRIi64 "\n", shortReads.load());
+    fprintf(fp, "cache_hits: %" PRIi64 "\n", cacheHits.load());
+    fprintf(fp, "frame_cache_hits: %" PRIi64 "\n", frameCacheHits.load());
+    fprintf(fp, "frame_cache_misses: %" PRIi64 "\n", frameCacheMisses.load());
+    fprintf(fp, "clip_lifetime_s: %.3f\n", wall);
+    fprintf(fp, "getframe_time_s: %.3f\n", busy);
+    fprintf(fp, "throughput_mb_s: %.2f\n",
+            busy > 0 ? bytes.load() / busy / 1048576.0 : 0.0);
+    for (int a = 0; a < ACCESS_COUNT; ++a) {
+        fprintf(fp, "access_%s: %" PRIi64 "\n", ACCESS_NAMES[a],
+                accesses[a].load());
+    }
+
+    fprintf(fp, "\nstage    mean_ms   p50_ms   p90_ms   p99_ms\n");
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        const stage st = static_cast<stage>(i);
+        fprintf(fp, "%-8s %8.3f %8.3f %8.3f %8.3f\n", STAGE_NAMES[i],
+                f > 0 ? ms(time[i].load()) / f : 0.0, percentile(st, 50),
+                percentile(st, 90), percentile(st, 99));
+    }
+
+    fprintf(fp, "\nhistogram (frames per latency bucket)\nup_to_us");
+    for (int i = 0; i < STAGE_COUNT; ++i) {
+        fprintf(fp, " %10s", STAGE_NAMES[i]);
+    }
+    fprintf(fp, "\n");
+    for (int b = 0; b < BUCKETS; ++b) {
+        int64_t row[STAGE_COUNT];
+        bool any = false;
+        for (int i = 0; i < STAGE_COUNT; ++i) {
+            row[i] = histogram[i][b].load();
+            any = any || row[i] > 0;
+        }
+        if (!any) {
+            continue;
+        }
+        fprintf(fp, "%8" PRIi64, static_cast<int64_t>(1) << b);
+        for (int i = 0; i < STAGE_COUNT; ++i) {
+            fprintf(fp, " %10" PRIi64, row[i]);
+        }
+        fprintf(fp, "\n");
+    }
+
+    return fclose(fp) == 0;
+}
+
+
+void CountingReader::add_read(size_t size, size_t got) noexcept
+{
+    sample.bytes += got;
+    if (got < size) {
+        ++sample.shortReads;
+    }
+}
+
+
+// bytes beyond limit are not in the source, whatever the reader returns.
+static size_t available(int64_t limit, size_t size, int64_t pos) noexcept
+{
+    return static_cast<size_t>(std::max<int64_t>(
+        std::min<int64_t>(size, limit - pos), 0));
+}
+
+
+size_t CountingReader::read(uint8_t* buff, size_t size, int64_t pos) noexcept
+{
+    const int64_t t = FrameStats::now();
+    const size_t got = reader.read(buff, size, pos);
+    sample.read += FrameStats::now() - t;
+    add_read(size, got);
+    return got;
+}
+
+
+const uint8_t* CountingReader::get(uint8_t* buff, size_t size, int64_t pos)
+noexcept
+{
+    const int64_t t = FrameStats::now();
+    const uint8_t* p = reader.get(buff, size, pos);
+    sample.read += FrameStats::now() - t;
+    add_read(size, available(limit, size, pos));
+    return p;
+}
+
+
+size_t CountingReader::read_batch(const read_request* reqs, size_t count)
+noexcept
+{
+    const int64_t t = FrameStats::now();
+    const size_t got = reader.read_batch(reqs, count);
+    sample.read += FrameStats::now() - t;
+    size_t size = 0;
+    for (size_t i = 0; i < count; ++i) {
+        size += reqs[i].size;
+    }
+    add_read(size, got);
+    return got;
+}
@@ -0,0 +1,129 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#ifndef RAWSOURCE_FRAME_STATS_H
+#define RAWSOURCE_FRAME_STATS_H
+
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include "common.h"
+
+
+/*
+  What one GetFrame() call spent. Times are in nanoseconds.
+  seek is everything before the conversion starts (index lookup, waiting
+  for a live file or a prefetched frame), read is the time spent inside
+  the reader, convert is the rest of writeDestFrame. With mmap the pages
+  are faulted in while the kernel converts, so that counts as convert.
+  cacheHit is a frame from the prefetcher, frameCacheHit one from the
+  frame cache (cache_mem), which was not read or converted again.
+*/
+struct frame_sample {
+    int64_t seek;
+    int64_t read;
+    int64_t convert;
+    int64_t total;
+    int64_t bytes;
+    int shortReads;
+    bool cacheHit;
+    bool frameCacheHit;
+    bool frameCacheMiss;
+};
+
+
+/*
+  Counters and latency histograms of all GetFrame() calls of a clip.
+  Every counter is atomic, so frames of several threads are added
+  without a lock. The script variables are set under one, so that they
+  are all of the same frame. Latencies go into power of two buckets of
+  microseconds, percentiles are the upper bound of the bucket they fall
+  into.
+*/
+class FrameStats {
+public:
+    enum stage {
+        STAGE_SEEK,
+        STAGE_READ,
+        STAGE_CONVERT,
+        STAGE_TOTAL,
+        STAGE_COUNT,
+    };
+
+    enum access {
+        ACCESS_SEQUENTIAL,
+        ACCESS_REVERSE,
+        ACCESS_REPEAT,
+        ACCESS_RANDOM,
+        ACCESS_COUNT,
+    };
+
+    static constexpr int BUCKETS = 32;
+
+private:
+    std::atomic<int64_t> frames;
+    std::atomic<int64_t> bytes;
+    std::atomic<int64_t> shortReads;
+    std::atomic<int64_t> cacheHits;
+    std::atomic<int64_t> frameCacheHits;
+    std::atomic<int64_t> frameCacheMisses;
+    std::atomic<int64_t> time[STAGE_COUNT];
+    std::atomic<int64_t> histogram[STAGE_COUNT][BUCKETS];
+    std::atomic<int64_t> accesses[ACCESS_COUNT];
+    std::atomic<int> lastFrame;
+    std::atomic<int> lastAccess;
+    const std::chrono::steady_clock::time_point created;
+    mutable std::mutex varsMtx;
+
+public:
+    FrameStats();
+
+    static int64_t now() noexcept
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void add(int n, const frame_sample& s) noexcept;
+    double percentile(stage st, double p) const noexcept;
+    std::string overlay(const frame_sample& s) const;
+    void set_vars(const frame_sample& s, ise_t* env) const;
+    bool dump(const char* path, const char* source) const noexcept;
+};
+
+
+/*
+  Passes the reads of one frame on to another reader, and counts their
+  time, their bytes and the short ones into a frame_sample. A batch which
+  comes back short counts as one short read. get() does not say how much
+  it got, so it is short when it ends beyond limit (the end of the data).
+*/
+class CountingReader : public RawReader {
+
+    RawReader& reader;
+    int64_t limit;
+    frame_sample& sample;
+
+    void add_read(size_t size, size_t got) noexcept;
+
+public:
+    CountingReader(RawReader& rd, int64_t lim, frame_sample& s) :
+        reader(rd), limit(lim), sample(s) {}
+
+    size_t read(uint8_t* buff, size_t size, int64_t pos) noexcept override;
+    const uint8_t* get(uint8_t* buff, size_t size, int64_t pos)
+        noexcept override;
+    size_t read_batch(const read_request* reqs, size_t count)
+        noexcept override;
+};
+
+#endif //RAWSOURCE_FRAME_STATS_H
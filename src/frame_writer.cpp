@@ -0,0 +1,224 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <algorithm>
+#include <malloc.h>
+#include "frame_writer.h"
+
+
+// WriteFile() takes a DWORD size. a multiple of every sector size.
+constexpr size_t MAX_WRITE_SIZE = 1 << 30;
+
+
+FrameWriter::FrameWriter(const char* path, size_t buffer_size, int depth,
+                         bool use_direct) :
+    useDirect(use_direct), sectorSize(1), bufferSize(buffer_size),
+    stop(false), error(false), fileEnd(0)
+{
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (useDirect) {
+        flags |= FILE_FLAG_NO_BUFFERING;
+    }
+    fileHandle = CreateFile(path, GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                            CREATE_ALWAYS, flags, nullptr);
+    validate(fileHandle == INVALID_HANDLE_VALUE, "Cannot create the file.");
+    if (useDirect) {
+        sectorSize = get_sector_size(path);
+    }
+
+    // a buffer starts pos % sectorSize bytes into its slot, so that the
+    // whole sectors of it are aligned in memory as well.
+    const size_t align = std::max<size_t>(sectorSize, 64);
+    slots.reserve(depth);
+    for (int i = 0; i < depth; ++i) {
+        uint8_t* slot = reinterpret_cast<uint8_t*>(
+            _aligned_malloc(bufferSize + sectorSize, align));
+        if (!slot) {
+            break;
+        }
+        slots.push_back(slot);
+    }
+    if (slots.empty()) {
+        CloseHandle(fileHandle);
+        throw std::runtime_error("failed to allocate write buffer.");
+    }
+    freeSlots = slots;
+
+    worker = std::thread(&FrameWriter::run, this);
+}
+
+
+// the queued buffers are written before the file is closed.
+FrameWriter::~FrameWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop = true;
+    }
+    writeCond.notify_all();
+    worker.join();
+
+    finish();
+    CloseHandle(fileHandle);
+    for (auto slot : slots) {
+        _aligned_free(slot);
+    }
+}
+
+
+// a free buffer for bufferSize bytes which go to pos.
+uint8_t* FrameWriter::acquire(int64_t pos) noexcept
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    freeCond.wait(lock, [this] { return !freeSlots.empty(); });
+    uint8_t* slot = freeSlots.back();
+    freeSlots.pop_back();
+    return slot + pos % static_cast<int64_t>(sectorSize);
+}
+
+
+void FrameWriter::submit(uint8_t* buff, int64_t pos, size_t size) noexcept
+{
+    uint8_t* slot = buff - pos % static_cast<int64_t>(sectorSize);
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        queue.push_back({slot, buff, pos, size});
+    }
+    writeCond.notify_one();
+}
+
+
+bool FrameWriter::write_at(const uint8_t* buff, size_t size, int64_t pos)
+noexcept
+{
+    for (size_t done = 0; done < size; ) {
+        OVERLAPPED ov = {};
+        ov.Offset = static_cast<DWORD>((pos + done) & 0xFFFFFFFF);
+        ov.OffsetHigh = static_cast<DWORD>((pos + done) >> 32);
+        const DWORD req = static_cast<DWORD>(
+            std::min(size - done, MAX_WRITE_SIZE));
+        DWORD written = 0;
+        if (!WriteFile(fileHandle, buff + done, req, &written, &ov)
+                || written == 0) {
+            return false;
+        }
+        done += written;
+    }
+    return true;
+}
+
+
+/*
+  Copies [pos, end) of the file (buff holds pos) into the sector which
+  starts at sector. The sector is written once all of it is there.
+*/
+void FrameWriter::add_partial(int64_t sector, const uint8_t* buff,
+                              int64_t pos, int64_t end) noexcept
+{
+    auto& p = partial[sector];
+    if (!p.first) {
+        p.first = reinterpret_cast<uint8_t*>(
+            _aligned_malloc(sectorSize, sectorSize));
+        if (!p.first) {
+            partial.erase(sector);
+            error = true;
+            return;
+        }
+        memset(p.first, 0, sectorSize);
+        p.second = 0;
+    }
+    memcpy(p.first + (pos - sector), buff, static_cast<size_t>(end - pos));
+    p.second += static_cast<size_t>(end - pos);
+
+    if (p.second == sectorSize) {
+        if (!write_at(p.first, sectorSize, sector)) {
+            error = true;
+        }
+        _aligned_free(p.first);
+        partial.erase(sector);
+    }
+}
+
+
+void FrameWriter::write(const job& j) noexcept
+{
+    const int64_t end = j.pos + static_cast<int64_t>(j.size);
+    fileEnd = std::max(fileEnd, end);
+    if (!useDirect) {
+        if (!write_at(j.buff, j.size, j.pos)) {
+            error = true;
+        }
+        return;
+    }
+
+    // [first, last) are the whole sectors of the buffer.
+    const int64_t sector = static_cast<int64_t>(sectorSize);
+    const int64_t first = (j.pos + sector - 1) / sector * sector;
+    const int64_t last = end / sector * sector;
+    if (first < last && !write_at(j.buff + (first - j.pos),
+                                  static_cast<size_t>(last - first), first)) {
+        error = true;
+    }
+    if (j.pos < std::min(first, end)) {
+        add_partial(j.pos / sector * sector, j.buff, j.pos,
+                    std::min(first, end));
+    }
+    if (first <= last && last < end) {
+        add_partial(last, j.buff + (last - j.pos), last, end);
+    }
+}
+
+
+/*
+  With direct, the sectors which are still incomplete (the last one, and
+  those next to frames which were never written) are written as they
+  are, and the file is cut to the end of the data.
+*/
+void FrameWriter::finish() noexcept
+{
+    if (!useDirect) {
+        return;
+    }
+    for (auto& p : partial) {
+        if (!write_at(p.second.first, sectorSize, p.first)) {
+            error = true;
+        }
+        _aligned_free(p.second.first);
+    }
+    partial.clear();
+
+    LARGE_INTEGER li;
+    li.QuadPart = fileEnd;
+    if (!SetFilePointerEx(fileHandle, li, nullptr, FILE_BEGIN)
+            || !SetEndOfFile(fileHandle)) {
+        error = true;
+    }
+}
+
+
+void FrameWriter::run() noexcept
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        writeCond.wait(lock, [this] { return stop || !queue.empty(); });
+        if (queue.empty()) {
+            return;
+        }
+        const job j = queue.front();
+        queue.pop_front();
+
+        lock.unlock();
+        write(j);
+        lock.lock();
+
+        freeSlots.push_back(j.slot);
+        freeCond.notify_one();
+    }
+}
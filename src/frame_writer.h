@@ -0,0 +1,76 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#ifndef RAWSOURCE_FRAME_WRITER_H
+#define RAWSOURCE_FRAME_WRITER_H
+
+
+#include <condition_variable>
+#include <deque>
+#include "common.h"
+
+
+/*
+  Background writer of RawWrite. A caller packs a frame into a buffer of
+  a small ring (acquire()) and hands it over with submit(), a worker
+  thread writes it at its position while the caller goes on. A caller
+  only waits when all buffers are still queued.
+  With direct, the file is written without the system cache. The whole
+  sectors of a buffer are written straight from it, the sectors which it
+  shares with its neighbours are collected until they are complete. The
+  file is cut to its length when the writer is closed.
+*/
+class FrameWriter {
+
+    struct job {
+        uint8_t* slot;
+        uint8_t* buff;
+        int64_t pos;
+        size_t size;
+    };
+
+    HANDLE fileHandle;
+    const bool useDirect;
+    size_t sectorSize;
+    const size_t bufferSize;
+
+    std::vector<uint8_t*> slots;
+    std::vector<uint8_t*> freeSlots;
+    std::deque<job> queue;
+    std::mutex mtx;
+    std::condition_variable writeCond;
+    std::condition_variable freeCond;
+    std::thread worker;
+    bool stop;
+    std::atomic<bool> error;
+
+    // only used by the worker.
+    std::unordered_map<int64_t, std::pair<uint8_t*, size_t>> partial;
+    int64_t fileEnd;
+
+    bool write_at(const uint8_t* buff, size_t size, int64_t pos) noexcept;
+    void add_partial(int64_t sector, const uint8_t* buff, int64_t pos,
+                     int64_t end) noexcept;
+    void write(const job& j) noexcept;
+    void finish() noexcept;
+    void run() noexcept;
+
+public:
+    FrameWriter(const char* path, size_t buffer_size, int depth,
+                bool use_direct);
+    ~FrameWriter();
+
+    uint8_t* acquire(int64_t pos) noexcept;
+    void submit(uint8_t* buff, int64_t pos, size_t size) noexcept;
+    bool failed() const noexcept { return error; }
+    size_t buffer_size() const noexcept { return bufferSize; }
+};
+
+#endif //RAWSOURCE_FRAME_WRITER_H
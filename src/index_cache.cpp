@@ -0,0 +1,208 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <algorithm>
+#include <string>
+#include "index_cache.h"
+
+
+static const char CACHE_MAGIC[8] = {'R', 'S', 'I', 'D', 'X', 0, 0, 0};
+constexpr uint32_t CACHE_VERSION = 2;
+
+
+struct cache_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t entrySize;
+    index_key key;
+    int32_t numFrames;
+    int32_t numRuns;
+};
+
+
+static bool get_file_stat(const char* path, int64_t& size, int64_t& time)
+noexcept
+{
+    WIN32_FILE_ATTRIBUTE_DATA fa;
+    if (!GetFileAttributesEx(path, GetFileExInfoStandard, &fa)) {
+        return false;
+    }
+    size = (static_cast<int64_t>(fa.nFileSizeHigh) << 32) | fa.nFileSizeLow;
+    time = (static_cast<int64_t>(fa.ftLastWriteTime.dwHighDateTime) << 32)
+           | fa.ftLastWriteTime.dwLowDateTime;
+    return true;
+}
+
+
+// FNV-1a
+static uint64_t hash_string(const char* str) noexcept
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (; *str; ++str) {
+        h = (h ^ static_cast<uint8_t>(*str)) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+
+bool IndexCache::make_key(index_key& key, const char* source,
+                          const char* index, int width, int height,
+                          const char* pix_type, size_t framesize) noexcept
+{
+    memset(&key, 0, sizeof(key));
+
+    if (!get_file_stat(source, key.sourceSize, key.sourceTime)) {
+        return false;
+    }
+    // same rule as set_rawindex(): a string with a dot is a file name.
+    if (strchr(index, '.')
+            && !get_file_stat(index, key.indexSize, key.indexTime)) {
+        return false;
+    }
+    key.indexHash = hash_string(index);
+    key.frameSize = static_cast<int64_t>(framesize);
+    key.width = width;
+    key.height = height;
+    strncpy(key.pixType, pix_type, sizeof(key.pixType) - 1);
+    return true;
+}
+
+
+void IndexCache::close() noexcept
+{
+    if (view) {
+        UnmapViewOfFile(view);
+        view = nullptr;
+    }
+    if (mapping) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+    }
+    if (fileHandle != INVALID_HANDLE_VALUE) {
+        CloseHandle(fileHandle);
+        fileHandle = INVALID_HANDLE_VALUE;
+    }
+}
+
+
+/*
+  Maps the sidecar at path and points index to it. Returns false if there
+  is no usable sidecar (missing, broken or built for another key).
+  The index stays valid while this object lives.
+*/
+bool IndexCache::load(const char* path, const index_key& key,
+                      FrameIndex& index) noexcept
+{
+    close();
+
+    fileHandle = CreateFile(path, GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fileHandle, &size)
+            || size.QuadPart < static_cast<int64_t>(sizeof(cache_header))) {
+        close();
+        return false;
+    }
+
+    mapping = CreateFileMapping(fileHandle, nullptr, PAGE_READONLY, 0, 0,
+                                nullptr);
+    if (mapping) {
+        view = reinterpret_cast<const uint8_t*>(
+            MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (!view) {
+        close();
+        return false;
+    }
+
+    const cache_header* hdr = reinterpret_cast<const cache_header*>(view);
+    const frame_run* runs = reinterpret_cast<const frame_run*>(hdr + 1);
+    const int num_frames = hdr->numFrames;
+    const int num_runs = hdr->numRuns;
+    bool valid = !memcmp(hdr->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC))
+        && hdr->version == CACHE_VERSION
+        && hdr->entrySize == sizeof(frame_run)
+        && !memcmp(&hdr->key, &key, sizeof(key))
+        && num_frames > 0 && num_runs > 0
+        && size.QuadPart == static_cast<int64_t>(sizeof(cache_header)
+                                + num_runs * sizeof(frame_run))
+        && runs[0].frame == 0 && runs[num_runs - 1].frame < num_frames;
+    for (int i = 1; valid && i < num_runs; ++i) {
+        valid = runs[i - 1].frame < runs[i].frame;
+    }
+    if (valid) {
+        index.assign(runs, num_runs, num_frames);
+        valid = index.lookup(num_frames - 1) + key.frameSize
+                <= key.sourceSize;
+    }
+    if (!valid) {
+        index.assign(nullptr, 0, 0);
+        close();
+    }
+    return valid;
+}
+
+
+/*
+  Writes the sidecar. It is written to a temporary file which then
+  replaces the old one, so a reader never sees a half written sidecar.
+  Failures (e.g. a read-only directory) are ignored, the index is just
+  built again next time.
+*/
+void IndexCache::save(const char* path, const index_key& key,
+                      const FrameIndex& index) noexcept
+{
+    cache_header hdr = {};
+    memcpy(hdr.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    hdr.version = CACHE_VERSION;
+    hdr.entrySize = sizeof(frame_run);
+    hdr.key = key;
+    hdr.numFrames = index.frames();
+    hdr.numRuns = static_cast<int32_t>(index.size());
+
+    std::string tmp = std::string(path) + ".tmp";
+    HANDLE fh = CreateFile(tmp.c_str(), GENERIC_WRITE, 0, nullptr,
+                           CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fh == INVALID_HANDLE_VALUE) {
+        return;
+    }
+
+    bool ok = true;
+    const uint8_t* data[] = {
+        reinterpret_cast<const uint8_t*>(&hdr),
+        reinterpret_cast<const uint8_t*>(index.data())
+    };
+    const size_t sizes[] = {
+        sizeof(hdr), index.size() * sizeof(frame_run)
+    };
+    for (int i = 0; i < 2 && ok; ++i) {
+        for (size_t done = 0; done < sizes[i]; ) {
+            DWORD req = static_cast<DWORD>(
+                std::min<size_t>(sizes[i] - done, 1 << 30));
+            DWORD written = 0;
+            if (!WriteFile(fh, data[i] + done, req, &written, nullptr)
+                    || written == 0) {
+                ok = false;
+                break;
+            }
+            done += written;
+        }
+    }
+    CloseHandle(fh);
+
+    if (!ok || !MoveFileEx(tmp.c_str(), path, MOVEFILE_REPLACE_EXISTING)) {
+        DeleteFile(tmp.c_str());
+    }
+}
@@ -0,0 +1,65 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#ifndef RAWSOURCE_INDEX_CACHE_H
+#define RAWSOURCE_INDEX_CACHE_H
+
+
+#include "common.h"
+
+
+/*
+  What a cached index was built from. A sidecar is used only if all of
+  these are the same as now, so touching the source or the index file,
+  or opening it with other parameters, rebuilds the index.
+*/
+struct index_key {
+    int64_t sourceSize;
+    int64_t sourceTime;
+    int64_t indexSize;      // index file, 0 if index is given as a string
+    int64_t indexTime;
+    uint64_t indexHash;     // of the index argument
+    int64_t frameSize;
+    int32_t width;
+    int32_t height;
+    char pixType[16];
+};
+
+
+/*
+  Binary sidecar of the frame index ("<source>.rsidx").
+  A sidecar is a small header followed by the frame_run array as it is in
+  memory, so reopening maps it and uses it in place instead of parsing the
+  index or scanning the stream again.
+*/
+class IndexCache {
+
+    HANDLE fileHandle;
+    HANDLE mapping;
+    const uint8_t* view;
+
+    void close() noexcept;
+
+public:
+    IndexCache() :
+        fileHandle(INVALID_HANDLE_VALUE), mapping(nullptr), view(nullptr) {}
+    ~IndexCache() { close(); }
+
+    static bool make_key(index_key& key, const char* source,
+                         const char* index, int width, int height,
+                         const char* pix_type, size_t framesize) noexcept;
+
+    bool load(const char* path, const index_key& key,
+              FrameIndex& index) noexcept;
+    static void save(const char* path, const index_key& key,
+                     const FrameIndex& index) noexcept;
+};
+
+#endif //RAWSOURCE_INDEX_CACHE_H
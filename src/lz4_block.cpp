@@ -0,0 +1,237 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "lz4_block.h"
+
+
+constexpr int LZ4_HASH_LOG = 16;
+constexpr size_t LZ4_MIN_MATCH = 4;
+constexpr size_t LZ4_MAX_OFFSET = 65535;
+// a match starts at least 12 bytes and ends at least 5 bytes before the
+// end of a block, the rest are literals.
+constexpr size_t LZ4_MF_LIMIT = 12;
+constexpr size_t LZ4_LAST_LITERALS = 5;
+
+
+static inline uint32_t load32(const uint8_t* p) noexcept
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+
+static inline uint64_t load64(const uint8_t* p) noexcept
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+
+static inline uint32_t hash4(uint32_t v) noexcept
+{
+    return (v * 2654435761U) >> (32 - LZ4_HASH_LOG);
+}
+
+
+// the length field of a token: 15 and a run of 255 bytes for the rest.
+static inline uint8_t* put_length(uint8_t* op, size_t len) noexcept
+{
+    for (; len >= 255; len -= 255) {
+        *op++ = 255;
+    }
+    *op++ = static_cast<uint8_t>(len);
+    return op;
+}
+
+
+// the bytes a sequence of lit literals and a match of mlen takes.
+static inline size_t sequence_size(size_t lit, size_t mlen) noexcept
+{
+    return 1 + (lit >= 15 ? (lit - 15) / 255 + 1 : 0) + lit
+           + (mlen > 0 ? 2 + (mlen - 4 >= 15 ? (mlen - 19) / 255 + 1 : 0)
+                       : 0);
+}
+
+
+/*
+  Greedy compression with one hash table of the last position of every
+  4 byte sequence. The further a search gets without a match, the larger
+  its steps, so incompressible data goes through quickly.
+*/
+size_t lz4_compress(const uint8_t* src, size_t size, uint8_t* dst,
+                    size_t capacity) noexcept
+{
+    static thread_local std::vector<uint32_t> table;
+    table.assign(static_cast<size_t>(1) << LZ4_HASH_LOG, 0);
+
+    const uint8_t* ip = src;
+    const uint8_t* anchor = src;
+    const uint8_t* const end = src + size;
+    uint8_t* op = dst;
+    uint8_t* const oend = dst + capacity;
+
+    if (size > LZ4_MF_LIMIT) {
+        const uint8_t* const mflimit = end - LZ4_MF_LIMIT;
+        const uint8_t* const matchlimit = end - LZ4_LAST_LITERALS;
+        ++ip;
+        while (ip <= mflimit) {
+            const uint32_t seq = load32(ip);
+            const uint32_t h = hash4(seq);
+            const uint8_t* ref = src + table[h];
+            table[h] = static_cast<uint32_t>(ip - src);
+            if (ref >= ip || static_cast<size_t>(ip - ref) > LZ4_MAX_OFFSET
+                    || load32(ref) != seq) {
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                --ip;
+                --ref;
+            }
+            const uint8_t* mp = ip + LZ4_MIN_MATCH;
+            const uint8_t* rp = ref + LZ4_MIN_MATCH;
+            while (mp + 8 <= matchlimit && load64(mp) == load64(rp)) {
+                mp += 8;
+                rp += 8;
+            }
+            while (mp < matchlimit && *mp == *rp) {
+                ++mp;
+                ++rp;
+            }
+
+            const size_t lit = static_cast<size_t>(ip - anchor);
+            const size_t mlen = static_cast<size_t>(mp - ip);
+            if (sequence_size(lit, mlen) > static_cast<size_t>(oend - op)) {
+                return 0;
+            }
+            uint8_t* token = op++;
+            *token = static_cast<uint8_t>(std::min<size_t>(lit, 15) << 4);
+            if (lit >= 15) {
+                op = put_length(op, lit - 15);
+            }
+            memcpy(op, anchor, lit);
+            op += lit;
+            const size_t offset = static_cast<size_t>(ip - ref);
+            *op++ = static_cast<uint8_t>(offset);
+            *op++ = static_cast<uint8_t>(offset >> 8);
+            *token |= static_cast<uint8_t>(std::min<size_t>(mlen - 4, 15));
+            if (mlen - 4 >= 15) {
+                op = put_length(op, mlen - 19);
+            }
+
+            if (mp - 2 > ip) {
+                table[hash4(load32(mp - 2))] =
+                    static_cast<uint32_t>(mp - 2 - src);
+            }
+            ip = anchor = mp;
+        }
+    }
+
+    const size_t lit = static_cast<size_t>(end - anchor);
+    if (sequence_size(lit, 0) > static_cast<size_t>(oend - op)) {
+        return 0;
+    }
+    *op++ = static_cast<uint8_t>(std::min<size_t>(lit, 15) << 4);
+    if (lit >= 15) {
+        op = put_length(op, lit - 15);
+    }
+    memcpy(op, anchor, lit);
+    op += lit;
+    return static_cast<size_t>(op - dst);
+}
+
+
+// the rest of a length field, false if it runs past the block.
+static inline bool get_length(const uint8_t*& ip, const uint8_t* iend,
+                              size_t& len) noexcept
+{
+    unsigned b;
+    do {
+        if (ip >= iend) {
+            return false;
+        }
+        b = *ip++;
+        len += b;
+    } while (b == 255);
+    return true;
+}
+
+
+bool lz4_decompress(const uint8_t* src, size_t src_size, uint8_t* dst,
+                    size_t size) noexcept
+{
+    const uint8_t* ip = src;
+    const uint8_t* const iend = src + src_size;
+    uint8_t* op = dst;
+    uint8_t* const oend = dst + size;
+
+    while (ip < iend) {
+        const unsigned token = *ip++;
+        size_t lit = token >> 4;
+        if (lit == 15 && !get_length(ip, iend, lit)) {
+            return false;
+        }
+        if (lit > static_cast<size_t>(iend - ip)
+                || lit > static_cast<size_t>(oend - op)) {
+            return false;
+        }
+        // most runs are short, a copy of a fixed size is much faster than
+        // one of any size. the bytes after the run are written again.
+        if (lit <= 16 && iend - ip >= 16 && oend - op >= 16) {
+            memcpy(op, ip, 16);
+        } else {
+            memcpy(op, ip, lit);
+        }
+        op += lit;
+        ip += lit;
+        if (ip == iend) {
+            break;
+        }
+
+        if (iend - ip < 2) {
+            return false;
+        }
+        const size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        size_t len = token & 15;
+        if (len == 15 && !get_length(ip, iend, len)) {
+            return false;
+        }
+        len += LZ4_MIN_MATCH;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst)
+                || len > static_cast<size_t>(oend - op)) {
+            return false;
+        }
+
+        // a match closer than its length repeats the bytes from ref, so
+        // they are copied in blocks which do not overlap.
+        const uint8_t* ref = op - offset;
+        if (offset >= 16 && static_cast<size_t>(oend - op) >= len + 16) {
+            for (size_t i = 0; i < len; i += 16) {
+                memcpy(op + i, ref + i, 16);
+            }
+            op += len;
+            continue;
+        }
+        while (len > 0) {
+            const size_t n = std::min(len, static_cast<size_t>(op - ref));
+            memcpy(op, ref, n);
+            op += n;
+            len -= n;
+        }
+    }
+    return op == oend;
+}
@@ -0,0 +1,32 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#ifndef RAWSOURCE_LZ4_BLOCK_H
+#define RAWSOURCE_LZ4_BLOCK_H
+
+
+#include <cstddef>
+#include <cstdint>
+
+
+/*
+  The LZ4 block format (no frame header or checksum), so that archives
+  need no library and any LZ4 block decoder can read their chunks.
+  lz4_compress() returns the compressed size, or 0 if the result would
+  not fit into capacity bytes. lz4_decompress() fails unless src decodes
+  to exactly size bytes; a broken block never writes outside of dst.
+*/
+size_t lz4_compress(const uint8_t* src, size_t size, uint8_t* dst,
+                    size_t capacity) noexcept;
+
+bool lz4_decompress(const uint8_t* src, size_t src_size, uint8_t* dst,
+                    size_t size) noexcept;
+
+#endif //RAWSOURCE_LZ4_BLOCK_H
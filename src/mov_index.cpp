@@ -0,0 +1,285 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <algorithm>
+#include <climits>
+#include "mov_index.h"
+
+
+// a moov atom larger than this is taken as a broken file.
+constexpr int64_t MOV_MOOV_MAX = 256 << 20;
+
+
+/*
+  Uncompressed QuickTime codecs and their pixel_type. depth tells 'raw '
+  RGB apart, 0 matches any. Codecs which are named like a pixel_type
+  (e.g. I420, NV12, AYUV) need no entry. The rows are stored top-down.
+*/
+static const struct {
+    const char* codec;
+    int depth;
+    const char* pixType;
+} mov_codecs[] = {
+    {"2vuy",  0, "UYVY"},
+    {"yuvs",  0, "YUY2"},
+    {"y420",  0, "I420"},
+    {"raw ", 24, "RGB" },
+    {"raw ", 32, "ARGB"},
+};
+
+
+static const char* mov_error = "MOV sample table error.";
+
+
+// the payload of an atom.
+struct mov_box {
+    const uint8_t* data;
+    size_t size;
+};
+
+
+static uint32_t be32(const uint8_t* p) noexcept
+{
+    return (static_cast<uint32_t>(p[0]) << 24) | (p[1] << 16) | (p[2] << 8)
+           | p[3];
+}
+
+
+static uint64_t be64(const uint8_t* p) noexcept
+{
+    return (static_cast<uint64_t>(be32(p)) << 32) | be32(p + 4);
+}
+
+
+// the first child of parent which has type, or {nullptr, 0}.
+static mov_box find_box(const mov_box& parent, const char* type,
+                        size_t from = 0)
+{
+    size_t pos = from;
+    while (pos + 8 <= parent.size) {
+        const uint8_t* p = parent.data + pos;
+        uint64_t size = be32(p);
+        size_t header = 8;
+        if (size == 1) {
+            validate(pos + 16 > parent.size, mov_error);
+            size = be64(p + 8);
+            header = 16;
+        } else if (size == 0) {
+            size = parent.size - pos;
+        }
+        validate(size < header || size > parent.size - pos, mov_error);
+        if (!memcmp(p + 4, type, 4)) {
+            return {p + header, static_cast<size_t>(size) - header};
+        }
+        pos += static_cast<size_t>(size);
+    }
+    return {nullptr, 0};
+}
+
+
+// payload of a full atom with at least size bytes after version/flags.
+static const uint8_t* full_box(const mov_box& box, size_t size)
+{
+    validate(!box.data || box.size < 4 + size, mov_error);
+    return box.data + 4;
+}
+
+
+static uint32_t gcd(uint32_t a, uint32_t b) noexcept
+{
+    while (b != 0) {
+        const uint32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+
+/*
+  Reads the top level atoms up to the moov atom. Only the atom headers
+  are read, so an mdat before it is skipped whatever its size.
+*/
+static void read_moov(SourceReader& rd, int64_t filesize,
+                      std::vector<uint8_t>& moov)
+{
+    int64_t pos = 0;
+    while (pos + 8 <= filesize) {
+        uint8_t header[16] = {};
+        rd.read(header, 16, pos);
+        int64_t size = be32(header);
+        int64_t header_size = 8;
+        if (size == 1) {
+            size = static_cast<int64_t>(be64(header + 8));
+            header_size = 16;
+        } else if (size == 0) {
+            size = filesize - pos;
+        }
+        validate(size < header_size || size > filesize - pos,
+                 "MOV atom error.");
+
+        if (!memcmp(header + 4, "moov", 4)) {
+            validate(size - header_size > MOV_MOOV_MAX, "moov is too large.");
+            moov.resize(static_cast<size_t>(size - header_size));
+            validate(rd.read(moov.data(), moov.size(), pos + header_size)
+                     < moov.size(), "MOV atom error.");
+            return;
+        }
+        pos += size;
+    }
+    throw std::runtime_error("moov atom is not found.");
+}
+
+
+static void read_sample_entry(const mov_box& stsd, mov_track& track)
+{
+    // the first entry: size, format, 6 reserved, data reference index,
+    // then the visual sample description.
+    const uint8_t* p = full_box(stsd, 4 + 86);
+    validate(be32(p) < 1, mov_error);
+    const uint8_t* entry = p + 4;
+    memcpy(track.codec, entry + 4, 4);
+    track.codec[4] = '\0';
+    track.width = (entry[32] << 8) | entry[33];
+    track.height = (entry[34] << 8) | entry[35];
+    const int depth = (entry[82] << 8) | entry[83];
+
+    track.pixType[0] = '\0';
+    for (const auto& c : mov_codecs) {
+        if (!strcmp(track.codec, c.codec) && (!c.depth || c.depth == depth)) {
+            strcpy(track.pixType, c.pixType);
+            return;
+        }
+    }
+    if (find_pixel_format(track.codec)) {
+        strcpy(track.pixType, track.codec);
+    }
+}
+
+
+// the frame rate is the most used sample duration of stts.
+static void read_frame_rate(const mov_box& mdhd, const mov_box& stts,
+                            mov_track& track)
+{
+    // version 1 has 64bit creation and modification times.
+    const bool v1 = mdhd.data && mdhd.size > 0 && mdhd.data[0] == 1;
+    const uint8_t* p = full_box(mdhd, v1 ? 20 : 12);
+    const uint32_t timescale = be32(p + (v1 ? 16 : 8));
+
+    p = full_box(stts, 4);
+    const uint32_t entries = be32(p);
+    validate(entries > (stts.size - 8) / 8, mov_error);
+    uint32_t delta = 0;
+    uint32_t most = 0;
+    for (uint32_t i = 0; i < entries; ++i) {
+        const uint32_t count = be32(p + 4 + i * 8);
+        if (count > most) {
+            most = count;
+            delta = be32(p + 8 + i * 8);
+        }
+    }
+    validate(timescale == 0 || delta == 0, "MOV frame rate error.");
+
+    const uint32_t d = gcd(timescale, delta);
+    track.fpsNum = timescale / d;
+    track.fpsDen = delta / d;
+}
+
+
+/*
+  Frame offsets from the sample tables: stco/co64 give the position of
+  each chunk, stsc the number of frames in it, stsz their sizes. The
+  frames of a chunk follow each other.
+*/
+static void read_offsets(const mov_box& stbl, mov_track& track,
+                         FrameIndex& index)
+{
+    const mov_box stsz = find_box(stbl, "stsz");
+    const mov_box stsc = find_box(stbl, "stsc");
+    mov_box stco = find_box(stbl, "stco");
+    const bool co64 = stco.data == nullptr;
+    if (co64) {
+        stco = find_box(stbl, "co64");
+    }
+
+    const uint8_t* sz = full_box(stsz, 8);
+    const uint32_t uniform = be32(sz);
+    const uint32_t samples = be32(sz + 4);
+    validate(samples == 0, "the video track has no frames.");
+    validate(samples > INT_MAX
+             || (uniform == 0 && samples > (stsz.size - 12) / 4), mov_error);
+
+    const uint8_t* sc = full_box(stsc, 4);
+    const uint32_t sc_entries = be32(sc);
+    validate(sc_entries == 0 || sc_entries > (stsc.size - 8) / 12,
+             mov_error);
+
+    const uint8_t* co = full_box(stco, 4);
+    const uint32_t chunks = be32(co);
+    const size_t co_size = co64 ? 8 : 4;
+    validate(chunks > (stco.size - 8) / co_size, mov_error);
+
+    track.minSampleSize = INT64_MAX;
+    uint32_t n = 0;
+    uint32_t e = 0;
+    for (uint32_t c = 0; c < chunks && n < samples; ++c) {
+        // stsc chunk numbers start at 1.
+        while (e + 1 < sc_entries && be32(sc + 4 + (e + 1) * 12) <= c + 1) {
+            ++e;
+        }
+        const uint32_t per_chunk = be32(sc + 8 + e * 12);
+        int64_t pos = co64 ? static_cast<int64_t>(be64(co + 4 + c * 8))
+                           : be32(co + 4 + c * 4);
+        for (uint32_t i = 0; i < per_chunk && n < samples; ++i, ++n) {
+            const int64_t size = uniform ? uniform : be32(sz + 8 + n * 4);
+            track.minSampleSize = std::min(track.minSampleSize, size);
+            index.add(static_cast<int>(n), pos, 'K');
+            pos += size;
+        }
+    }
+    validate(n < samples, mov_error);
+}
+
+
+/*
+  Builds the exact frame index of the first video track from the sample
+  tables of the moov atom. The frame data itself is not read.
+*/
+void read_mov(SourceReader& rd, int64_t filesize, mov_track& track,
+              FrameIndex& index)
+{
+    std::vector<uint8_t> data;
+    read_moov(rd, filesize, data);
+    const mov_box moov = {data.data(), data.size()};
+
+    size_t from = 0;
+    while (true) {
+        const mov_box trak = find_box(moov, "trak", from);
+        validate(!trak.data, "the MOV file has no video track.");
+        from = static_cast<size_t>(trak.data - moov.data) + trak.size;
+
+        const mov_box mdia = find_box(trak, "mdia");
+        const mov_box hdlr = find_box(mdia, "hdlr");
+        if (!mdia.data || !hdlr.data || hdlr.size < 12
+                || memcmp(hdlr.data + 8, "vide", 4)) {
+            continue;
+        }
+
+        const mov_box minf = find_box(mdia, "minf");
+        const mov_box stbl = find_box(minf, "stbl");
+        validate(!stbl.data, mov_error);
+
+        read_sample_entry(find_box(stbl, "stsd"), track);
+        read_frame_rate(find_box(mdia, "mdhd"), find_box(stbl, "stts"),
+                        track);
+        read_offsets(stbl, track, index);
+        return;
+    }
+}
@@ -0,0 +1,38 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#ifndef RAWSOURCE_MOV_INDEX_H
+#define RAWSOURCE_MOV_INDEX_H
+
+
+#include "common.h"
+
+
+/*
+  The first video track of a QuickTime/MP4 file. pixType is the
+  pixel_type of its codec, empty if it is not an uncompressed one which
+  is known. minSampleSize is the size of the smallest frame of the track,
+  which needs to hold a whole frame of the pixel_type.
+*/
+struct mov_track {
+    int width;
+    int height;
+    unsigned fpsNum;
+    unsigned fpsDen;
+    char codec[5];
+    char pixType[16];
+    int64_t minSampleSize;
+};
+
+
+void read_mov(SourceReader& rd, int64_t filesize, mov_track& track,
+              FrameIndex& index);
+
+#endif //RAWSOURCE_MOV_INDEX_H
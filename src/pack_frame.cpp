@@ -0,0 +1,204 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <cstdint>
+#include "common.h"
+
+
+// the reverse of convert_sample(): shifted to the MSB and byte-swapped.
+static inline uint16_t pack_sample(uint16_t v, bool swap, int shift,
+                                   uint16_t mask)
+{
+    v = static_cast<uint16_t>((v & mask) << shift);
+    if (swap) {
+        v = static_cast<uint16_t>((v >> 8) | (v << 8));
+    }
+    return v;
+}
+
+
+static uint8_t* copy_plane(uint8_t* dstp, const uint8_t* srcp, int pitch,
+                           int rowsize, int height) noexcept
+{
+    for (int y = 0; y < height; ++y) {
+        memcpy(dstp, srcp, rowsize);
+        dstp += rowsize;
+        srcp += pitch;
+    }
+    return dstp;
+}
+
+
+static uint8_t* pack_plane16(uint8_t* dstp, const uint8_t* srcp, int pitch,
+                             int rowsize, int height, int fmt) noexcept
+{
+    if (!sample_needs_conversion(fmt)) {
+        return copy_plane(dstp, srcp, pitch, rowsize, height);
+    }
+
+    const bool swap = (fmt & SAMPLE_BE) != 0;
+    const int shift = sample_shift(fmt);
+    const uint16_t mask = sample_mask(fmt);
+    for (int y = 0; y < height; ++y) {
+        const uint16_t* s = reinterpret_cast<const uint16_t*>(srcp);
+        uint16_t* d = reinterpret_cast<uint16_t*>(dstp);
+        for (int x = 0; x < rowsize / 2; ++x) {
+            d[x] = pack_sample(s[x], swap, shift, mask);
+        }
+        dstp += rowsize;
+        srcp += pitch;
+    }
+    return dstp;
+}
+
+
+static void pack_planar(const PVideoFrame& src, uint8_t* dstp,
+                        const int* order, int count) noexcept
+{
+    for (int i = 0; i < count; ++i) {
+        dstp = copy_plane(dstp, src->GetReadPtr(order[i]),
+                          src->GetPitch(order[i]), src->GetRowSize(order[i]),
+                          src->GetHeight(order[i]));
+    }
+}
+
+
+static void pack_planar16(const PVideoFrame& src, uint8_t* dstp,
+                          const int* order, int count) noexcept
+{
+    for (int i = 0; i < count; ++i) {
+        const int plane = i < 3 ? order[i] : PLANAR_A;
+        dstp = pack_plane16(dstp, src->GetReadPtr(plane),
+                            src->GetPitch(plane), src->GetRowSize(plane),
+                            src->GetHeight(plane), order[3]);
+    }
+}
+
+
+static void pack_packed(const PVideoFrame& src, uint8_t* dstp, const int*,
+                        int) noexcept
+{
+    copy_plane(dstp, src->GetReadPtr(), src->GetPitch(), src->GetRowSize(),
+               src->GetHeight());
+}
+
+
+static void pack_packed_reorder(const PVideoFrame& src, uint8_t* dstp,
+                                const int* order, int count) noexcept
+{
+    const int width = src->GetRowSize();
+    const int height = src->GetHeight();
+    const int pitch = src->GetPitch();
+    const uint8_t* srcp = src->GetReadPtr();
+
+    for (int y = 0; y < height; ++y) {
+        for (int j = 0, time = width / count; j < time; ++j) {
+            for (int k = 0; k < count; ++k) {
+                dstp[j * count + order[k]] = srcp[j * count + k];
+            }
+        }
+        srcp += pitch;
+        dstp += width;
+    }
+}
+
+
+/*
+  The luma plane, then the chroma planes order[1] and order[2] merged
+  into one plane of pairs. count is the bytes per sample.
+*/
+static void pack_semi_planar(const PVideoFrame& src, uint8_t* dstp,
+                             const int* order, int count) noexcept
+{
+    const int fmt = order[3];
+    dstp = pack_plane16(dstp, src->GetReadPtr(PLANAR_Y),
+                        src->GetPitch(PLANAR_Y), src->GetRowSize(PLANAR_Y),
+                        src->GetHeight(PLANAR_Y), fmt);
+
+    const int width = src->GetRowSize(order[1]) / count;
+    const int height = src->GetHeight(order[1]);
+    const int pitch = src->GetPitch(order[1]);
+    const uint8_t* srcp0 = src->GetReadPtr(order[1]);
+    const uint8_t* srcp1 = src->GetReadPtr(order[2]);
+
+    const bool swap = (fmt & SAMPLE_BE) != 0;
+    const int shift = sample_shift(fmt);
+    const uint16_t mask = sample_mask(fmt);
+    for (int y = 0; y < height; ++y) {
+        if (count == 1) {
+            for (int x = 0; x < width; ++x) {
+                dstp[x * 2] = srcp0[x];
+                dstp[x * 2 + 1] = srcp1[x];
+            }
+        } else {
+            const uint16_t* s0 = reinterpret_cast<const uint16_t*>(srcp0);
+            const uint16_t* s1 = reinterpret_cast<const uint16_t*>(srcp1);
+            uint16_t* d = reinterpret_cast<uint16_t*>(dstp);
+            for (int x = 0; x < width; ++x) {
+                d[x * 2] = pack_sample(s0[x], swap, shift, mask);
+                d[x * 2 + 1] = pack_sample(s1[x], swap, shift, mask);
+            }
+        }
+        srcp0 += pitch;
+        srcp1 += pitch;
+        dstp += width * count * 2;
+    }
+}
+
+
+// the Y, U, V (and A) planes merged into count bytes per pixel.
+static void pack_packed444(const PVideoFrame& src, uint8_t* dstp,
+                           const int* order, int count) noexcept
+{
+    static const int planes[] = {PLANAR_Y, PLANAR_U, PLANAR_V, PLANAR_A};
+    const int width = src->GetRowSize(PLANAR_Y);
+    const int height = src->GetHeight(PLANAR_Y);
+    const uint8_t* srcp[4];
+    int pitch[4];
+    for (int k = 0; k < count; ++k) {
+        srcp[k] = src->GetReadPtr(planes[k]);
+        pitch[k] = src->GetPitch(planes[k]);
+    }
+
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            for (int k = 0; k < count; ++k) {
+                dstp[x * count + order[k]] = srcp[k][x];
+            }
+        }
+        for (int k = 0; k < count; ++k) {
+            srcp[k] += pitch[k];
+        }
+        dstp += width * count;
+    }
+}
+
+
+// the packer of the formats which are read by func, or nullptr.
+pack_frame_t get_packer(write_frame_t func) noexcept
+{
+    static const struct {
+        write_frame_t read;
+        pack_frame_t pack;
+    } packers[] = {
+        {write_planar,         pack_planar        },
+        {write_planar16,       pack_planar16      },
+        {write_packed,         pack_packed        },
+        {write_packed_reorder, pack_packed_reorder},
+        {write_semi_planar,    pack_semi_planar   },
+        {write_packed444,      pack_packed444     },
+    };
+    for (const auto& p : packers) {
+        if (p.read == func) {
+            return p.pack;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,278 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <algorithm>
+#include <cstdlib>
+#include <malloc.h>
+#include "prefetch.h"
+
+
+// the most queued frames which are read as one batch.
+constexpr size_t MAX_BATCH_FRAMES = 8;
+
+
+Prefetcher::Prefetcher(SourceReader& rd, const FrameIndex& idx,
+                       int num_frames, size_t framesize, int depth,
+                       const FrameCrop* c) :
+    reader(rd), index(idx), numFrames(num_frames), frameSize(framesize),
+    crop(c),
+    stop(false), lastFrame(-1), lastStride(0), stride(0), nextFrame(0)
+{
+    slots.reserve(depth);
+    for (int i = 0; i < depth; ++i) {
+        uint8_t* buff = reinterpret_cast<uint8_t*>(
+            _aligned_malloc(frameSize, 16));
+        if (!buff) {
+            break;
+        }
+        slots.push_back({-1, SLOT_FREE, buff});
+    }
+    if (slots.empty()) {
+        throw std::runtime_error("failed to allocate prefetch buffer.");
+    }
+
+    worker = std::thread(&Prefetcher::run, this);
+}
+
+
+Prefetcher::~Prefetcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stop = true;
+    }
+    readCond.notify_all();
+    worker.join();
+
+    for (auto& s : slots) {
+        _aligned_free(s.buff);
+    }
+}
+
+
+Prefetcher::slot* Prefetcher::find(int n) noexcept
+{
+    for (auto& s : slots) {
+        if (s.frame == n && s.state != SLOT_FREE) {
+            return &s;
+        }
+    }
+    return nullptr;
+}
+
+
+/*
+  Returns a free slot. If there is none, the slot which is farthest
+  outside the frames ahead of the current position is taken back: behind
+  it, or beyond the read-ahead (e.g. the frames read before a seek back).
+*/
+Prefetcher::slot* Prefetcher::get_free_slot() noexcept
+{
+    const int64_t ahead = static_cast<int64_t>(std::abs(stride))
+                          * static_cast<int64_t>(slots.size());
+    slot* victim = nullptr;
+    int64_t distance = 0;
+    for (auto& s : slots) {
+        if (s.state == SLOT_FREE) {
+            return &s;
+        }
+        if (s.state != SLOT_READY && s.state != SLOT_QUEUED) {
+            continue;
+        }
+        const int64_t d = static_cast<int64_t>(s.frame - lastFrame)
+                          * (stride > 0 ? 1 : -1);
+        const int64_t outside = d < 0 ? -d : d - ahead;
+        if (outside > distance) {
+            victim = &s;
+            distance = outside;
+        }
+    }
+
+    if (victim && victim->state == SLOT_QUEUED) {
+        int i = static_cast<int>(victim - slots.data());
+        queue.erase(std::find(queue.begin(), queue.end(), i));
+    }
+    return victim;
+}
+
+
+/*
+  Called for frames which were not prefetched.
+  Two equal steps in a row start a pattern (1 = sequential, -1 = reverse,
+  others = strided). While a pattern is active, misses close to the
+  current position are reordering by concurrent requests and are
+  ignored. A jump away from it stops read-ahead.
+*/
+void Prefetcher::detect(int n) noexcept
+{
+    const int step = n - lastFrame;
+
+    if (stride != 0) {
+        if (std::abs(step)
+                <= std::abs(stride) * static_cast<int>(slots.size())) {
+            return;
+        }
+        stride = 0;
+        for (auto& s : slots) {
+            if (s.state == SLOT_QUEUED) {
+                s.state = SLOT_FREE;
+            }
+        }
+        queue.clear();
+        // a request waiting for one of them reads it itself.
+        doneCond.notify_all();
+    } else if (step != 0 && step == lastStride) {
+        stride = step;
+        nextFrame = n + stride;
+    }
+
+    lastStride = step;
+    lastFrame = n;
+}
+
+
+// queues the frames of the pattern ahead of the current position.
+void Prefetcher::schedule() noexcept
+{
+    if (stride == 0) {
+        return;
+    }
+
+    const int depth = static_cast<int>(slots.size());
+    if ((nextFrame - lastFrame) * stride <= 0) {
+        nextFrame = lastFrame + stride;
+    }
+
+    while (nextFrame >= 0 && nextFrame < numFrames
+            && (nextFrame - lastFrame) / stride <= depth) {
+        if (!find(nextFrame)) {
+            slot* s = get_free_slot();
+            if (!s) {
+                break;
+            }
+            s->frame = nextFrame;
+            s->state = SLOT_QUEUED;
+            queue.push_back(static_cast<int>(s - slots.data()));
+        }
+        nextFrame += stride;
+    }
+
+    readCond.notify_one();
+}
+
+
+/*
+  The frames in the queue are taken together (up to MAX_BATCH_FRAMES) and
+  read as one batch, so that the reads of several frames are in flight
+  at once.
+*/
+void Prefetcher::run() noexcept
+{
+    std::vector<read_request> batch;
+    std::vector<slot*> reading;
+    batch.reserve(MAX_BATCH_FRAMES);
+    reading.reserve(MAX_BATCH_FRAMES);
+
+    std::unique_lock<std::mutex> lock(mtx);
+
+    while (true) {
+        readCond.wait(lock, [this] { return stop || !queue.empty(); });
+        if (stop) {
+            return;
+        }
+
+        batch.clear();
+        reading.clear();
+        while (!queue.empty() && reading.size() < MAX_BATCH_FRAMES) {
+            slot& s = slots[queue.front()];
+            queue.pop_front();
+            const int64_t pos = index.lookup(s.frame);
+            if (pos + static_cast<int64_t>(frameSize) > reader.size()) {
+                // not written yet (live source). it is read when requested.
+                s.state = SLOT_FREE;
+                s.frame = -1;
+                doneCond.notify_all();
+                continue;
+            }
+            s.state = SLOT_READING;
+            if (crop) {
+                crop->add_frame(batch, s.buff, pos);
+            } else {
+                batch.push_back({s.buff, frameSize, pos});
+            }
+            reading.push_back(&s);
+        }
+        if (reading.empty()) {
+            continue;
+        }
+
+        lock.unlock();
+        reader.read_batch(batch.data(), batch.size());
+        lock.lock();
+
+        for (auto s : reading) {
+            s->state = SLOT_READY;
+        }
+        doneCond.notify_all();
+    }
+}
+
+
+/*
+  Returns the raw data of frame n if it has been prefetched (waiting for
+  a read in flight), or nullptr if the caller has to read it itself.
+  A returned buffer stays valid until release(n).
+*/
+const uint8_t* Prefetcher::acquire(int n) noexcept
+{
+    std::unique_lock<std::mutex> lock(mtx);
+
+    slot* s = find(n);
+    if (!s || s->state == SLOT_IN_USE) {
+        detect(n);
+        schedule();
+        return nullptr;
+    }
+
+    if (s->state == SLOT_QUEUED) {
+        // wanted right now, so it is read next.
+        int i = static_cast<int>(s - slots.data());
+        queue.erase(std::find(queue.begin(), queue.end(), i));
+        queue.push_front(i);
+    }
+    doneCond.wait(lock, [s] {
+        return s->state != SLOT_QUEUED && s->state != SLOT_READING;
+    });
+    if (s->frame != n || s->state != SLOT_READY) {
+        return nullptr;
+    }
+
+    s->state = SLOT_IN_USE;
+    if ((n - lastFrame) * stride > 0) {
+        lastFrame = n;
+    }
+    schedule();
+    return s->buff;
+}
+
+
+void Prefetcher::release(int n) noexcept
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    for (auto& s : slots) {
+        if (s.frame == n && s.state == SLOT_IN_USE) {
+            s.state = SLOT_FREE;
+            s.frame = -1;
+            break;
+        }
+    }
+    schedule();
+}
@@ -0,0 +1,80 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#ifndef RAWSOURCE_PREFETCH_H
+#define RAWSOURCE_PREFETCH_H
+
+
+#include <condition_variable>
+#include <deque>
+#include "common.h"
+#include "frame_crop.h"
+
+
+/*
+  Background read-ahead of raw frame data.
+  The requested frame numbers are watched for a sequential, reverse or
+  strided pattern. While a pattern holds, a worker thread reads the next
+  frames of the pattern into a bounded ring of buffers, and GetFrame()
+  converts from an already filled buffer instead of reading the file.
+  With a crop only the bytes of the crop are read into the buffer.
+*/
+class Prefetcher {
+
+    enum slot_state {
+        SLOT_FREE,
+        SLOT_QUEUED,
+        SLOT_READING,
+        SLOT_READY,
+        SLOT_IN_USE,
+    };
+
+    struct slot {
+        int frame;
+        slot_state state;
+        uint8_t* buff;
+    };
+
+    SourceReader& reader;
+    const FrameIndex& index;
+    const int numFrames;
+    const size_t frameSize;
+    const FrameCrop* crop;
+
+    std::vector<slot> slots;
+    std::deque<int> queue;
+    std::mutex mtx;
+    std::condition_variable readCond;
+    std::condition_variable doneCond;
+    std::thread worker;
+    bool stop;
+
+    int lastFrame;
+    int lastStride;
+    int stride;
+    int nextFrame;
+
+    slot* find(int n) noexcept;
+    slot* get_free_slot() noexcept;
+    void detect(int n) noexcept;
+    void schedule() noexcept;
+    void run() noexcept;
+
+public:
+    Prefetcher(SourceReader& rd, const FrameIndex& idx,
+               int num_frames, size_t framesize, int depth,
+               const FrameCrop* c);
+    ~Prefetcher();
+
+    const uint8_t* acquire(int n) noexcept;
+    void release(int n) noexcept;
+};
+
+#endif //RAWSOURCE_PREFETCH_H
@@ -0,0 +1,312 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <cstdio>
+#include <algorithm>
+#include <memory>
+#include "common.h"
+#include "frame_writer.h"
+#include "frame_archive.h"
+#include "raw_write.h"
+
+
+// the default number of write buffers: one frame is packed while two
+// are written.
+constexpr int DEFAULT_WRITE_BUFFERS = 3;
+
+
+/*
+  The pixel_type and the colour tag of a clip which a YUV4MPEG2 file can
+  hold, the ones parse_y4m() reads back. Returns false for the others.
+*/
+static bool get_y4m_format(const VideoInfo& vi, char* pix_type, char* ctag)
+{
+    const int bits = vi.BitsPerComponent();
+    if (!vi.IsPlanar() || vi.IsRGB() || bits > 16) {
+        return false;
+    }
+    if (vi.IsY()) {
+        if (bits == 8) {
+            strcpy(pix_type, "GRAY");
+            strcpy(ctag, "mono");
+        } else {
+            sprintf(pix_type, "GRAY%dLE", bits);
+            sprintf(ctag, "mono%d", bits);
+        }
+        return true;
+    }
+
+    const int ssw = vi.GetPlaneWidthSubsampling(PLANAR_U);
+    const int ssh = vi.GetPlaneHeightSubsampling(PLANAR_U);
+    const char* sub = ssh == 1 && ssw == 1 ? "420"
+                    : ssh == 0 && ssw == 1 ? "422"
+                    : ssh == 0 && ssw == 0 ? "444"
+                    : ssh == 0 && ssw == 2 ? "411" : nullptr;
+    if (!sub) {
+        return false;
+    }
+    if (vi.IsYUVA()) {
+        // only 8bit 4:4:4 has a tag with alpha.
+        if (bits != 8 || ssw != 0) {
+            return false;
+        }
+        strcpy(pix_type, "YUVA444");
+        strcpy(ctag, "444alpha");
+    } else if (bits == 8) {
+        sprintf(pix_type, "I%s", sub);
+        sprintf(ctag, ssh == 1 ? "%sjpeg" : "%s", sub);
+    } else {
+        if (ssw == 2) {
+            return false;
+        }
+        sprintf(pix_type, "YUV%sP%dLE", sub, bits);
+        sprintf(ctag, "%sp%d", sub, bits);
+    }
+    return true;
+}
+
+
+// YV12 and I420 frames are the same to RawWrite.
+static bool same_pixel_type(int a, int b) noexcept
+{
+    auto is420 = [](int t) {
+        return t == VideoInfo::CS_YV12 || t == VideoInfo::CS_I420;
+    };
+    return a == b || (is420(a) && is420(b));
+}
+
+
+/*
+  The plain layout of a clip for y4m=false: the first entry of the table
+  of its pixel type which is read without reordering.
+*/
+static const pixel_format* get_default_format(const VideoInfo& vi) noexcept
+{
+    for (const pixel_format* f = pixel_formats; f->name; ++f) {
+        if (f->avs_pix_type == vi.pixel_type
+                && (f->func == write_packed || f->func == write_planar
+                    || (f->func == write_planar16
+                        && !sample_needs_conversion(f->order[3])))) {
+            return f;
+        }
+    }
+    return nullptr;
+}
+
+
+/*
+  Writes the frames of a clip to a raw or YUV4MPEG2 file in the layout of
+  pixel_type, which RawSource reads back. The frames are passed through,
+  so the clip can be encoded or shown at the same time. Every frame goes
+  to its own position, the order in which they are requested does not
+  matter. Frames which are never requested are left empty.
+  With compress, the file is an archive: every frame is compressed and
+  appended to the data written so far, and the seek table is written
+  when the filter is closed.
+*/
+class RawWrite : public GenericVideoFilter {
+
+    const pixel_format* fmt;
+    pack_frame_t pack;
+    size_t framesize;
+    int64_t headerSize;
+    size_t frameHeader;     // "FRAME\n" with y4m
+    std::unique_ptr<FrameWriter> writer;
+    std::unique_ptr<ArchiveBuilder> archive;
+    BufferPool packBuffers;     // a packed and a compressed frame
+    std::vector<uint8_t> written;
+    std::mutex mtx;
+
+    bool mark(int n);
+    void writeArchive(int n, const PVideoFrame& frame, ise_t* env);
+
+public:
+    RawWrite(PClip c, const char* file, const char* pix_type, bool y4m,
+             int buffers, bool direct, bool compress);
+    ~RawWrite();
+    PVideoFrame __stdcall GetFrame(int n, ise_t* env) override;
+    int __stdcall SetCacheHints(int cachehints, int frame_range) override;
+};
+
+
+RawWrite::RawWrite(PClip c, const char* file, const char* pix_type,
+                   bool y4m, int buffers, bool direct, bool compress) :
+    GenericVideoFilter(c), headerSize(0), frameHeader(0)
+{
+    char y4m_type[32] = {};
+    char ctag[32] = {};
+    const bool y4m_ok = get_y4m_format(vi, y4m_type, ctag);
+    validate(y4m && !y4m_ok, "the clip can not be written to a YUV4MPEG2"
+             " file, use y4m=false.");
+
+    if (pix_type[0] == '\0') {
+        fmt = y4m ? find_pixel_format(y4m_type) : get_default_format(vi);
+    } else {
+        fmt = find_pixel_format(pix_type);
+        validate(!fmt, "Invalid pixel type.");
+    }
+
+    char msg[128];
+    if (!fmt || !same_pixel_type(fmt->avs_pix_type, vi.pixel_type)) {
+        sprintf(msg, "the clip can not be written as pixel_type %s.",
+                fmt ? fmt->name : "");
+        throw std::runtime_error(msg);
+    }
+    if (y4m && stricmp(fmt->name, y4m_type)) {
+        sprintf(msg, "pixel_type of this YUV4MPEG2 file needs to be %s.",
+                y4m_type);
+        throw std::runtime_error(msg);
+    }
+    pack = get_packer(fmt->func);
+    if (!pack) {
+        sprintf(msg, "pixel_type %s can not be written.", fmt->name);
+        throw std::runtime_error(msg);
+    }
+
+    framesize = get_frame_size(vi, *fmt);
+    char header[128] = {};
+    if (compress) {
+        archive.reset(new ArchiveBuilder(vi, *fmt));
+        headerSize = sizeof(archive_header);
+        memcpy(header, &archive->info(), sizeof(archive_header));
+        packBuffers.set_size(framesize * 2);
+    } else if (y4m) {
+        const char field = vi.IsTFF() ? 't' : vi.IsBFF() ? 'b' : 'p';
+        headerSize = sprintf(header,
+                             "YUV4MPEG2 W%d H%d F%u:%u I%c A0:0 C%s\n",
+                             vi.width, vi.height, vi.fps_numerator,
+                             vi.fps_denominator, field, ctag);
+        frameHeader = 6;
+    }
+
+    writer.reset(new FrameWriter(
+        file, std::max(framesize + frameHeader,
+                       static_cast<size_t>(headerSize)),
+        buffers, direct));
+    written.resize(vi.num_frames, 0);
+
+    if (headerSize > 0) {
+        uint8_t* buff = writer->acquire(0);
+        memcpy(buff, header, static_cast<size_t>(headerSize));
+        writer->submit(buff, 0, static_cast<size_t>(headerSize));
+    }
+}
+
+
+// the seek table of an archive goes after the last frame.
+RawWrite::~RawWrite()
+{
+    if (!archive) {
+        return;
+    }
+    try {
+        std::vector<uint8_t> tail;
+        const int64_t pos = archive->finish(tail);
+        const size_t step = writer->buffer_size();
+        for (size_t done = 0; done < tail.size(); done += step) {
+            const size_t size = std::min(step, tail.size() - done);
+            uint8_t* buff = writer->acquire(pos + done);
+            memcpy(buff, tail.data() + done, size);
+            writer->submit(buff, pos + done, size);
+        }
+    } catch (std::bad_alloc&) {
+        // without the seek table the archive can not be opened.
+    }
+}
+
+
+// true the first time frame n is requested.
+bool RawWrite::mark(int n)
+{
+    if (n < 0 || n >= vi.num_frames) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    if (written[n]) {
+        return false;
+    }
+    written[n] = 1;
+    return true;
+}
+
+
+// the frame is compressed before its position is known.
+void RawWrite::writeArchive(int n, const PVideoFrame& frame, ise_t* env)
+{
+    uint8_t* work = packBuffers.acquire();
+    if (!work) {
+        env->ThrowError("RawWrite: failed to allocate buffer.");
+    }
+    pack(frame, work, fmt->order, fmt->cnt);
+    archive_entry entry = {};
+    const size_t size = archive->compress(work, work + framesize, entry);
+    const int64_t pos = archive->add(n, entry, size);
+
+    uint8_t* buff = writer->acquire(pos);
+    memcpy(buff, work + framesize, size);
+    writer->submit(buff, pos, size);
+    packBuffers.release(work);
+}
+
+
+PVideoFrame __stdcall RawWrite::GetFrame(int n, ise_t* env)
+{
+    PVideoFrame frame = child->GetFrame(n, env);
+    if (!mark(n)) {
+        return frame;
+    }
+
+    if (archive) {
+        writeArchive(n, frame, env);
+    } else {
+        const int64_t pos = headerSize
+            + static_cast<int64_t>(n) * (frameHeader + framesize);
+        uint8_t* buff = writer->acquire(pos);
+        memcpy(buff, "FRAME\n", frameHeader);
+        pack(frame, buff + frameHeader, fmt->order, fmt->cnt);
+        writer->submit(buff, pos, frameHeader + framesize);
+    }
+
+    if (writer->failed()) {
+        env->ThrowError("RawWrite: failed to write the file.");
+    }
+    return frame;
+}
+
+
+int __stdcall RawWrite::SetCacheHints(int cachehints, int frame_range)
+{
+    return cachehints == CACHE_GET_MTMODE ? MT_NICE_FILTER : 0;
+}
+
+
+AVSValue __cdecl create_rawwrite(AVSValue args, void* user_data, ise_t* env)
+{
+    try {
+        validate(!args[1].Defined(), "No file specified");
+
+        const char* file = args[1].AsString();
+        const char* pix_type = args[2].AsString("");
+        const bool compress = args[6].AsBool(false);
+        const bool y4m = args[3].AsBool(!compress);
+        const int buffers = args[4].AsInt(DEFAULT_WRITE_BUFFERS);
+        const bool direct = args[5].AsBool(false);
+
+        validate(buffers < 1, "buffers needs to be 1 or higher.");
+        validate(y4m && compress, "y4m can not be used with compress=true.");
+
+        return new RawWrite(args[0].AsClip(), file, pix_type, y4m, buffers,
+                            direct, compress);
+
+    } catch (std::runtime_error& e) {
+        env->ThrowError("RawWrite: %s", e.what());
+    }
+    return 0;
+}
@@ -0,0 +1,20 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#ifndef RAWSOURCE_RAW_WRITE_H
+#define RAWSOURCE_RAW_WRITE_H
+
+
+#include "common.h"
+
+
+AVSValue __cdecl create_rawwrite(AVSValue args, void* user_data, ise_t* env);
+
+#endif //RAWSOURCE_RAW_WRITE_H
@@ -1,262 +1,997 @@
-/*
- RawSource26 - reads raw video data files
-
-    Author: Oka Motofumi (chikuzen.mo at gmail dot com)
-
-    This program is rewriting of RawSource.dll(original author is Ernst Pech)
-    for avisynth2.6x/Avisynth+.
-*/
-
-
-#include <io.h>
-#include <fcntl.h>
-#include <cinttypes>
-#include <malloc.h>
-#include "common.h"
-
-
-
-class RawSource : public IClip {
-
-    VideoInfo vi;
-    int fileHandle;
-    int64_t fileSize;
-    int order[4];
-    int col_count;
-    bool show;
-
-    uint8_t* rawbuf;
-    std::vector<i_struct> index;
-
-    void setProcess(const char* pix_type);
-
-    void(__stdcall *writeDestFrame)(
-        int fd, PVideoFrame& dst, uint8_t* buff, int* order, int count,
-        ise_t* env);
-
-public:
-    RawSource(const char* source, const int width, const int height,
-              const char* pix_type, const int fpsnum, const int fpsden,
-              const char* index, const bool show);
-    PVideoFrame __stdcall GetFrame(int n, ise_t *env);
-
-    ~RawSource() { _close(fileHandle); _aligned_free(rawbuf); }
-    bool __stdcall GetParity(int n) { return vi.image_type == VideoInfo::IT_TFF; }
-    void __stdcall GetAudio(void *buf, int64_t start, int64_t count, ise_t* env) {}
-    const VideoInfo& __stdcall GetVideoInfo() { return vi; }
-    int __stdcall SetCacheHints(int cachehints,int frame_range) { return 0; }
-};
-
-
-void RawSource::setProcess(const char* pix_type)
-{
-    typedef void (__stdcall *write_frame_t)(
-        int, PVideoFrame&, uint8_t*, int*, int, ise_t*);
-
-    const struct {
-        const char *fmt_name;
-        const int avs_pix_type;
-        const int order[4];
-        const int cnt;
-        write_frame_t func;
-    } pixelformats[] = {
-        {"BGR",   VideoInfo::CS_BGR24, {       0,        1,        2, 9}, 3, write_packed        },
-        {"BGR24", VideoInfo::CS_BGR24, {       0,        1,        2, 9}, 3, write_packed        },
-        {"RGB",   VideoInfo::CS_BGR24, {       2,        1,        0, 9}, 3, write_packed_reorder},
-        {"RGB24", VideoInfo::CS_BGR24, {       2,        1,        0, 9}, 3, write_packed_reorder},
-        {"BGRA",  VideoInfo::CS_BGR32, {       0,        1,        2, 3}, 4, write_packed        },
-        {"BGR32", VideoInfo::CS_BGR32, {       0,        1,        2, 3}, 4, write_packed        },
-        {"RGBA",  VideoInfo::CS_BGR32, {       2,        1,        0, 3}, 4, write_packed_reorder},
-        {"RGB32", VideoInfo::CS_BGR32, {       2,        1,        0, 3}, 4, write_packed_reorder},
-        {"ARGB",  VideoInfo::CS_BGR32, {       3,        2,        1, 0}, 4, write_packed_reorder},
-        {"ABGR",  VideoInfo::CS_BGR32, {       3,        0,        1, 2}, 4, write_packed_reorder},
-        {"YUY2",  VideoInfo::CS_YUY2,  {       0,        1,        2, 3}, 4, write_packed        },
-        {"YUYV",  VideoInfo::CS_YUY2,  {       0,        1,        2, 3}, 4, write_packed        },
-        {"UYVY",  VideoInfo::CS_YUY2,  {       1,        0,        3, 2}, 4, write_packed_reorder},
-        {"VYUY",  VideoInfo::CS_YUY2,  {       3,        0,        1, 2}, 4, write_packed_reorder},
-        {"YV24",  VideoInfo::CS_YV24,  {PLANAR_Y, PLANAR_V, PLANAR_U, 0}, 3, write_planar        },
-        {"I444",  VideoInfo::CS_YV24,  {PLANAR_Y, PLANAR_U, PLANAR_V, 0}, 3, write_planar        },
-        {"YV16",  VideoInfo::CS_YV16,  {PLANAR_Y, PLANAR_V, PLANAR_U, 0}, 3, write_planar        },
-        {"I422",  VideoInfo::CS_YV16,  {PLANAR_Y, PLANAR_U, PLANAR_V, 0}, 3, write_planar        },
-        {"YV411", VideoInfo::CS_YV411, {PLANAR_Y, PLANAR_V, PLANAR_U, 0}, 3, write_planar        },
-        {"Y41B",  VideoInfo::CS_YV411, {PLANAR_Y, PLANAR_V, PLANAR_U, 0}, 3, write_planar        },
-        {"I411",  VideoInfo::CS_YV411, {PLANAR_Y, PLANAR_U, PLANAR_V, 0}, 3, write_planar        },
-        {"I420",  VideoInfo::CS_I420,  {PLANAR_Y, PLANAR_U, PLANAR_V, 0}, 3, write_planar        },
-        {"IYUV",  VideoInfo::CS_I420,  {PLANAR_Y, PLANAR_U, PLANAR_V, 0}, 3, write_planar        },
-        {"YV12",  VideoInfo::CS_YV12,  {PLANAR_Y, PLANAR_V, PLANAR_U, 0}, 3, write_planar        },
-        {"NV12",  VideoInfo::CS_I420,  {PLANAR_Y, PLANAR_U, PLANAR_V, 0}, 2, write_NV420         },
-        {"NV21",  VideoInfo::CS_YV12,  {PLANAR_Y, PLANAR_V, PLANAR_U, 0}, 2, write_NV420         },
-        {"Y8",    VideoInfo::CS_Y8,    {PLANAR_Y,        0,        0, 0}, 1, write_planar        },
-        {"GRAY",  VideoInfo::CS_Y8,    {PLANAR_Y,        0,        0, 0}, 1, write_planar        },
-        { pix_type, VideoInfo::CS_UNKNOWN, {0, 0, 0, 0}, 0, nullptr }
-    };
-    int i = 0;
-    while (stricmp(pix_type, pixelformats[i].fmt_name)) ++i;
-
-    validate(pixelformats[i].avs_pix_type == VideoInfo::CS_UNKNOWN,
-             "Invalid pixel type. Supported: RGB, RGBA, BGR, BGRA, ARGB,"
-             " ABGR, YV24, I444, YUY2, YUYV, UYVY, YVYU, VYUY, YV16, I422,"
-             " YV411, Y41B, I411, YV12, I420, IYUV, NV12, NV21, Y8, GRAY");
-
-    vi.pixel_type = pixelformats[i].avs_pix_type;
-    memcpy(order, pixelformats[i].order, sizeof(int) * 4);
-    col_count = pixelformats[i].cnt;
-    writeDestFrame = pixelformats[i].func;
-}
-
-
-RawSource::RawSource (const char *source, const int width, const int height,
-                      const char *ptype, const int fpsnum, const int fpsden,
-                      const char *a_index, const bool s) : show(s)
-{
-    fileHandle = _open(source, _O_BINARY | _O_RDONLY);
-    validate(fileHandle == -1, "Cannot open videofile.");
-
-    fileSize = _filelengthi64(fileHandle);
-    validate(fileSize == -1L, "Cannot get videofile length.");
-
-    memset(&vi, 0, sizeof(VideoInfo));
-    vi.width = width;
-    vi.height = height;
-    vi.SetFPS(fpsnum, fpsden);
-    vi.SetFieldBased(false);
-
-    char pix_type[16] = {};
-    strcpy(pix_type, ptype);
-
-    int64_t header_offset = 0;
-    int64_t frame_offset = 0;
-
-    if (strlen(a_index) == 0) { //use header if valid else width, height, pixel_type from AVS are used
-        std::vector<char> read_buff(256, 0);
-        char* data = read_buff.data();
-        _read(fileHandle, data, read_buff.size()); //read some bytes and test on header
-        bool ret = parse_y4m(read_buff, vi, header_offset, frame_offset);
-
-        if (vi.width > MAX_WIDTH || vi.height > MAX_HEIGHT) {
-            const char* msg = "Resolution too big(%d x %d)."
-                              " Maximum acceptable resolution is %u x %u.";
-            sprintf(data, msg, vi.width, vi.height, MAX_WIDTH, MAX_HEIGHT);
-            throw std::runtime_error(data);
-        }
-
-        if (ret) {
-            strcpy(pix_type, data);
-        }
-    }
-
-    setProcess(pix_type);
-
-    size_t framesize = vi.width * vi.height * vi.BitsPerPixel() / 8;
-
-    int maxframe = static_cast<int>(fileSize / framesize);    //1 = one frame
-
-    validate(maxframe < 1, "File too small for even one frame.");
-
-    //index build using string descriptor
-    std::vector<rindex> rawindex;
-    set_rawindex(rawindex, a_index, header_offset, frame_offset, framesize);
-
-    //create full index and get number of frames.
-    index.resize(maxframe + 1);
-    vi.num_frames = generate_index(index, rawindex, framesize, fileSize);
-
-    rawbuf = reinterpret_cast<uint8_t*>(
-        _aligned_malloc(vi.IsPlanar() ? vi.width * vi.height : framesize, 16));
-    validate(rawbuf == nullptr, "failed to allocate read buffer.");
-}
-
-
-PVideoFrame __stdcall RawSource::GetFrame(int n, ise_t* env)
-{
-    const i_struct* idx = index.data();
-    PVideoFrame dst = env->NewVideoFrame(vi);
-
-    if (_lseeki64(fileHandle, idx[n].index, SEEK_SET) == -1L) {
-        // black frame with message
-        write_black_frame(dst, vi);
-        env->ApplyMessage(&dst, vi, "failed to seek file!", vi.width,
-                          0x00FFFFFF, 0x00FFFFFF, 0);
-        return dst;
-    }
-
-    writeDestFrame(fileHandle, dst, rawbuf, order, col_count, env);
-
-    if (show) { //output debug info
-        char info[64];
-        sprintf(info, "%d : %" PRIi64 " %c", n, idx[n].index, idx[n].type);
-        env->ApplyMessage(&dst, vi, info, vi.width / 2, 0x00FFFFFF, 0, 0);
-    }
-
-    return dst;
-}
-
-
-AVSValue __cdecl create_rawsource(AVSValue args, void* user_data, ise_t* env)
-{
-    char buff[128] = {};
-
-    try {
-        validate(!args[0].Defined(), "No source specified");
-
-        const char *source = args[0].AsString();
-        const int width = args[1].AsInt(720);
-        const int height = args[2].AsInt(576);
-        const char *pix_type = args[3].AsString("YUY2");
-        const int fpsnum = args[4].AsInt(25);
-        const int fpsden = args[5].AsInt(1);
-        const char *index = args[6].AsString("");
-        const bool show = args[7].AsBool(false);
-
-        if (width < MIN_WIDTH || height < MIN_HEIGHT) {
-            sprintf(buff, "width and height need to be %u x %u or lower.",
-                    MIN_WIDTH, MIN_HEIGHT);
-            throw std::runtime_error(buff);
-        }
-        if (width >= MAX_WIDTH || height >= MAX_HEIGHT) {
-            sprintf(buff, "width and height need to be lower than %u x %u.",
-                    MAX_WIDTH, MAX_HEIGHT);
-            throw std::runtime_error(buff);
-        }
-        validate(strlen(pix_type) > 15, "pixel_type is too long.");
-        validate(fpsnum < 1 || fpsden < 1,
-                 "fpsnum and fpsden need to be 1 or higher.");
-
-        return new RawSource(source, width, height, pix_type, fpsnum, fpsden,
-                             index, show);
-
-    } catch (std::runtime_error& e) {
-        env->ThrowError("RawSource: %s", e.what());
-    }
-    return 0;
-}
-
-
-const AVS_Linkage* AVS_linkage = nullptr;
-
-
-extern "C" __declspec(dllexport) const char* __stdcall
-AvisynthPluginInit3(ise_t* env, const AVS_Linkage* const vectors)
-{
-    AVS_linkage = vectors;
-
-    const char* args =
-        "[file]s"
-        "[width]i"
-        "[height]i"
-        "[pixel_type]s"
-        "[fpsnum]i"
-        "[fpsden]i"
-        "[index]s"
-        "[show]b";
-
-    env->AddFunction("RawSource", args, create_rawsource, nullptr);
-
-    if (env->FunctionExists("SetFilterMTMode")) {
-        static_cast<IScriptEnvironment2*>(
-            env)->SetFilterMTMode("RawSource", MT_SERIALIZED, true);
-    }
-
-    return "RawSource for AviSynth2.6x/Avisynth+.";
-}
-
+/*
+ RawSource26 - reads raw video data files
+
+    Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+    This program is rewriting of RawSource.dll(original author is Ernst Pech)
+    for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <cinttypes>
+#include <malloc.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include "common.h"
+#include "prefetch.h"
+#include "index_cache.h"
+#include "frame_stats.h"
+#include "frame_crop.h"
+#include "frame_cache.h"
+#include "audio_index.h"
+#include "mov_index.h"
+#include "frame_archive.h"
+#include "raw_write.h"
+
+
+
+const pixel_format pixel_formats[] = {
+    {"BGR",         VideoInfo::CS_BGR24,     {       0,        1,        2, 9             }, 3, write_packed        },
+    {"BGR24",       VideoInfo::CS_BGR24,     {       0,        1,        2, 9             }, 3, write_packed        },
+    {"RGB",         VideoInfo::CS_BGR24,     {       2,        1,        0, 9             }, 3, write_packed_reorder},
+    {"RGB24",       VideoInfo::CS_BGR24,     {       2,        1,        0, 9             }, 3, write_packed_reorder},
+    {"BGRA",        VideoInfo::CS_BGR32,     {       0,        1,        2, 3             }, 4, write_packed        },
+    {"BGR32",       VideoInfo::CS_BGR32,     {       0,        1,        2, 3             }, 4, write_packed        },
+    {"RGBA",        VideoInfo::CS_BGR32,     {       2,        1,        0, 3             }, 4, write_packed_reorder},
+    {"RGB32",       VideoInfo::CS_BGR32,     {       2,        1,        0, 3             }, 4, write_packed_reorder},
+    {"ARGB",        VideoInfo::CS_BGR32,     {       3,        2,        1, 0             }, 4, write_packed_reorder},
+    {"ABGR",        VideoInfo::CS_BGR32,     {       3,        0,        1, 2             }, 4, write_packed_reorder},
+    {"YUY2",        VideoInfo::CS_YUY2,      {       0,        1,        2, 3             }, 4, write_packed        },
+    {"YUYV",        VideoInfo::CS_YUY2,      {       0,        1,        2, 3             }, 4, write_packed        },
+    {"UYVY",        VideoInfo::CS_YUY2,      {       1,        0,        3, 2             }, 4, write_packed_reorder},
+    {"YVYU",        VideoInfo::CS_YUY2,      {       0,        3,        2, 1             }, 4, write_packed_reorder},
+    {"VYUY",        VideoInfo::CS_YUY2,      {       3,        0,        1, 2             }, 4, write_packed_reorder},
+    {"AYUV",        VideoInfo::CS_YUVA444,   {       1,        2,        3, 0             }, 4, write_packed444     },
+    {"VUYA",        VideoInfo::CS_YUVA444,   {       2,        1,        0, 3             }, 4, write_packed444     },
+    {"v308",        VideoInfo::CS_YV24,      {       1,        2,        0, 0             }, 3, write_packed444     },
+    {"YUVA444",     VideoInfo::CS_YUVA444,   {PLANAR_Y, PLANAR_U, PLANAR_V, PLANAR_A      }, 4, write_planar        },
+    {"YV24",        VideoInfo::CS_YV24,      {PLANAR_Y, PLANAR_V, PLANAR_U, 0             }, 3, write_planar        },
+    {"I444",        VideoInfo::CS_YV24,      {PLANAR_Y, PLANAR_U, PLANAR_V, 0             }, 3, write_planar        },
+    {"YV16",        VideoInfo::CS_YV16,      {PLANAR_Y, PLANAR_V, PLANAR_U, 0             }, 3, write_planar        },
+    {"I422",        VideoInfo::CS_YV16,      {PLANAR_Y, PLANAR_U, PLANAR_V, 0             }, 3, write_planar        },
+    {"YV411",       VideoInfo::CS_YV411,     {PLANAR_Y, PLANAR_V, PLANAR_U, 0             }, 3, write_planar        },
+    {"Y41B",        VideoInfo::CS_YV411,     {PLANAR_Y, PLANAR_V, PLANAR_U, 0             }, 3, write_planar        },
+    {"I411",        VideoInfo::CS_YV411,     {PLANAR_Y, PLANAR_U, PLANAR_V, 0             }, 3, write_planar        },
+    {"I420",        VideoInfo::CS_I420,      {PLANAR_Y, PLANAR_U, PLANAR_V, 0             }, 3, write_planar        },
+    {"IYUV",        VideoInfo::CS_I420,      {PLANAR_Y, PLANAR_U, PLANAR_V, 0             }, 3, write_planar        },
+    {"YV12",        VideoInfo::CS_YV12,      {PLANAR_Y, PLANAR_V, PLANAR_U, 0             }, 3, write_planar        },
+    {"NV12",        VideoInfo::CS_I420,      {PLANAR_Y, PLANAR_U, PLANAR_V, 0             }, 1, write_semi_planar   },
+    {"NV21",        VideoInfo::CS_YV12,      {PLANAR_Y, PLANAR_V, PLANAR_U, 0             }, 1, write_semi_planar   },
+    {"NV16",        VideoInfo::CS_YV16,      {PLANAR_Y, PLANAR_U, PLANAR_V, 0             }, 1, write_semi_planar   },
+    {"P010",        VideoInfo::CS_YUV420P10, {PLANAR_Y, PLANAR_U, PLANAR_V, 10 | SAMPLE_MSB}, 2, write_semi_planar   },
+    {"P016",        VideoInfo::CS_YUV420P16, {PLANAR_Y, PLANAR_U, PLANAR_V, 16            }, 2, write_semi_planar   },
+    {"P210",        VideoInfo::CS_YUV422P10, {PLANAR_Y, PLANAR_U, PLANAR_V, 10 | SAMPLE_MSB}, 2, write_semi_planar   },
+    {"P216",        VideoInfo::CS_YUV422P16, {PLANAR_Y, PLANAR_U, PLANAR_V, 16            }, 2, write_semi_planar   },
+    {"Y8",          VideoInfo::CS_Y8,        {PLANAR_Y,        0,        0, 0             }, 1, write_planar        },
+    {"GRAY",        VideoInfo::CS_Y8,        {PLANAR_Y,        0,        0, 0             }, 1, write_planar        },
+    {"YUV420P10LE", VideoInfo::CS_YUV420P10, {PLANAR_Y, PLANAR_U, PLANAR_V, 10            }, 3, write_planar16      },
+    {"YUV420P10BE", VideoInfo::CS_YUV420P10, {PLANAR_Y, PLANAR_U, PLANAR_V, 10 | SAMPLE_BE}, 3, write_planar16      },
+    {"YUV420P12LE", VideoInfo::CS_YUV420P12, {PLANAR_Y, PLANAR_U, PLANAR_V, 12            }, 3, write_planar16      },
+    {"YUV420P12BE", VideoInfo::CS_YUV420P12, {PLANAR_Y, PLANAR_U, PLANAR_V, 12 | SAMPLE_BE}, 3, write_planar16      },
+    {"YUV420P14LE", VideoInfo::CS_YUV420P14, {PLANAR_Y, PLANAR_U, PLANAR_V, 14            }, 3, write_planar16      },
+    {"YUV420P14BE", VideoInfo::CS_YUV420P14, {PLANAR_Y, PLANAR_U, PLANAR_V, 14 | SAMPLE_BE}, 3, write_planar16      },
+    {"YUV420P16LE", VideoInfo::CS_YUV420P16, {PLANAR_Y, PLANAR_U, PLANAR_V, 16            }, 3, write_planar16      },
+    {"YUV420P16BE", VideoInfo::CS_YUV420P16, {PLANAR_Y, PLANAR_U, PLANAR_V, 16 | SAMPLE_BE}, 3, write_planar16      },
+    {"YUV422P10LE", VideoInfo::CS_YUV422P10, {PLANAR_Y, PLANAR_U, PLANAR_V, 10            }, 3, write_planar16      },
+    {"YUV422P10BE", VideoInfo::CS_YUV422P10, {PLANAR_Y, PLANAR_U, PLANAR_V, 10 | SAMPLE_BE}, 3, write_planar16      },
+    {"YUV422P12LE", VideoInfo::CS_YUV422P12, {PLANAR_Y, PLANAR_U, PLANAR_V, 12            }, 3, write_planar16      },
+    {"YUV422P12BE", VideoInfo::CS_YUV422P12, {PLANAR_Y, PLANAR_U, PLANAR_V, 12 | SAMPLE_BE}, 3, write_planar16      },
+    {"YUV422P14LE", VideoInfo::CS_YUV422P14, {PLANAR_Y, PLANAR_U, PLANAR_V, 14            }, 3, write_planar16      },
+    {"YUV422P14BE", VideoInfo::CS_YUV422P14, {PLANAR_Y, PLANAR_U, PLANAR_V, 14 | SAMPLE_BE}, 3, write_planar16      },
+    {"YUV422P16LE", VideoInfo::CS_YUV422P16, {PLANAR_Y, PLANAR_U, PLANAR_V, 16            }, 3, write_planar16      },
+    {"YUV422P16BE", VideoInfo::CS_YUV422P16, {PLANAR_Y, PLANAR_U, PLANAR_V, 16 | SAMPLE_BE}, 3, write_planar16      },
+    {"YUV444P10LE", VideoInfo::CS_YUV444P10, {PLANAR_Y, PLANAR_U, PLANAR_V, 10            }, 3, write_planar16      },
+    {"YUV444P10BE", VideoInfo::CS_YUV444P10, {PLANAR_Y, PLANAR_U, PLANAR_V, 10 | SAMPLE_BE}, 3, write_planar16      },
+    {"YUV444P12LE", VideoInfo::CS_YUV444P12, {PLANAR_Y, PLANAR_U, PLANAR_V, 12            }, 3, write_planar16      },
+    {"YUV444P12BE", VideoInfo::CS_YUV444P12, {PLANAR_Y, PLANAR_U, PLANAR_V, 12 | SAMPLE_BE}, 3, write_planar16      },
+    {"YUV444P14LE", VideoInfo::CS_YUV444P14, {PLANAR_Y, PLANAR_U, PLANAR_V, 14            }, 3, write_planar16      },
+    {"YUV444P14BE", VideoInfo::CS_YUV444P14, {PLANAR_Y, PLANAR_U, PLANAR_V, 14 | SAMPLE_BE}, 3, write_planar16      },
+    {"YUV444P16LE", VideoInfo::CS_YUV444P16, {PLANAR_Y, PLANAR_U, PLANAR_V, 16            }, 3, write_planar16      },
+    {"YUV444P16BE", VideoInfo::CS_YUV444P16, {PLANAR_Y, PLANAR_U, PLANAR_V, 16 | SAMPLE_BE}, 3, write_planar16      },
+    {"GRAY10LE",    VideoInfo::CS_Y10,       {PLANAR_Y,        0,        0, 10            }, 1, write_planar16      },
+    {"GRAY10BE",    VideoInfo::CS_Y10,       {PLANAR_Y,        0,        0, 10 | SAMPLE_BE}, 1, write_planar16      },
+    {"GRAY12LE",    VideoInfo::CS_Y12,       {PLANAR_Y,        0,        0, 12            }, 1, write_planar16      },
+    {"GRAY12BE",    VideoInfo::CS_Y12,       {PLANAR_Y,        0,        0, 12 | SAMPLE_BE}, 1, write_planar16      },
+    {"GRAY14LE",    VideoInfo::CS_Y14,       {PLANAR_Y,        0,        0, 14            }, 1, write_planar16      },
+    {"GRAY14BE",    VideoInfo::CS_Y14,       {PLANAR_Y,        0,        0, 14 | SAMPLE_BE}, 1, write_planar16      },
+    {"GRAY16LE",    VideoInfo::CS_Y16,       {PLANAR_Y,        0,        0, 16            }, 1, write_planar16      },
+    {"GRAY16BE",    VideoInfo::CS_Y16,       {PLANAR_Y,        0,        0, 16 | SAMPLE_BE}, 1, write_planar16      },
+    {"GBRP",        VideoInfo::CS_RGBP,      {PLANAR_G, PLANAR_B, PLANAR_R, 0             }, 3, write_planar        },
+    {"RGBP",        VideoInfo::CS_RGBP,      {PLANAR_R, PLANAR_G, PLANAR_B, 0             }, 3, write_planar        },
+    {"GBRAP",       VideoInfo::CS_RGBAP,     {PLANAR_G, PLANAR_B, PLANAR_R, PLANAR_A      }, 4, write_planar        },
+    {"GBRP10LE",    VideoInfo::CS_RGBP10,    {PLANAR_G, PLANAR_B, PLANAR_R, 10            }, 3, write_planar16      },
+    {"GBRP10BE",    VideoInfo::CS_RGBP10,    {PLANAR_G, PLANAR_B, PLANAR_R, 10 | SAMPLE_BE}, 3, write_planar16      },
+    {"GBRP12LE",    VideoInfo::CS_RGBP12,    {PLANAR_G, PLANAR_B, PLANAR_R, 12            }, 3, write_planar16      },
+    {"GBRP12BE",    VideoInfo::CS_RGBP12,    {PLANAR_G, PLANAR_B, PLANAR_R, 12 | SAMPLE_BE}, 3, write_planar16      },
+    {"GBRP14LE",    VideoInfo::CS_RGBP14,    {PLANAR_G, PLANAR_B, PLANAR_R, 14            }, 3, write_planar16      },
+    {"GBRP14BE",    VideoInfo::CS_RGBP14,    {PLANAR_G, PLANAR_B, PLANAR_R, 14 | SAMPLE_BE}, 3, write_planar16      },
+    {"GBRP16LE",    VideoInfo::CS_RGBP16,    {PLANAR_G, PLANAR_B, PLANAR_R, 16            }, 3, write_planar16      },
+    {"GBRP16BE",    VideoInfo::CS_RGBP16,    {PLANAR_G, PLANAR_B, PLANAR_R, 16 | SAMPLE_BE}, 3, write_planar16      },
+    {"GBRAP10LE",   VideoInfo::CS_RGBAP10,   {PLANAR_G, PLANAR_B, PLANAR_R, 10            }, 4, write_planar16      },
+    {"GBRAP10BE",   VideoInfo::CS_RGBAP10,   {PLANAR_G, PLANAR_B, PLANAR_R, 10 | SAMPLE_BE}, 4, write_planar16      },
+    {"GBRAP12LE",   VideoInfo::CS_RGBAP12,   {PLANAR_G, PLANAR_B, PLANAR_R, 12            }, 4, write_planar16      },
+    {"GBRAP12BE",   VideoInfo::CS_RGBAP12,   {PLANAR_G, PLANAR_B, PLANAR_R, 12 | SAMPLE_BE}, 4, write_planar16      },
+    {"GBRAP14LE",   VideoInfo::CS_RGBAP14,   {PLANAR_G, PLANAR_B, PLANAR_R, 14            }, 4, write_planar16      },
+    {"GBRAP14BE",   VideoInfo::CS_RGBAP14,   {PLANAR_G, PLANAR_B, PLANAR_R, 14 | SAMPLE_BE}, 4, write_planar16      },
+    {"GBRAP16LE",   VideoInfo::CS_RGBAP16,   {PLANAR_G, PLANAR_B, PLANAR_R, 16            }, 4, write_planar16      },
+    {"GBRAP16BE",   VideoInfo::CS_RGBAP16,   {PLANAR_G, PLANAR_B, PLANAR_R, 16 | SAMPLE_BE}, 4, write_planar16      },
+    {"v210",        VideoInfo::CS_YUV422P10, {PLANAR_Y, PLANAR_U, PLANAR_V, 10            }, 3, write_v210          },
+    {"Y210",        VideoInfo::CS_YUV422P10, {PLANAR_Y, PLANAR_U, PLANAR_V, 10 | SAMPLE_MSB}, 2, write_y210          },
+    {"Y216",        VideoInfo::CS_YUV422P16, {PLANAR_Y, PLANAR_U, PLANAR_V, 16            }, 2, write_y210          },
+    {"r210",        VideoInfo::CS_RGBP10,    {      20,       10,        0, 64            }, 4, write_rgb10         },
+    {"R10k",        VideoInfo::CS_RGBP10,    {      22,       12,        2, 1             }, 4, write_rgb10         },
+    {nullptr,       VideoInfo::CS_UNKNOWN,   {       0,        0,        0, 0             }, 0, nullptr             }
+};
+
+
+const pixel_format* find_pixel_format(const char* name) noexcept
+{
+    for (const pixel_format* f = pixel_formats; f->name; ++f) {
+        if (!stricmp(name, f->name)) {
+            return f;
+        }
+    }
+    return nullptr;
+}
+
+
+// bytes of one frame in the file. the rows of v210 and r210 are padded.
+size_t get_frame_size(const VideoInfo& vi, const pixel_format& fmt) noexcept
+{
+    if (fmt.func == write_v210) {
+        return v210_row_size(vi.width) * vi.height;
+    }
+    if (fmt.func == write_rgb10) {
+        return rgb10_row_size(vi.width, fmt.order[3]) * vi.height;
+    }
+    return static_cast<size_t>(vi.width) * vi.height * vi.BitsPerPixel() / 8;
+}
+
+
+// the fastest version of a kernel for the cpu.
+write_frame_t get_kernel(write_frame_t func, int cpu) noexcept
+{
+    if (func == write_packed_reorder) {
+        if (cpu & CPU_AVX2) {
+            return write_packed_reorder_avx2;
+        } else if (cpu & CPU_SSSE3) {
+            return write_packed_reorder_ssse3;
+        }
+    } else if (func == write_planar16) {
+        if (cpu & CPU_AVX2) {
+            return write_planar16_avx2;
+        } else if (cpu & CPU_SSE2) {
+            return write_planar16_sse2;
+        }
+    } else if (func == write_semi_planar) {
+        if (cpu & CPU_AVX2) {
+            return write_semi_planar_avx2;
+        } else if (cpu & CPU_SSE2) {
+            return write_semi_planar_sse2;
+        }
+    } else if (func == write_packed422) {
+        if (cpu & CPU_SSSE3) {
+            return write_packed422_ssse3;
+        }
+    } else if (func == write_packed444) {
+        if (cpu & CPU_AVX2) {
+            return write_packed444_avx2;
+        } else if (cpu & CPU_SSSE3) {
+            return write_packed444_ssse3;
+        }
+    } else if (func == write_packed_rgbp) {
+        if (cpu & CPU_AVX2) {
+            return write_packed_rgbp_avx2;
+        } else if (cpu & CPU_SSSE3) {
+            return write_packed_rgbp_ssse3;
+        }
+    } else if (func == write_v210) {
+        if (cpu & CPU_SSSE3) {
+            return write_v210_ssse3;
+        }
+    } else if (func == write_y210) {
+        if (cpu & CPU_SSSE3) {
+            return write_y210_ssse3;
+        }
+    } else if (func == write_rgb10) {
+        if (cpu & CPU_SSSE3) {
+            return write_rgb10_ssse3;
+        }
+    }
+    return func;
+}
+
+
+class RawSource : public IClip {
+
+    VideoInfo vi;
+    std::unique_ptr<SourceReader> reader;
+    int order[4];
+    int col_count;
+    bool show;
+    bool live;
+    int liveTimeout;
+
+    BufferPool buffers;
+    FrameIndex index;
+    IndexCache indexCache;
+    size_t framesize;
+    std::unique_ptr<Prefetcher> prefetcher;
+    std::unique_ptr<FrameStats> stats;
+    std::unique_ptr<FrameCrop> crop;
+    std::unique_ptr<FrameCache> frameCache;
+    std::unique_ptr<AudioIndex> audio;
+    std::unique_ptr<FrameArchive> archive;
+    BufferPool archiveBuffers;
+    bool archivePlanes;
+    int archivePlane[ARCHIVE_MAX_CHUNKS];
+    int audioSwap;
+    int field;
+    std::string statsFile;
+    std::string sourceName;
+
+    void setProcess(const char* pix_type, bool msb, int crop_left,
+                    int crop_top, int crop_right, int crop_bottom,
+                    bool planar_output, bool top_down);
+    void convert(RawReader& rd, int64_t pos, int64_t limit, PVideoFrame& dst,
+                 uint8_t* buff, ise_t* env, frame_sample* sample);
+    bool readArchive(int n, int64_t pos, PVideoFrame& dst, ise_t* env,
+                     frame_sample* sample);
+
+    write_frame_t writeDestFrame;
+
+public:
+    RawSource(const char* source, const int width, const int height,
+              const char* pix_type, const int fpsnum, const int fpsden,
+              const char* index, const bool show, const bool use_mmap,
+              const int prefetch, const int prefetch_mem, const bool msb,
+              const bool index_cache, const bool live, const int live_frames,
+              const int live_timeout, const bool direct, const bool use_stats,
+              const char* stats_file, const int crop_left, const int crop_top,
+              const int crop_right, const int crop_bottom, const int field,
+              const bool planar_output, const int cache_mem,
+              const int audio_rate, const int audio_channels,
+              const char* audio_type, const int audio_start,
+              const int audio_skip, const int container);
+    ~RawSource();
+    PVideoFrame __stdcall GetFrame(int n, ise_t *env);
+
+    bool __stdcall GetParity(int n)
+    {
+        if (field != FIELD_NONE) {
+            return field == FIELD_TOP;
+        }
+        return vi.image_type == VideoInfo::IT_TFF;
+    }
+    void __stdcall GetAudio(void* buf, int64_t start, int64_t count,
+                            ise_t* env);
+    const VideoInfo& __stdcall GetVideoInfo() { return vi; }
+    int __stdcall SetCacheHints(int cachehints, int frame_range);
+};
+
+
+void RawSource::setProcess(const char* pix_type, bool msb, int crop_left,
+                           int crop_top, int crop_right, int crop_bottom,
+                           bool planar_output, bool top_down)
+{
+    const pixel_format* fmt = find_pixel_format(pix_type);
+
+    validate(fmt == nullptr,
+             "Invalid pixel type. Supported: RGB, RGBA, BGR, BGRA, ARGB,"
+             " ABGR, YV24, I444, YUY2, YUYV, UYVY, YVYU, VYUY, YV16, I422,"
+             " YV411, Y41B, I411, YV12, I420, IYUV, NV12, NV21, NV16, P010,"
+             " P016, P210, P216, Y8, GRAY, YUV420PnnLE/BE, YUV422PnnLE/BE,"
+             " YUV444PnnLE/BE, GRAYnnLE/BE (nn = 10, 12, 14, 16), v210, Y210,"
+             " Y216, r210, R10k, AYUV, VUYA, v308, YUVA444, GBRP, RGBP,"
+             " GBRAP, GBRPnnLE/BE, GBRAPnnLE/BE");
+
+    vi.pixel_type = fmt->avs_pix_type;
+    memcpy(order, fmt->order, sizeof(int) * 4);
+    col_count = fmt->cnt;
+    writeDestFrame = fmt->func;
+
+    if (msb && writeDestFrame == write_planar16 && (order[3] & 0xFF) < 16) {
+        order[3] |= SAMPLE_MSB;
+    }
+
+    framesize = get_frame_size(vi, *fmt);
+
+    if (archive) {
+        size_t sizes[ARCHIVE_MAX_CHUNKS];
+        const int chunks = get_chunk_sizes(vi, *fmt, sizes);
+        bool same = chunks == archive->chunks();
+        for (int k = 0; same && k < chunks; ++k) {
+            same = sizes[k] == archive->chunk_size(k);
+        }
+        validate(!same, "the chunks of the archive do not match its"
+                 " pixel_type.");
+    }
+
+    // packed RGB is bottom-up like a frame of RGB24/RGB32. rows which are
+    // stored top-down are read from the last one up by a crop.
+    const bool flip = top_down && vi.IsRGB() && !vi.IsPlanar();
+
+    // from here on vi is the cropped frame, framesize stays the one of
+    // the file.
+    if (crop_left > 0 || crop_top > 0 || crop_right > 0 || crop_bottom > 0
+            || field != FIELD_NONE || flip) {
+        crop.reset(new FrameCrop(*fmt, vi, crop_left, crop_top, crop_right,
+                                 crop_bottom, field, flip));
+        vi.width = crop->width();
+        vi.height = crop->height();
+        if (field != FIELD_NONE) {
+            vi.SetFieldBased(true);
+        }
+    }
+
+    // packed 4:2:2 and RGB are split into planes while they are read. the
+    // crop is still the one of the packed source.
+    if (planar_output && vi.IsYUY2()) {
+        vi.pixel_type = VideoInfo::CS_YV16;
+        writeDestFrame = write_packed422;
+    } else if (planar_output && vi.IsRGB() && !vi.IsPlanar()) {
+        // order becomes the bytes of G, B, R and A.
+        std::swap(order[0], order[1]);
+        vi.pixel_type = col_count == 4 ? VideoInfo::CS_RGBAP
+                                       : VideoInfo::CS_RGBP;
+        writeDestFrame = write_packed_rgbp;
+    }
+
+    // the chunks of an archive go straight into the planes of the frame
+    // when no kernel has to convert them.
+    archivePlanes = archive && !crop && vi.pixel_type == fmt->avs_pix_type
+        && (writeDestFrame == write_planar || writeDestFrame == write_packed
+            || (writeDestFrame == write_planar16
+                && !sample_needs_conversion(order[3])));
+    for (int k = 0; k < ARCHIVE_MAX_CHUNKS; ++k) {
+        archivePlane[k] = writeDestFrame == write_packed ? 0
+                        : k < 3 ? order[k] : PLANAR_A;
+    }
+
+    // planar and plain packed formats are read straight into the frame.
+    // only reordering and deinterleaving kernels need a staging buffer,
+    // and with mmap or direct they convert straight from the reader, like
+    // they do from a decoded frame of an archive.
+    // staging buffers are pooled, one per concurrent GetFrame() call.
+    const size_t plane_size = static_cast<size_t>(vi.width) * vi.height;
+    if (reader->mapped() || reader->direct() || archive) {
+        buffers.set_size(0);
+    } else if (writeDestFrame == write_packed_reorder) {
+        buffers.set_size(plane_size * vi.BitsPerPixel() / 8);
+    } else if (writeDestFrame == write_semi_planar) {
+        // interleaved chroma, or the luma plane if it has to be converted.
+        const size_t chroma_size = static_cast<size_t>(vi.width)
+            * (vi.height >> vi.GetPlaneHeightSubsampling(PLANAR_U));
+        buffers.set_size((sample_needs_conversion(order[3]) ? plane_size
+                          : chroma_size) * vi.ComponentSize());
+    } else if (writeDestFrame == write_planar16
+               && sample_needs_conversion(order[3])) {
+        buffers.set_size(plane_size * vi.ComponentSize());
+    } else if (writeDestFrame == write_v210 || writeDestFrame == write_y210
+               || writeDestFrame == write_rgb10
+               || writeDestFrame == write_packed422
+               || writeDestFrame == write_packed444
+               || writeDestFrame == write_packed_rgbp) {
+        buffers.set_size(get_frame_size(vi, *fmt));
+    }
+
+    writeDestFrame = get_kernel(writeDestFrame, get_cpu_features());
+}
+
+
+RawSource::RawSource (const char *source, const int width, const int height,
+                      const char *ptype, const int fpsnum, const int fpsden,
+                      const char *a_index, const bool s, const bool m,
+                      const int prefetch, const int prefetch_mem,
+                      const bool msb, const bool index_cache,
+                      const bool l, const int live_frames,
+                      const int live_timeout, const bool direct,
+                      const bool use_stats, const char* stats_file,
+                      const int crop_left, const int crop_top,
+                      const int crop_right, const int crop_bottom,
+                      const int f, const bool planar_output,
+                      const int cache_mem, const int audio_rate,
+                      const int audio_channels, const char* audio_type,
+                      const int audio_start, const int audio_skip,
+                      const int container) :
+    show(s), live(l), liveTimeout(live_timeout), archivePlanes(false),
+    audioSwap(0), field(f),
+    statsFile(stats_file), sourceName(source)
+{
+    const bool segmented = SegmentReader::is_segmented(source);
+    validate(live && segmented, "live can not be used with a file sequence.");
+    if (segmented) {
+        reader.reset(new SegmentReader(source, m, direct));
+    } else {
+        reader.reset(new FileReader(source, m && !live, direct));
+    }
+
+    const int64_t fileSize = reader->size();
+
+    memset(&vi, 0, sizeof(VideoInfo));
+    vi.width = width;
+    vi.height = height;
+    vi.SetFPS(fpsnum, fpsden);
+    vi.SetFieldBased(false);
+
+    char pix_type[16] = {};
+    strcpy(pix_type, ptype);
+
+    int64_t header_offset = 0;
+    bool y4m = false;
+    const bool mov = container == CONTAINER_MOV;
+    mov_track track = {};
+
+    if (mov) {
+        // the frame positions come straight from the sample tables.
+        read_mov(*reader, fileSize, track, index);
+        vi.width = track.width;
+        vi.height = track.height;
+        vi.SetFPS(track.fpsNum, track.fpsDen);
+        validate(vi.width < static_cast<int>(MIN_WIDTH)
+                 || vi.height < static_cast<int>(MIN_HEIGHT),
+                 "the video track of the MOV file is too small.");
+        if (pix_type[0] == '\0') {
+            char msg[128];
+            sprintf(msg, "codec '%s' of the MOV file is not supported."
+                    " pixel_type needs to be given.", track.codec);
+            validate(track.pixType[0] == '\0', msg);
+            strcpy(pix_type, track.pixType);
+        }
+    } else if (strlen(a_index) == 0) { //use header if valid else width, height, pixel_type from AVS are used
+        std::vector<char> header;
+        y4m = read_y4m_header(*reader, fileSize, header)
+              && parse_y4m(header, vi, header_offset);
+
+        if (y4m) {
+            strcpy(pix_type, header.data());
+        } else if (FrameArchive::is_archive(*reader, fileSize)) {
+            // an archive gives its format like a y4m header does.
+            validate(live, "live can not be used with an archive.");
+            archive.reset(new FrameArchive(*reader, fileSize));
+            const archive_header& ah = archive->info();
+            vi.width = ah.width;
+            vi.height = ah.height;
+            vi.SetFPS(ah.fpsNum, ah.fpsDen);
+            vi.image_type = ah.imageType;
+            validate(vi.width < static_cast<int>(MIN_WIDTH)
+                     || vi.height < static_cast<int>(MIN_HEIGHT)
+                     || ah.fpsNum == 0 || ah.fpsDen == 0,
+                     "the archive header is broken.");
+            strcpy(pix_type, ah.pixType);
+        }
+    }
+
+    if (vi.width > static_cast<int>(MAX_WIDTH)
+            || vi.height > static_cast<int>(MAX_HEIGHT)) {
+        char msg[128];
+        sprintf(msg, "Resolution too big(%d x %d)."
+                " Maximum acceptable resolution is %u x %u.",
+                vi.width, vi.height, MAX_WIDTH, MAX_HEIGHT);
+        throw std::runtime_error(msg);
+    }
+
+    const int src_width = vi.width;
+    const int src_height = vi.height;
+    // the frames of a MOV file are stored top-down.
+    setProcess(pix_type, msb, crop_left, crop_top, crop_right, crop_bottom,
+               planar_output, mov);
+
+    // plain raw files without an index are cheap to index, so only parsed
+    // index strings/files and scanned y4m streams are cached.
+    const std::string cache_path = std::string(source) + ".rsidx";
+    index_key key;
+    const bool use_cache = index_cache && !live && !segmented
+        && (y4m || strlen(a_index) > 0)
+        && IndexCache::make_key(key, source, a_index, src_width, src_height,
+                                pix_type, framesize);
+    if (mov) {
+        validate(track.minSampleSize < static_cast<int64_t>(framesize),
+                 "the frames of the MOV file are smaller than a frame of"
+                 " pixel_type.");
+    } else if (archive) {
+        archive->fill_index(index);
+    } else if (!use_cache || !indexCache.load(cache_path.c_str(), key,
+                                              index)) {
+        if (y4m) {
+            int frames = scan_y4m_frames(*reader, fileSize, header_offset,
+                                         framesize, index);
+            if (live && frames < live_frames) {
+                // frames which are not written yet are expected to have
+                // FRAME headers of the same length as the last one.
+                int64_t stride = framesize + 6; // "FRAME\n"
+                if (frames > 1) {
+                    stride = index.lookup(frames - 1) - index.lookup(frames - 2);
+                }
+                const int64_t next = frames > 0
+                    ? index.lookup(frames - 1) + stride : header_offset + 6;
+                index.add(frames, next, 'D', live_frames - frames, stride);
+            }
+        } else {
+            int maxframe = live ? live_frames
+                : static_cast<int>(fileSize / framesize);    //1 = one frame
+
+            validate(maxframe < 1, "File too small for even one frame.");
+
+            //index build using string descriptor
+            std::vector<rindex> rawindex;
+            set_rawindex(rawindex, a_index, framesize);
+
+            //create full index and get number of frames.
+            generate_index(index, rawindex, framesize,
+                           live ? INT64_MAX : fileSize, maxframe);
+        }
+
+        if (use_cache) {
+            IndexCache::save(cache_path.c_str(), key, index);
+        }
+    }
+    vi.num_frames = live ? std::min(index.frames(), live_frames)
+                         : index.frames();
+    validate(vi.num_frames < 1, "File too small for even one frame.");
+
+    if (audio_rate > 0) {
+        validate(archive != nullptr, "audio can not be read from an archive.");
+        const audio_format* afmt = find_audio_format(audio_type);
+        validate(afmt == nullptr,
+                 "Invalid audio_format. Supported: u8, s16le, s16be, s24le,"
+                 " s24be, s32le, s32be, f32le, f32be");
+        audio.reset(new AudioIndex(index, vi.num_frames, framesize,
+                                   audio_start, audio_skip));
+        const int64_t block = static_cast<int64_t>(afmt->bytes)
+                              * audio_channels;
+        validate(audio->size() < block,
+                 "there is no audio between the frames of the index.");
+        vi.audio_samples_per_second = audio_rate;
+        vi.sample_type = afmt->sampleType;
+        vi.nchannels = audio_channels;
+        vi.num_audio_samples = audio->size() / block;
+        audioSwap = afmt->bigEndian ? afmt->bytes : 0;
+    }
+
+    uint8_t* buff = buffers.acquire();
+    validate(buff == nullptr && buffers.size() > 0,
+             "failed to allocate read buffer.");
+    buffers.release(buff);
+
+    if (archive) {
+        // a decoded frame, then the chunks of the frame as they are read.
+        archiveBuffers.set_size(framesize + archive->max_frame_size());
+        buff = archiveBuffers.acquire();
+        validate(buff == nullptr, "failed to allocate read buffer.");
+        archiveBuffers.release(buff);
+    }
+
+    // read-ahead is done by the system when the file is mapped. the frames
+    // of an archive are compressed, they are not read ahead.
+    if (prefetch > 0 && !reader->mapped() && !archive) {
+        int64_t depth = (static_cast<int64_t>(prefetch_mem) << 20) / framesize;
+        depth = std::max<int64_t>(std::min<int64_t>(depth, prefetch), 1);
+        prefetcher.reset(new Prefetcher(*reader, index, vi.num_frames,
+                                        framesize, static_cast<int>(depth),
+                                        crop.get()));
+    }
+
+    if (cache_mem > 0) {
+        const size_t frame_bytes = static_cast<size_t>(vi.width) * vi.height
+                                   * vi.BitsPerPixel() / 8;
+        frameCache.reset(new FrameCache(static_cast<size_t>(cache_mem) << 20,
+                                        frame_bytes));
+    }
+
+    if (use_stats || !statsFile.empty()) {
+        stats.reset(new FrameStats());
+    }
+}
+
+
+RawSource::~RawSource()
+{
+    if (stats && !statsFile.empty()) {
+        stats->dump(statsFile.c_str(), sourceName.c_str());
+    }
+}
+
+
+/*
+  Converts a frame from rd. With stats, the reads go through a
+  CountingReader, and the time of the kernel less the time of the reads
+  is the conversion time. With a crop, the kernel converts the cropped
+  frame through a CropReader.
+*/
+void RawSource::convert(RawReader& rd, int64_t pos, int64_t limit,
+                        PVideoFrame& dst, uint8_t* buff, ise_t* env,
+                        frame_sample* sample)
+{
+    if (sample) {
+        CountingReader counted(rd, limit, *sample);
+        const int64_t start = FrameStats::now();
+        convert(counted, pos, limit, dst, buff, env, nullptr);
+        sample->convert = FrameStats::now() - start - sample->read;
+        return;
+    }
+
+    if (crop) {
+        CropReader cropped(rd, *crop, pos);
+        writeDestFrame(cropped, pos, dst, buff, order, col_count, env);
+        return;
+    }
+    writeDestFrame(rd, pos, dst, buff, order, col_count, env);
+}
+
+
+/*
+  Frame n of an archive. Planar and plain packed frames are decoded
+  straight into dst, the others into a buffer which the kernel converts
+  like a frame of a raw file. A frame which was never written is black.
+*/
+bool RawSource::readArchive(int n, int64_t pos, PVideoFrame& dst,
+                            ise_t* env, frame_sample* sample)
+{
+    const size_t size = archive->frame_size(n);
+    if (size == 0) {
+        write_black_frame(dst, vi);
+        return true;
+    }
+    uint8_t* buff = archiveBuffers.acquire();
+    if (!buff) {
+        return false;
+    }
+
+    int64_t start = sample ? FrameStats::now() : 0;
+    reader->hint(pos, size);
+    const uint8_t* src = reader->get(buff + framesize, size, pos);
+    if (sample) {
+        const int64_t now = FrameStats::now();
+        sample->read = now - start;
+        sample->bytes = static_cast<int64_t>(size);
+        start = now;
+    }
+
+    archive_plane planes[ARCHIVE_MAX_CHUNKS];
+    size_t offset = 0;
+    for (int k = 0; k < archive->chunks(); ++k) {
+        const int chunk = static_cast<int>(archive->chunk_size(k));
+        if (archivePlanes) {
+            const int p = archivePlane[k];
+            planes[k] = {dst->GetWritePtr(p), dst->GetPitch(p),
+                         dst->GetRowSize(p), dst->GetHeight(p)};
+        } else {
+            planes[k] = {buff + offset, chunk, chunk, 1};
+        }
+        offset += chunk;
+    }
+
+    const bool ok = archive->decode(n, src, planes, buff);
+    if (ok && !archivePlanes) {
+        MemoryReader decoded(buff, 0, framesize);
+        convert(decoded, 0, framesize, dst, nullptr, env, nullptr);
+    }
+    if (sample) {
+        sample->convert = FrameStats::now() - start;
+    }
+    archiveBuffers.release(buff);
+    return ok;
+}
+
+
+PVideoFrame __stdcall RawSource::GetFrame(int n, ise_t* env)
+{
+    frame_sample sample = {};
+    frame_sample* ps = stats ? &sample : nullptr;
+    const int64_t start = ps ? FrameStats::now() : 0;
+
+    PVideoFrame dst;
+    if (frameCache && frameCache->get(n, dst)) {
+        if (ps) {
+            sample.frameCacheHit = true;
+            sample.total = FrameStats::now() - start;
+            stats->add(n, sample);
+            stats->set_vars(sample, env);
+        }
+        return dst;
+    }
+
+    dst = env->NewVideoFrame(vi);
+
+    char type;
+    const int64_t pos = index.lookup(n, &type);
+    if (live && !reader->wait_size(pos + framesize, liveTimeout)) {
+        write_black_frame(dst, vi);
+        env->ApplyMessage(&dst, vi, "frame has not been written yet!",
+                          vi.width, 0x00FFFFFF, 0x00FFFFFF, 0);
+        return dst;
+    }
+
+    uint8_t* buff = buffers.acquire();
+    if (!buff && buffers.size() > 0) {
+        // black frame with message
+        write_black_frame(dst, vi);
+        env->ApplyMessage(&dst, vi, "failed to allocate read buffer!",
+                          vi.width, 0x00FFFFFF, 0x00FFFFFF, 0);
+        return dst;
+    }
+
+    bool failed = false;
+    const uint8_t* data = prefetcher ? prefetcher->acquire(n) : nullptr;
+    if (data) {
+        MemoryReader prefetched(data, pos, framesize);
+        if (ps) {
+            sample.cacheHit = true;
+            sample.seek = FrameStats::now() - start;
+        }
+        convert(prefetched, pos, pos + framesize, dst, buff, env, ps);
+        prefetcher->release(n);
+    } else if (archive) {
+        if (ps) {
+            sample.seek = FrameStats::now() - start;
+        }
+        failed = !readArchive(n, pos, dst, env, ps);
+    } else {
+        if (crop) {
+            reader->hint(pos + crop->first(),
+                         static_cast<size_t>(crop->last() - crop->first()));
+        } else {
+            reader->hint(pos, framesize);
+        }
+        if (ps) {
+            sample.seek = FrameStats::now() - start;
+        }
+        convert(*reader, pos, reader->size(), dst, buff, env, ps);
+    }
+    buffers.release(buff);
+
+    if (failed) {
+        write_black_frame(dst, vi);
+        env->ApplyMessage(&dst, vi, "failed to read the frame from the"
+                          " archive!", vi.width, 0x00FFFFFF, 0x00FFFFFF, 0);
+        return dst;
+    }
+
+    if (ps) {
+        sample.frameCacheMiss = frameCache != nullptr;
+        sample.total = FrameStats::now() - start;
+        stats->add(n, sample);
+        stats->set_vars(sample, env);
+    }
+
+    if (show) { //output debug info
+        char info[64];
+        sprintf(info, "%d : %" PRIi64 " %c", n, pos, type);
+        std::string text(info);
+        if (ps) {
+            text += stats->overlay(sample);
+        }
+        env->ApplyMessage(&dst, vi, text.c_str(),
+                          ps ? vi.width : vi.width / 2, 0x00FFFFFF, 0, 0);
+    }
+
+    if (frameCache) {
+        frameCache->put(n, dst);
+    }
+    return dst;
+}
+
+
+/*
+  Samples before the start or after the end of the audio are silence.
+  A sample which is not in the file yet (live) is read as 0.
+*/
+void __stdcall RawSource::GetAudio(void* buf, int64_t start, int64_t count,
+                                   ise_t* env)
+{
+    if (!audio || count <= 0) {
+        return;
+    }
+
+    const int64_t block = vi.BytesPerAudioSample();
+    const int silence = vi.sample_type == SAMPLE_INT8 ? 0x80 : 0;
+    uint8_t* dstp = reinterpret_cast<uint8_t*>(buf);
+
+    if (start < 0) {
+        const int64_t n = std::min(-start, count);
+        memset(dstp, silence, static_cast<size_t>(n * block));
+        dstp += n * block;
+        start += n;
+        count -= n;
+    }
+    const int64_t n = std::max<int64_t>(
+        std::min(count, vi.num_audio_samples - start), 0);
+    if (count > n) {
+        memset(dstp + n * block, silence,
+               static_cast<size_t>((count - n) * block));
+    }
+    if (n == 0) {
+        return;
+    }
+
+    const size_t size = static_cast<size_t>(n * block);
+    audio->read(*reader, dstp, size, start * block);
+    if (audioSwap > 0) {
+        swap_audio_bytes(dstp, size, audioSwap);
+    }
+}
+
+
+/*
+  With cache_mem, the frames are cached here and Avisynth+ need not put
+  a cache of its own after the clip. The video hints of other filters
+  size that cache.
+*/
+int __stdcall RawSource::SetCacheHints(int cachehints, int frame_range)
+{
+    switch (cachehints) {
+    case CACHE_GET_MTMODE:
+        return MT_NICE_FILTER;
+    case CACHE_DONT_CACHE_ME:
+        return frameCache ? 1 : 0;
+    default:
+        return frameCache ? frameCache->hint(cachehints, frame_range) : 0;
+    }
+}
+
+
+AVSValue __cdecl create_rawsource(AVSValue args, void* user_data, ise_t* env)
+{
+    char buff[128] = {};
+
+    try {
+        validate(!args[0].Defined(), "No source specified");
+
+        const char *source = args[0].AsString();
+        const int width = args[1].AsInt(720);
+        const int height = args[2].AsInt(576);
+        const char *pix_type = args[3].AsString("YUY2");
+        const int fpsnum = args[4].AsInt(25);
+        const int fpsden = args[5].AsInt(1);
+        const char *index = args[6].AsString("");
+        const bool show = args[7].AsBool(false);
+        const bool use_mmap = args[8].AsBool(false);
+        const int prefetch = args[9].AsInt(0);
+        const int prefetch_mem = args[10].AsInt(256);
+        const bool msb = args[11].AsBool(false);
+        const bool index_cache = args[12].AsBool(true);
+        const bool live = args[13].AsBool(false);
+        const int live_frames = args[14].AsInt(0);
+        const int live_timeout = args[15].AsInt(10000);
+        const bool direct = args[16].AsBool(false);
+        const bool use_stats = args[17].AsBool(false);
+        const char* stats_file = args[18].AsString("");
+        const int crop_left = args[19].AsInt(0);
+        const int crop_top = args[20].AsInt(0);
+        const int crop_right = args[21].AsInt(0);
+        const int crop_bottom = args[22].AsInt(0);
+        const char* field_name = args[23].AsString("none");
+        const bool planar_output = args[24].AsBool(false);
+        const int cache_mem = args[25].AsInt(0);
+        const int audio_rate = args[26].AsInt(0);
+        const int audio_channels = args[27].AsInt(2);
+        const char* audio_type = args[28].AsString("s16le");
+        const int audio_start = args[29].AsInt(-1);
+        const int audio_skip = args[30].AsInt(0);
+        const char* container_name = args[31].AsString("raw");
+
+        if (width < static_cast<int>(MIN_WIDTH)
+                || height < static_cast<int>(MIN_HEIGHT)) {
+            sprintf(buff, "width and height need to be %u x %u or lower.",
+                    MIN_WIDTH, MIN_HEIGHT);
+            throw std::runtime_error(buff);
+        }
+        if (width >= static_cast<int>(MAX_WIDTH)
+                || height >= static_cast<int>(MAX_HEIGHT)) {
+            sprintf(buff, "width and height need to be lower than %u x %u.",
+                    MAX_WIDTH, MAX_HEIGHT);
+            throw std::runtime_error(buff);
+        }
+        validate(strlen(pix_type) > 15, "pixel_type is too long.");
+        validate(fpsnum < 1 || fpsden < 1,
+                 "fpsnum and fpsden need to be 1 or higher.");
+        validate(prefetch < 0, "prefetch needs to be 0 or higher.");
+        validate(prefetch_mem < 1, "prefetch_mem needs to be 1 or higher.");
+        validate(live && live_frames < 1,
+                 "live_frames needs to be 1 or higher when live=true.");
+        validate(live_timeout < 0, "live_timeout needs to be 0 or higher.");
+        validate(cache_mem < 0, "cache_mem needs to be 0 or higher.");
+        validate(audio_rate < 0, "audio_rate needs to be 0 or higher.");
+        validate(audio_channels < 1 || audio_channels > 32,
+                 "audio_channels needs to be 1 to 32.");
+        validate(audio_skip < 0, "audio_skip needs to be 0 or higher.");
+
+        int container = CONTAINER_RAW;
+        if (!stricmp(container_name, "mov")) {
+            container = CONTAINER_MOV;
+            validate(strlen(index) > 0,
+                     "index can not be used with container=\"mov\".");
+            validate(live, "live can not be used with container=\"mov\".");
+            // the codec of the track is used unless it is given.
+            if (!args[3].Defined()) {
+                pix_type = "";
+            }
+        } else {
+            validate(stricmp(container_name, "raw") != 0,
+                     "container needs to be \"raw\" or \"mov\".");
+        }
+
+        int field = FIELD_NONE;
+        if (!stricmp(field_name, "top")) {
+            field = FIELD_TOP;
+        } else if (!stricmp(field_name, "bottom")) {
+            field = FIELD_BOTTOM;
+        } else {
+            validate(stricmp(field_name, "none") != 0,
+                     "field needs to be \"none\", \"top\" or \"bottom\".");
+        }
+
+        return new RawSource(source, width, height, pix_type, fpsnum, fpsden,
+                             index, show, use_mmap, prefetch, prefetch_mem,
+                             msb, index_cache, live, live_frames,
+                             live_timeout, direct, use_stats, stats_file,
+                             crop_left, crop_top, crop_right, crop_bottom,
+                             field, planar_output, cache_mem, audio_rate,
+                             audio_channels, audio_type, audio_start,
+                             audio_skip, container);
+
+    } catch (std::runtime_error& e) {
+        env->ThrowError("RawSource: %s", e.what());
+    }
+    return 0;
+}
+
+
+const AVS_Linkage* AVS_linkage = nullptr;
+
+
+extern "C" __declspec(dllexport) const char* __stdcall
+AvisynthPluginInit3(ise_t* env, const AVS_Linkage* const vectors)
+{
+    AVS_linkage = vectors;
+
+    const char* args =
+        "[file]s"
+        "[width]i"
+        "[height]i"
+        "[pixel_type]s"
+        "[fpsnum]i"
+        "[fpsden]i"
+        "[index]s"
+        "[show]b"
+        "[mmap]b"
+        "[prefetch]i"
+        "[prefetch_mem]i"
+        "[msb]b"
+        "[index_cache]b"
+        "[live]b"
+        "[live_frames]i"
+        "[live_timeout]i"
+        "[direct]b"
+        "[stats]b"
+        "[stats_file]s"
+        "[crop_left]i"
+        "[crop_top]i"
+        "[crop_right]i"
+        "[crop_bottom]i"
+        "[field]s"
+        "[planar_output]b"
+        "[cache_mem]i"
+        "[audio_rate]i"
+        "[audio_channels]i"
+        "[audio_format]s"
+        "[audio_start]i"
+        "[audio_skip]i"
+        "[container]s";
+
+    env->AddFunction("RawSource", args, create_rawsource, nullptr);
+    env->AddFunction("RawWrite", "c[file]s[pixel_type]s[y4m]b[buffers]i"
+                     "[direct]b[compress]b", create_rawwrite, nullptr);
+
+    if (env->FunctionExists("SetFilterMTMode")) {
+        static_cast<IScriptEnvironment2*>(
+            env)->SetFilterMTMode("RawSource", MT_NICE_FILTER, true);
+        static_cast<IScriptEnvironment2*>(
+            env)->SetFilterMTMode("RawWrite", MT_NICE_FILTER, true);
+    }
+
+    return "RawSource for AviSynth2.6x/Avisynth+.";
+}
+
@@ -0,0 +1,586 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <algorithm>
+#include <malloc.h>
+#include "common.h"
+
+
+// the size of one mapped window. a window is enlarged when one request
+// does not fit into it.
+constexpr size_t MAP_WINDOW_SIZE = sizeof(void*) == 4 ? 32 << 20 : 256 << 20;
+
+// how many monotonic accesses are needed to be treated as sequential.
+constexpr int SEQ_THRESHOLD = 2;
+
+// ReadFile() takes a DWORD size.
+constexpr size_t MAX_READ_SIZE = 1 << 30;
+
+// how many reads of a batch are in flight at once.
+constexpr size_t MAX_QUEUE_DEPTH = 32;
+
+// how often the length of a growing file is checked (ms).
+constexpr DWORD LIVE_POLL_INTERVAL = 10;
+
+// the smallest alignment of unbuffered reads. a page covers the sectors
+// of 512 byte and 4K sector drives.
+constexpr size_t DIRECT_ALIGNMENT = 4096;
+
+
+struct memory_range_entry {
+    void* address;
+    size_t size;
+};
+
+typedef BOOL (WINAPI *prefetch_virtual_memory_t)(
+    HANDLE, ULONG_PTR, memory_range_entry*, ULONG);
+
+// PrefetchVirtualMemory is available on Windows 8 or later.
+static prefetch_virtual_memory_t get_prefetch_func() noexcept
+{
+    HMODULE kernel32 = GetModuleHandle("kernel32.dll");
+    if (!kernel32) {
+        return nullptr;
+    }
+    return reinterpret_cast<prefetch_virtual_memory_t>(
+        GetProcAddress(kernel32, "PrefetchVirtualMemory"));
+}
+
+
+// every thread waits for its own overlapped reads with its own event.
+struct io_event {
+    HANDLE handle;
+    io_event() : handle(CreateEvent(nullptr, TRUE, FALSE, nullptr)) {}
+    ~io_event() { if (handle) CloseHandle(handle); }
+};
+
+static thread_local io_event tls_event;
+static thread_local io_event tls_batch_events[MAX_QUEUE_DEPTH];
+
+
+// unbuffered reads and writes have to be aligned to the sector size of
+// the volume.
+size_t get_sector_size(const char* source) noexcept
+{
+    char root[MAX_PATH];
+    DWORD sectors, bytes, free_clusters, clusters;
+    if (!GetVolumePathName(source, root, MAX_PATH)
+            || !GetDiskFreeSpace(root, &sectors, &bytes, &free_clusters,
+                                 &clusters)) {
+        return DIRECT_ALIGNMENT;
+    }
+    return std::max<size_t>(bytes, DIRECT_ALIGNMENT);
+}
+
+
+// readers which can not do better read the batch one by one.
+size_t RawReader::read_batch(const read_request* reqs, size_t count) noexcept
+{
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        total += read(reqs[i].buff, reqs[i].size, reqs[i].pos);
+    }
+    return total;
+}
+
+
+/*
+  Adds the reads of a plane at pos which go directly into the destination
+  frame. If the plane is contiguous (pitch == rowsize), it is one read for
+  the whole plane. Otherwise each row is read straight into its place.
+*/
+void RawReader::add_plane(std::vector<read_request>& batch, uint8_t* dstp,
+                          int pitch, int rowsize, int height, int64_t pos)
+{
+    if (pitch == rowsize) {
+        batch.push_back({dstp, static_cast<size_t>(rowsize) * height, pos});
+        return;
+    }
+    for (int y = 0; y < height; ++y) {
+        batch.push_back({dstp, static_cast<size_t>(rowsize), pos});
+        dstp += pitch;
+        pos += rowsize;
+    }
+}
+
+
+void RawReader::read_plane(uint8_t* dstp, int pitch, int rowsize, int height,
+                           int64_t pos) noexcept
+{
+    static thread_local std::vector<read_request> batch;
+    batch.clear();
+    add_plane(batch, dstp, pitch, rowsize, height, pos);
+    read_batch(batch.data(), batch.size());
+}
+
+
+FileReader::FileReader(const char* source, bool use_mmap, bool use_direct) :
+    useMap(use_mmap && !use_direct), useDirect(use_direct), mapping(nullptr),
+    granularity(65536), pageSize(4096), windowSize(MAP_WINDOW_SIZE),
+    sectorSize(DIRECT_ALIGNMENT)
+{
+    DWORD flags = FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED;
+    if (useDirect) {
+        flags |= FILE_FLAG_NO_BUFFERING;
+        sectorSize = get_sector_size(source);
+    }
+    fileHandle = CreateFile(source, GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                            OPEN_EXISTING, flags, nullptr);
+    validate(fileHandle == INVALID_HANDLE_VALUE, "Cannot open videofile.");
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fileHandle, &size)) {
+        CloseHandle(fileHandle);
+        throw std::runtime_error("Cannot get videofile length.");
+    }
+    fileSize = size.QuadPart;
+
+    if (!useMap || fileSize == 0) {
+        useMap = false;
+        return;
+    }
+
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    granularity = si.dwAllocationGranularity;
+    pageSize = si.dwPageSize;
+
+    mapping = CreateFileMapping(fileHandle, nullptr, PAGE_READONLY, 0, 0,
+                                nullptr);
+    if (!mapping) {
+        CloseHandle(fileHandle);
+        throw std::runtime_error("Cannot create file mapping.");
+    }
+}
+
+
+FileReader::~FileReader()
+{
+    for (auto& w : windows) {
+        if (w.second.stage) {
+            _aligned_free(w.second.stage);
+        } else if (w.second.view) {
+            UnmapViewOfFile(w.second.view);
+        }
+    }
+    if (mapping) {
+        CloseHandle(mapping);
+    }
+    CloseHandle(fileHandle);
+}
+
+
+FileReader::window& FileReader::get_window()
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = windows.find(std::this_thread::get_id());
+    if (it == windows.end()) {
+        window w = { nullptr, 0, 0, 0, SEQ_THRESHOLD, nullptr, 0, 0, 0 };
+        it = windows.emplace(std::this_thread::get_id(), w).first;
+    }
+    return it->second;
+}
+
+
+/*
+  Unmaps the window of the calling thread and forgets it, for a thread
+  which has moved on to another file.
+*/
+void FileReader::drop_window() noexcept
+{
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = windows.find(std::this_thread::get_id());
+    if (it == windows.end()) {
+        return;
+    }
+    if (it->second.stage) {
+        _aligned_free(it->second.stage);
+    } else if (it->second.view) {
+        UnmapViewOfFile(it->second.view);
+    }
+    windows.erase(it);
+}
+
+
+/*
+  Returns a pointer to [pos, pos + size) inside the window of the thread.
+  If the range is out of the window, the window is slid over it.
+  For monotonic access the new window starts at pos, otherwise it ends at
+  pos + size so that scrubbing backwards does not remap on every frame.
+  With direct, the window is filled by fill() instead.
+*/
+const uint8_t* FileReader::map(window& w, int64_t pos, size_t size) noexcept
+{
+    const int64_t end = pos + static_cast<int64_t>(size);
+    if (pos < 0 || end > fileSize) {
+        return nullptr;
+    }
+
+    if (!w.view || pos < w.viewPos || end > w.viewPos + (int64_t)w.viewSize) {
+        if (useDirect) {
+            return fill(w, pos, end) ? w.view + (pos - w.viewPos) : nullptr;
+        }
+        if (w.view) {
+            UnmapViewOfFile(w.view);
+            w.view = nullptr;
+        }
+
+        int64_t start = pos;
+        if (w.seqCount < SEQ_THRESHOLD) {
+            start = std::max<int64_t>(end - (int64_t)windowSize, 0);
+        }
+        start -= start % granularity;
+        int64_t len = std::max<int64_t>(windowSize, end - start);
+        len = std::min(len, fileSize - start);
+
+        w.view = reinterpret_cast<const uint8_t*>(MapViewOfFile(
+            mapping, FILE_MAP_READ, static_cast<DWORD>(start >> 32),
+            static_cast<DWORD>(start & 0xFFFFFFFF), static_cast<size_t>(len)));
+        if (!w.view) {
+            return nullptr;
+        }
+        w.viewPos = start;
+        w.viewSize = static_cast<size_t>(len);
+    }
+
+    return w.view + (pos - w.viewPos);
+}
+
+
+/*
+  Reads the whole sectors around [pos, end) into the window of the thread.
+  If pos is in the frame given to hint(), the rest of that frame is read
+  with it, so a frame is one request however its planes are consumed.
+*/
+bool FileReader::fill(window& w, int64_t pos, int64_t end) noexcept
+{
+    const int64_t sector = static_cast<int64_t>(sectorSize);
+    if (pos >= w.frameStart && pos < w.frameEnd) {
+        end = std::max(end, std::min<int64_t>(w.frameEnd, fileSize));
+    }
+    const int64_t start = pos - pos % sector;
+    const size_t len = static_cast<size_t>(
+        (end - start + sector - 1) / sector * sector);
+
+    w.view = nullptr;
+    if (len > w.stageSize) {
+        _aligned_free(w.stage);
+        w.stage = reinterpret_cast<uint8_t*>(_aligned_malloc(len, sectorSize));
+        w.stageSize = w.stage ? len : 0;
+        if (!w.stage) {
+            return false;
+        }
+    }
+
+    const size_t got = read_at(w.stage, len, start);
+    if (start + static_cast<int64_t>(got) < end) {
+        return false;
+    }
+    w.view = w.stage;
+    w.viewPos = start;
+    w.viewSize = got;
+    return true;
+}
+
+
+/*
+  Drops the mapped pages of [pos, end) from the working set once they are
+  consumed. They stay in the standby list, but are the first to be reused,
+  so a long sequential read does not push out the data of other programs.
+*/
+void FileReader::release(window& w, int64_t pos, int64_t end) noexcept
+{
+    const int64_t page = static_cast<int64_t>(pageSize);
+    pos = std::max(pos, w.viewPos);
+    pos -= pos % page;
+    end = std::min(end, w.viewPos + static_cast<int64_t>(w.viewSize));
+    end -= end % page;
+    if (!w.view || end <= pos) {
+        return;
+    }
+    // unlocking pages which are not locked removes them from the working set.
+    VirtualUnlock(const_cast<uint8_t*>(w.view + (pos - w.viewPos)),
+                  static_cast<size_t>(end - pos));
+}
+
+
+/*
+  For a file which is still being written.
+  Checks the length of the file again until it is at least size, for up
+  to timeout ms. Returns false if the file did not grow enough in time.
+*/
+bool FileReader::wait_size(int64_t size, int timeout) noexcept
+{
+    const DWORD start = GetTickCount();
+    while (true) {
+        LARGE_INTEGER li;
+        if (GetFileSizeEx(fileHandle, &li) && li.QuadPart > fileSize) {
+            fileSize = li.QuadPart;
+        }
+        if (fileSize >= size) {
+            return true;
+        }
+        if (GetTickCount() - start >= static_cast<DWORD>(timeout)) {
+            return false;
+        }
+        Sleep(LIVE_POLL_INTERVAL);
+    }
+}
+
+
+/*
+  Access hint, called at the start of every frame of size bytes at pos.
+  While the frames of the thread are requested in ascending order, the
+  range of the next frame is prefetched into the mapping so that the page
+  faults overlap with the conversion, and the pages of the previous frame
+  are released. Random access leaves paging to the system.
+  With direct, the frame is remembered to be read with one request.
+  Reading through the system cache does not need any hint.
+*/
+void FileReader::hint(int64_t pos, size_t size) noexcept
+{
+    static const prefetch_virtual_memory_t prefetch = get_prefetch_func();
+
+    if (!useMap && !useDirect) {
+        return;
+    }
+
+    window& w = get_window();
+    if (useDirect) {
+        w.frameStart = pos;
+        w.frameEnd = pos + static_cast<int64_t>(size);
+        return;
+    }
+
+    int64_t stride = pos - w.lastPos;
+    if (stride >= 0) {
+        w.seqCount = std::min(w.seqCount + 1, SEQ_THRESHOLD);
+    } else {
+        w.seqCount = 0;
+    }
+    w.lastPos = pos;
+
+    if (w.seqCount >= SEQ_THRESHOLD && stride > 0) {
+        release(w, pos - stride, pos);
+    }
+
+    if (!prefetch || w.seqCount < SEQ_THRESHOLD || stride == 0
+            || !map(w, pos, 0)) {
+        return;
+    }
+
+    int64_t next = pos + stride;
+    int64_t end = std::min(next + stride, w.viewPos + (int64_t)w.viewSize);
+    if (next >= end) {
+        return;
+    }
+
+    memory_range_entry range = {
+        const_cast<uint8_t*>(w.view + (next - w.viewPos)),
+        static_cast<size_t>(end - next)
+    };
+    prefetch(GetCurrentProcess(), 1, &range, 0);
+}
+
+
+// overlapped ReadFile() at pos until size bytes or the end of file.
+size_t FileReader::read_at(uint8_t* buff, size_t size, int64_t pos) noexcept
+{
+    size_t read = 0;
+    while (read < size) {
+        OVERLAPPED ov = {};
+        ov.Offset = static_cast<DWORD>((pos + read) & 0xFFFFFFFF);
+        ov.OffsetHigh = static_cast<DWORD>((pos + read) >> 32);
+        ov.hEvent = tls_event.handle;
+        DWORD req = static_cast<DWORD>(std::min(size - read, MAX_READ_SIZE));
+        DWORD got = 0;
+        if (!ReadFile(fileHandle, buff + read, req, nullptr, &ov)
+                && GetLastError() != ERROR_IO_PENDING) {
+            break;
+        }
+        if (!GetOverlappedResult(fileHandle, &ov, &got, TRUE) || got == 0) {
+            break;
+        }
+        read += got;
+    }
+    return read;
+}
+
+
+/*
+  Copies size bytes at pos into buff.
+  Only the tail which could not be read (short read at the end of file)
+  is filled with zero.
+*/
+size_t FileReader::read(uint8_t* buff, size_t size, int64_t pos) noexcept
+{
+    size_t read = 0;
+
+    if (useMap || useDirect) {
+        read = static_cast<size_t>(
+            std::max<int64_t>(std::min<int64_t>(size, fileSize - pos), 0));
+        const uint8_t* srcp = map(get_window(), pos, read);
+        if (srcp) {
+            memcpy(buff, srcp, read);
+        } else if (useMap) {
+            // no view could be mapped (e.g. out of address space on 32bit).
+            read = read_at(buff, size, pos);
+        } else {
+            read = 0;
+        }
+    } else {
+        read = read_at(buff, size, pos);
+    }
+
+    if (read < size) {
+        memset(buff + read, 0, size - read);
+    }
+    return read;
+}
+
+
+/*
+  Issues the reads of a batch with up to MAX_QUEUE_DEPTH of them in flight,
+  so that the device sees them together instead of one at a time.
+  They are completed in order. A read which comes back short (end of
+  file, or a request larger than ReadFile() takes) is finished by read().
+  With mmap or direct the data is already in the window of the thread.
+*/
+size_t FileReader::read_batch(const read_request* reqs, size_t count) noexcept
+{
+    if (useMap || useDirect) {
+        return RawReader::read_batch(reqs, count);
+    }
+
+    OVERLAPPED ov[MAX_QUEUE_DEPTH];
+    bool issued[MAX_QUEUE_DEPTH];
+    size_t head = 0;
+    size_t tail = 0;
+    size_t total = 0;
+
+    while (head < count) {
+        for (; tail < count && tail - head < MAX_QUEUE_DEPTH; ++tail) {
+            const read_request& r = reqs[tail];
+            const size_t i = tail % MAX_QUEUE_DEPTH;
+            ov[i] = {};
+            ov[i].Offset = static_cast<DWORD>(r.pos & 0xFFFFFFFF);
+            ov[i].OffsetHigh = static_cast<DWORD>(r.pos >> 32);
+            ov[i].hEvent = tls_batch_events[i].handle;
+            const DWORD req = static_cast<DWORD>(
+                std::min(r.size, MAX_READ_SIZE));
+            issued[i] = ReadFile(fileHandle, r.buff, req, nullptr, &ov[i])
+                        || GetLastError() == ERROR_IO_PENDING;
+        }
+
+        const read_request& r = reqs[head];
+        const size_t i = head % MAX_QUEUE_DEPTH;
+        DWORD got = 0;
+        if (!issued[i]
+                || !GetOverlappedResult(fileHandle, &ov[i], &got, TRUE)) {
+            got = 0;
+        }
+        total += got;
+        if (got < r.size) {
+            total += read(r.buff + got, r.size - got, r.pos + got);
+        }
+        ++head;
+    }
+    return total;
+}
+
+
+/*
+  Returns size bytes at pos for kernels which convert the data.
+  With mmap this is a pointer into the mapping and nothing is copied,
+  with direct a pointer into the window of the thread.
+  Otherwise the data is read into buff.
+*/
+const uint8_t* FileReader::get(uint8_t* buff, size_t size, int64_t pos)
+noexcept
+{
+    if (useMap || useDirect) {
+        const uint8_t* srcp = map(get_window(), pos, size);
+        if (srcp) {
+            return srcp;
+        }
+    }
+
+    if (!buff) {
+        // the mapping failed and no staging buffer was given.
+        static thread_local std::vector<uint8_t> fallback;
+        fallback.resize(size);
+        buff = fallback.data();
+    }
+    read(buff, size, pos);
+    return buff;
+}
+
+
+size_t MemoryReader::read(uint8_t* buff, size_t size, int64_t pos) noexcept
+{
+    int64_t offset = pos - basePos;
+    size_t read = 0;
+    if (offset >= 0 && offset < static_cast<int64_t>(dataSize)) {
+        read = std::min(size, dataSize - static_cast<size_t>(offset));
+        memcpy(buff, data + offset, read);
+    }
+    if (read < size) {
+        memset(buff + read, 0, size - read);
+    }
+    return read;
+}
+
+
+const uint8_t* MemoryReader::get(uint8_t* buff, size_t size, int64_t pos)
+noexcept
+{
+    int64_t offset = pos - basePos;
+    if (offset >= 0 && offset + static_cast<int64_t>(size) <= (int64_t)dataSize) {
+        return data + offset;
+    }
+    read(buff, size, pos);
+    return buff;
+}
+
+
+BufferPool::~BufferPool()
+{
+    for (auto buff : buffers) {
+        _aligned_free(buff);
+    }
+}
+
+
+uint8_t* BufferPool::acquire() noexcept
+{
+    if (bufferSize == 0) {
+        return nullptr;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (!buffers.empty()) {
+            uint8_t* buff = buffers.back();
+            buffers.pop_back();
+            return buff;
+        }
+    }
+    return reinterpret_cast<uint8_t*>(_aligned_malloc(bufferSize, 16));
+}
+
+
+void BufferPool::release(uint8_t* buff) noexcept
+{
+    if (!buff) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    buffers.push_back(buff);
+}
@@ -0,0 +1,233 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#ifndef RAWSOURCE_READER_H
+#define RAWSOURCE_READER_H
+
+
+#include <cstdint>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <windows.h>
+
+
+// the unit of unbuffered I/O on the volume of path.
+size_t get_sector_size(const char* path) noexcept;
+
+
+// one read of a batch: size bytes at pos into buff.
+struct read_request {
+    uint8_t* buff;
+    size_t size;
+    int64_t pos;
+};
+
+
+/*
+  RawReader is what the writeDestFrame kernels read the frame data from.
+  Every read takes an explicit file offset, so one reader can serve
+  several threads at once.
+  The reads of a frame can be given as one batch, so that a reader can
+  have all of them in flight at once instead of one after another.
+*/
+class RawReader {
+public:
+    virtual ~RawReader() {}
+
+    virtual size_t read(uint8_t* buff, size_t size, int64_t pos) noexcept = 0;
+    virtual const uint8_t* get(uint8_t* buff, size_t size, int64_t pos)
+        noexcept = 0;
+    virtual size_t read_batch(const read_request* reqs, size_t count) noexcept;
+    void read_plane(uint8_t* dstp, int pitch, int rowsize, int height,
+                    int64_t pos) noexcept;
+    static void add_plane(std::vector<read_request>& batch, uint8_t* dstp,
+                          int pitch, int rowsize, int height, int64_t pos);
+};
+
+
+/*
+  SourceReader is what a clip is read from: one file, or a sequence of
+  files which are read as one.
+*/
+class SourceReader : public RawReader {
+public:
+    virtual int64_t size() const noexcept = 0;
+    virtual bool mapped() const noexcept = 0;
+    virtual bool direct() const noexcept = 0;
+    virtual bool wait_size(int64_t size, int timeout) noexcept = 0;
+    virtual void hint(int64_t pos, size_t size) noexcept = 0;
+};
+
+
+/*
+  FileReader reads the source file.
+  Without mmap, data is read with overlapped ReadFile() at the offset,
+  and the reads of a batch are issued together.
+  With mmap, the file is mapped through a sliding window per thread and
+  data is copied (or handed out) straight from the mapping.
+  With direct, the file is read without the system cache. The window of
+  a thread is then a sector aligned buffer which holds the whole sectors
+  of the current frame, and data is handed out from it like from a mapping.
+*/
+class FileReader : public SourceReader {
+
+    struct window {
+        const uint8_t* view;
+        int64_t viewPos;
+        size_t viewSize;
+        int64_t lastPos;
+        int seqCount;
+        uint8_t* stage;     // buffer of the window with direct
+        size_t stageSize;
+        int64_t frameStart;
+        int64_t frameEnd;
+    };
+
+    HANDLE fileHandle;
+    std::atomic<int64_t> fileSize;
+
+    bool useMap;
+    bool useDirect;
+    HANDLE mapping;
+    size_t granularity;
+    size_t pageSize;
+    size_t windowSize;
+    size_t sectorSize;
+
+    std::mutex mtx;
+    std::unordered_map<std::thread::id, window> windows;
+
+    window& get_window();
+    const uint8_t* map(window& w, int64_t pos, size_t size) noexcept;
+    bool fill(window& w, int64_t pos, int64_t end) noexcept;
+    void release(window& w, int64_t pos, int64_t end) noexcept;
+    size_t read_at(uint8_t* buff, size_t size, int64_t pos) noexcept;
+
+public:
+    FileReader(const char* source, bool use_mmap, bool use_direct);
+    ~FileReader();
+
+    int64_t size() const noexcept override { return fileSize; }
+    bool mapped() const noexcept override { return useMap; }
+    bool direct() const noexcept override { return useDirect; }
+
+    bool wait_size(int64_t size, int timeout) noexcept override;
+    void hint(int64_t pos, size_t size) noexcept override;
+    size_t read(uint8_t* buff, size_t size, int64_t pos) noexcept override;
+    const uint8_t* get(uint8_t* buff, size_t size, int64_t pos)
+        noexcept override;
+    size_t read_batch(const read_request* reqs, size_t count)
+        noexcept override;
+    void drop_window() noexcept;
+};
+
+
+/*
+  SegmentReader reads a sequence of files (a capture split into chunks,
+  or one file per frame) as if they were one file. A read which crosses
+  the end of a file continues in the next one.
+  Only the most recently used files are kept open. The file a thread got
+  data from last is kept open until its next request, so that pointers
+  into a mapping stay valid as long as they do with FileReader. When the
+  thread moves on to another file, its window in that file is dropped.
+*/
+class SegmentReader : public SourceReader {
+
+    struct segment {
+        std::string path;
+        int64_t start;
+        int64_t size;
+    };
+
+    struct open_file {
+        std::shared_ptr<FileReader> reader;
+        std::list<int>::iterator lru;
+    };
+
+    std::vector<segment> segments;
+    int64_t totalSize;
+    bool useMap;
+    bool useDirect;
+
+    std::mutex mtx;
+    std::list<int> lru;
+    std::unordered_map<int, open_file> files;
+    std::unordered_map<std::thread::id, std::shared_ptr<FileReader>> pinned;
+
+    int find(int64_t pos) const noexcept;
+    std::shared_ptr<FileReader> get_file(int i) noexcept;
+
+public:
+    SegmentReader(const char* source, bool use_mmap, bool use_direct);
+
+    static bool is_segmented(const char* source) noexcept;
+
+    int64_t size() const noexcept override { return totalSize; }
+    bool mapped() const noexcept override { return useMap; }
+    bool direct() const noexcept override { return useDirect; }
+    int count() const noexcept { return static_cast<int>(segments.size()); }
+
+    bool wait_size(int64_t size, int timeout) noexcept override;
+    void hint(int64_t pos, size_t size) noexcept override;
+    size_t read(uint8_t* buff, size_t size, int64_t pos) noexcept override;
+    const uint8_t* get(uint8_t* buff, size_t size, int64_t pos)
+        noexcept override;
+    size_t read_batch(const read_request* reqs, size_t count)
+        noexcept override;
+};
+
+
+/*
+  MemoryReader serves reads from a block of the file which is already in
+  memory (e.g. a prefetched frame). data holds the bytes from basePos.
+*/
+class MemoryReader : public RawReader {
+
+    const uint8_t* data;
+    int64_t basePos;
+    size_t dataSize;
+
+public:
+    MemoryReader(const uint8_t* d, int64_t pos, size_t size) :
+        data(d), basePos(pos), dataSize(size) {}
+
+    size_t read(uint8_t* buff, size_t size, int64_t pos) noexcept override;
+    const uint8_t* get(uint8_t* buff, size_t size, int64_t pos)
+        noexcept override;
+};
+
+
+/*
+  Pool of aligned staging buffers. A buffer is taken for one GetFrame()
+  call and returned after that, so concurrent calls never share one.
+*/
+class BufferPool {
+
+    std::mutex mtx;
+    std::vector<uint8_t*> buffers;
+    size_t bufferSize;
+
+public:
+    BufferPool() : bufferSize(0) {}
+    ~BufferPool();
+
+    size_t size() const noexcept { return bufferSize; }
+    void set_size(size_t size) noexcept { bufferSize = size; }
+    uint8_t* acquire() noexcept;
+    void release(uint8_t* buff) noexcept;
+};
+
+#endif //RAWSOURCE_READER_H
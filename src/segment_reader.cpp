@@ -0,0 +1,412 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include "common.h"
+
+
+// how many files of a sequence are kept open at once.
+constexpr size_t MAX_OPEN_SEGMENTS = 32;
+
+// the most threads used to check the files of a list.
+constexpr unsigned MAX_STAT_THREADS = 8;
+
+
+static std::string dir_of(const std::string& path)
+{
+    size_t p = path.find_last_of("\\/");
+    return p == std::string::npos ? std::string() : path.substr(0, p + 1);
+}
+
+
+static std::string to_lower(std::string s)
+{
+    for (auto& c : s) {
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    return s;
+}
+
+
+// a pattern needs exactly one integer conversion (e.g. %d, %06d).
+static bool check_pattern(const char* p) noexcept
+{
+    int conversions = 0;
+    for (; *p; ++p) {
+        if (*p != '%') {
+            continue;
+        }
+        if (*++p == '%') {
+            continue;
+        }
+        while (*p >= '0' && *p <= '9') ++p;
+        if (*p != 'd' && *p != 'i' && *p != 'u') {
+            return false;
+        }
+        ++conversions;
+    }
+    return conversions == 1;
+}
+
+
+/*
+  Lists the files of a numbered sequence. The directory is read once,
+  names and sizes come with the listing, instead of testing every name.
+  The sequence starts at the smallest number found and ends before the
+  first missing one.
+*/
+static void list_sequence(const char* pattern, std::vector<std::string>& paths,
+                          std::vector<int64_t>& sizes)
+{
+    validate(!check_pattern(pattern), "invalid file name pattern.");
+
+    const std::string dir = dir_of(pattern);
+    const char* name_pattern = pattern + dir.size();
+
+    std::unordered_map<std::string, int64_t> entries;
+    WIN32_FIND_DATA fd;
+    HANDLE h = FindFirstFileEx((dir + "*").c_str(), FindExInfoBasic, &fd,
+                               FindExSearchNameMatch, nullptr,
+                               FIND_FIRST_EX_LARGE_FETCH);
+    validate(h == INVALID_HANDLE_VALUE, "Cannot open videofile.");
+    do {
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            continue;
+        }
+        entries[to_lower(fd.cFileName)] =
+            (static_cast<int64_t>(fd.nFileSizeHigh) << 32) | fd.nFileSizeLow;
+    } while (FindNextFile(h, &fd));
+    FindClose(h);
+
+    // names are compared in lower case like the file system does.
+    const std::string lower_pattern = to_lower(name_pattern);
+    std::vector<char> name(strlen(name_pattern) + 32);
+    int first = INT_MAX;
+    for (const auto& e : entries) {
+        int n;
+        if (sscanf(e.first.c_str(), lower_pattern.c_str(), &n) != 1 || n < 0) {
+            continue;
+        }
+        snprintf(name.data(), name.size(), lower_pattern.c_str(), n);
+        if (e.first == name.data()) {
+            first = std::min(first, n);
+        }
+    }
+    validate(first == INT_MAX, "Cannot open videofile.");
+
+    for (int n = first; n < INT_MAX; ++n) {
+        snprintf(name.data(), name.size(), name_pattern, n);
+        auto it = entries.find(to_lower(name.data()));
+        if (it == entries.end()) {
+            break;
+        }
+        paths.push_back(dir + name.data());
+        sizes.push_back(it->second);
+    }
+}
+
+
+/*
+  Reads a list file, one file name per line. Relative names are relative
+  to the list. The files can be anywhere, so their sizes are queried from
+  several threads at once.
+*/
+static void read_list(const char* list, std::vector<std::string>& paths,
+                      std::vector<int64_t>& sizes)
+{
+    FILE* fp = fopen(list, "rb");
+    validate(!fp, "Cannot open list file.");
+    fseek(fp, 0, SEEK_END);
+    std::vector<char> text(ftell(fp) + 1, 0);
+    fseek(fp, 0, SEEK_SET);
+    fread(text.data(), 1, text.size() - 1, fp);
+    fclose(fp);
+
+    const std::string dir = dir_of(list);
+    for (char* line = strtok(text.data(), "\r\n"); line;
+            line = strtok(nullptr, "\r\n")) {
+        while (*line == ' ' || *line == '\t') ++line;
+        size_t len = strlen(line);
+        while (len > 0 && (line[len - 1] == ' ' || line[len - 1] == '\t')) {
+            --len;
+        }
+        if (len == 0 || line[0] == '#') {
+            continue;
+        }
+        std::string path(line, len);
+        bool absolute = path[0] == '\\' || path[0] == '/'
+                        || (path.size() > 1 && path[1] == ':');
+        paths.push_back(absolute ? path : dir + path);
+    }
+    validate(paths.empty(), "list file has no files.");
+
+    sizes.assign(paths.size(), -1);
+    const unsigned count = static_cast<unsigned>(std::min<size_t>(
+        std::max(std::min(std::thread::hardware_concurrency(),
+                          MAX_STAT_THREADS), 1u),
+        paths.size() / 64 + 1));
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < count; ++t) {
+        workers.emplace_back([&, t] {
+            for (size_t i = t; i < paths.size(); i += count) {
+                WIN32_FILE_ATTRIBUTE_DATA fa;
+                if (GetFileAttributesEx(paths[i].c_str(),
+                                        GetFileExInfoStandard, &fa)) {
+                    sizes[i] = (static_cast<int64_t>(fa.nFileSizeHigh) << 32)
+                               | fa.nFileSizeLow;
+                }
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (sizes[i] < 0) {
+            throw std::runtime_error("Cannot open " + paths[i] + ".");
+        }
+    }
+}
+
+
+/*
+  "@list" and names with one number conversion are several files. A file
+  of that very name (e.g. "100%_scale.yuv" or "@take1.yuv") is opened as
+  it is, like it always was.
+*/
+bool SegmentReader::is_segmented(const char* source) noexcept
+{
+    if (source[0] != '@' && !check_pattern(source)) {
+        return false;
+    }
+    WIN32_FILE_ATTRIBUTE_DATA fa;
+    return !GetFileAttributesEx(source, GetFileExInfoStandard, &fa);
+}
+
+
+SegmentReader::SegmentReader(const char* source, bool use_mmap,
+                             bool use_direct) :
+    totalSize(0), useMap(use_mmap && !use_direct), useDirect(use_direct)
+{
+    std::vector<std::string> paths;
+    std::vector<int64_t> sizes;
+    if (source[0] == '@') {
+        read_list(source + 1, paths, sizes);
+    } else {
+        list_sequence(source, paths, sizes);
+    }
+
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (sizes[i] == 0) {
+            continue;
+        }
+        segments.push_back({paths[i], totalSize, sizes[i]});
+        totalSize += sizes[i];
+    }
+    validate(segments.empty(), "videofiles are empty.");
+}
+
+
+int SegmentReader::find(int64_t pos) const noexcept
+{
+    auto it = std::upper_bound(segments.begin(), segments.end(), pos,
+        [](int64_t p, const segment& s) { return p < s.start; });
+    if (it == segments.begin() || pos >= totalSize) {
+        return -1;
+    }
+    return static_cast<int>(it - segments.begin()) - 1;
+}
+
+
+/*
+  Returns the reader of segment i, opening it if it is not open.
+  The least recently used file is closed when too many are open. A file
+  which is still in use by a thread is closed when that thread is done.
+  The file is pinned as the one the thread uses now.
+*/
+std::shared_ptr<FileReader> SegmentReader::get_file(int i) noexcept
+{
+    std::shared_ptr<FileReader> f;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = files.find(i);
+        if (it != files.end()) {
+            lru.splice(lru.begin(), lru, it->second.lru);
+            f = it->second.reader;
+        }
+    }
+
+    if (!f) {
+        // opening takes time, so it is done without holding the lock.
+        try {
+            f = std::make_shared<FileReader>(segments[i].path.c_str(), useMap,
+                                             useDirect);
+        } catch (...) {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = files.find(i);
+        if (it != files.end()) {
+            lru.splice(lru.begin(), lru, it->second.lru);
+            f = it->second.reader;
+        } else {
+            lru.push_front(i);
+            files[i] = {f, lru.begin()};
+            if (files.size() > MAX_OPEN_SEGMENTS) {
+                files.erase(lru.back());
+                lru.pop_back();
+            }
+        }
+    }
+
+    std::shared_ptr<FileReader> last;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto& p = pinned[std::this_thread::get_id()];
+        if (p != f) {
+            last = std::move(p);
+            p = f;
+        }
+    }
+    if (last) {
+        // the views of every open file would add up for each thread.
+        last->drop_window();
+    }
+    return f;
+}
+
+
+// a sequence of files does not grow.
+bool SegmentReader::wait_size(int64_t size, int timeout) noexcept
+{
+    return size <= totalSize;
+}
+
+
+void SegmentReader::hint(int64_t pos, size_t size) noexcept
+{
+    const int i = find(pos);
+    if ((!useMap && !useDirect) || i < 0) {
+        return;
+    }
+    const segment& s = segments[i];
+    auto f = get_file(i);
+    if (f) {
+        f->hint(pos - s.start, static_cast<size_t>(
+            std::min<int64_t>(size, s.start + s.size - pos)));
+    }
+}
+
+
+size_t SegmentReader::read(uint8_t* buff, size_t size, int64_t pos) noexcept
+{
+    size_t read = 0;
+    while (read < size) {
+        const int64_t p = pos + read;
+        const int i = find(p);
+        if (i < 0) {
+            break;
+        }
+        const segment& s = segments[i];
+        const size_t n = static_cast<size_t>(
+            std::min<int64_t>(size - read, s.start + s.size - p));
+        auto f = get_file(i);
+        const size_t got = f ? f->read(buff + read, n, p - s.start) : 0;
+        read += got;
+        if (got < n) {
+            break;
+        }
+    }
+
+    if (read < size) {
+        memset(buff + read, 0, size - read);
+    }
+    return read;
+}
+
+
+/*
+  Consecutive requests which are inside one file are passed on to the
+  reader of that file as one batch. A request across a file boundary is
+  read on its own.
+*/
+size_t SegmentReader::read_batch(const read_request* reqs, size_t count)
+noexcept
+{
+    static thread_local std::vector<read_request> batch;
+
+    size_t total = 0;
+    size_t i = 0;
+    while (i < count) {
+        const int seg = find(reqs[i].pos);
+        if (seg < 0) {
+            total += read(reqs[i].buff, reqs[i].size, reqs[i].pos);
+            ++i;
+            continue;
+        }
+
+        const segment& s = segments[seg];
+        batch.clear();
+        for (; i < count; ++i) {
+            const read_request& r = reqs[i];
+            if (r.pos < s.start
+                    || r.pos + static_cast<int64_t>(r.size) > s.start + s.size) {
+                break;
+            }
+            batch.push_back({r.buff, r.size, r.pos - s.start});
+        }
+        if (batch.empty()) {
+            total += read(reqs[i].buff, reqs[i].size, reqs[i].pos);
+            ++i;
+            continue;
+        }
+
+        auto f = get_file(seg);
+        if (f) {
+            total += f->read_batch(batch.data(), batch.size());
+            continue;
+        }
+        for (const auto& r : batch) {
+            memset(r.buff, 0, r.size);
+        }
+    }
+    return total;
+}
+
+
+/*
+  Data inside one file is handed out by its reader (from the mapping with
+  mmap). Data across a file boundary is read into buff.
+*/
+const uint8_t* SegmentReader::get(uint8_t* buff, size_t size, int64_t pos)
+noexcept
+{
+    const int i = find(pos);
+    if (i >= 0 && pos + static_cast<int64_t>(size)
+            <= segments[i].start + segments[i].size) {
+        auto f = get_file(i);
+        if (f) {
+            return f->get(buff, size, pos - segments[i].start);
+        }
+    }
+
+    if (!buff) {
+        static thread_local std::vector<uint8_t> fallback;
+        fallback.resize(size);
+        buff = fallback.data();
+    }
+    read(buff, size, pos);
+    return buff;
+}
@@ -1,224 +1,407 @@
-/*
-RawSource26 - reads raw video data files
-
-Author: Oka Motofumi (chikuzen.mo at gmail dot com)
-
-This program is rewriting of RawSource.dll(original author is Ernst Pech)
-for avisynth2.6x/Avisynth+.
-*/
-
-
-#include <cstdio>
-#include <cinttypes>
-#include "common.h"
-
-
-bool parse_y4m(std::vector<char>& header, VideoInfo& vi,
-               int64_t& header_offset, int64_t& frame_offset)
-{
-    const char* header_err = "YUV4MPEG2 header error.";
-    const char* unsupported = "This file's YUV4MPEG2 HEADER is unsupported.";
-
-    const char* Y4M_STREAM_MAGIC = "YUV4MPEG2";
-    const char* Y4M_FRAME_MAGIC = "FRAME";
-    constexpr size_t st_magic_len = 9;
-    constexpr size_t fr_magic_len = 5;
-
-    char* buff = header.data();
-    const size_t buffsize = header.size();
-
-    if (strncmp(buff, Y4M_STREAM_MAGIC, st_magic_len)) {
-        return false;
-    }
-
-    vi.height = 0;
-    vi.width = 0;
-    strcpy(buff, "i420");
-
-    unsigned int numerator = 0;
-    unsigned int denominator = 0;
-    char ctag[9] = {0};
-    int64_t i;
-    for (i = st_magic_len; i < buffsize && buff[i] != '\n'; ++i) {
-        if (!strncmp(buff + i, " W", 2)) {
-            i += 2;
-            sscanf(buff + i, "%d", &vi.width);
-        }
-
-        if (!strncmp(buff + i, " H", 2)) {
-            i += 2;
-            sscanf(buff + i, "%d", &vi.height);
-        }
-
-        if (!strncmp(buff + i, " I", 2)) {
-            i += 2;
-            validate(buff[i] == 'm', unsupported);
-            if (buff[i] == 't') {
-                vi.image_type = VideoInfo::IT_TFF;
-            } else if (buff[i] == 'b') {
-                vi.image_type = VideoInfo::IT_BFF;
-            }
-        }
-
-        if (!strncmp(buff + i, " F", 2)) {
-            i += 2;
-            sscanf(buff + i, "%u:%u", &numerator, &denominator);
-            validate(numerator == 0 || denominator == 0, header_err);
-            vi.SetFPS(numerator, denominator);
-        }
-
-        if (!strncmp(buff + i, " C", 2)) {
-            i += 2;
-            sscanf(buff + i, "%s", ctag);
-            if (!strncmp(ctag, "444alpha", 8)) {
-                strcpy(buff, "AYUV");
-            } else if (!strncmp(ctag, "444", 3)) {
-                strcpy(buff, "I444");
-            } else if (!strncmp(ctag, "422", 3)) {
-                strcpy(buff, "I422");
-            } else if (!strncmp(ctag, "411", 3)) {
-                strcpy(buff, "I411");
-            } else if (!strncmp(ctag, "420", 3)) {
-                strcpy(buff, "I420");
-            } else if (!strncmp(ctag, "mono", 4)) {
-                strcpy(buff, "GRAY");
-            } else {
-                throw std::runtime_error(header_err);
-            }
-        }
-    }
-
-    validate(!numerator || !denominator || !vi.width || !vi.height, header_err);
-
-    ++i;
-
-    validate(strncmp(buff + i, Y4M_FRAME_MAGIC, fr_magic_len) != 0, header_err);
-
-    header_offset = i;
-
-    i += fr_magic_len;
-
-    while (i < buffsize && buff[i] != '\n') ++i;
-
-    frame_offset = i - header_offset + 1;
-    header_offset += frame_offset;
-
-    return true;
-}
-
-
-
-void set_rawindex(std::vector<rindex>& rawindex, const char* index,
-                  int64_t header_offset, int64_t frame_offset, size_t framesize)
-{
-    rawindex.reserve(2);
-
-    if (strlen(index) == 0) {
-        rawindex.emplace_back(0, header_offset);
-        rawindex.emplace_back(1, header_offset + frame_offset + framesize);
-        return;
-    }
-
-    std::vector<char> read_buff;
-    const char * pos = strchr(index, '.');
-    if (pos != nullptr) { //assume indexstring is a filename
-        FILE* indexfile = fopen(index, "r");
-        validate(!indexfile, "Cannot open indexfile.");
-        fseek(indexfile, 0, SEEK_END);
-        read_buff.resize(ftell(indexfile) + 1, 0);
-        fseek(indexfile, 0, SEEK_SET);
-        fread(read_buff.data(), 1, read_buff.size() - 1, indexfile);
-        fclose(indexfile);
-    } else {
-        read_buff.resize(strlen(index) + 1, 0);
-        strcpy(read_buff.data(), index);
-    }
-
-    //read all framenr:bytepos pairs
-    const char* seps = " \n";
-    for (char* token = strtok(read_buff.data(), seps);
-            token != nullptr;
-            token = strtok(nullptr, seps)) {
-        int num1 = -1;
-        int64_t num2 = -1;
-        char* p_del = strchr(token, ':');
-        if (!p_del)
-            break;
-        sscanf(token, "%d", &num1);
-        sscanf(p_del + 1, "%" SCNi64, &num2);
-
-        if ((num1 < 0) || (num2 < 0))
-            break;
-        rawindex.emplace_back(num1, num2);
-    }
-
-    validate(rawindex.size() == 0 || rawindex[0].number != 0,
-             "When using an index: frame 0 is mandatory"); //at least an entries for frame0
-
-}
-
-
-int generate_index(std::vector<i_struct>& index, std::vector<rindex>& rawindex,
-                   size_t framesize, int64_t filesize)
-{
-    int frame = 0;          //framenumber
-    int p_ri = 0;           //pointer to raw index
-    int delta = framesize;  //delta between 1 frame
-    int big_delta = 0;      //delta between many e.g. 25 frames
-    int big_steps = 0;      //how many big deltas have occured
-    int big_frame_step = 0; //how many frames is big_delta for?
-    int rimax = rawindex.size() - 1;
-    int maxframe = static_cast<int>(filesize / framesize);
-
-    //rawindex[1].bytepos - rawindex[0].bytepos;    //current bytepos delta
-    int64_t bytepos = rawindex[0].bytepos;
-    index[frame].type = 'K';
-
-    while ((frame < maxframe) && ((bytepos + framesize) <= filesize)) { //next frame must be readable
-        index[frame].index = bytepos;
-
-        if ((p_ri < rimax) && (rawindex[p_ri].number <= frame)) {
-            p_ri++;
-            big_steps = 1;
-        }
-        frame++;
-
-        if ((p_ri > 0) && (rawindex[p_ri - 1].number + big_steps * big_frame_step == frame)) {
-            bytepos = rawindex[p_ri - 1].bytepos + big_delta * big_steps;
-            big_steps++;
-            index[frame].type = 'B';
-        } else {
-            if (rawindex[p_ri].number == frame) {
-                bytepos = rawindex[p_ri].bytepos; //sync if framenumber is given in raw index
-                index[frame].type = 'K';
-            } else {
-                bytepos = bytepos + delta;
-                index[frame].type = 'D';
-            }
-        }
-
-        //check for new delta and big_delta
-        if ((p_ri > 0) && (rawindex[p_ri].number == rawindex[p_ri-1].number + 1)) {
-            delta = (int)(rawindex[p_ri].bytepos - rawindex[p_ri - 1].bytepos);
-        } else if (p_ri > 1) {
-            //if more than 1 frame difference and
-            //2 successive equal distances then remember as big_delta
-            //if second delta < first delta then reset
-            if (rawindex[p_ri].number - rawindex[p_ri - 1].number == rawindex[p_ri - 1].number - rawindex[p_ri - 2].number) {
-                big_frame_step = rawindex[p_ri].number - rawindex[p_ri - 1].number;
-                big_delta = (int)(rawindex[p_ri].bytepos - rawindex[p_ri - 1].bytepos);
-            } else {
-                if ((rawindex[p_ri].number - rawindex[p_ri - 1].number) < (rawindex[p_ri - 1].number - rawindex[p_ri - 2].number)) {
-                    big_delta = 0;
-                    big_frame_step = 0;
-                }
-                if (frame >= rawindex[p_ri].number) {
-                    big_delta = 0;
-                    big_frame_step = 0;
-                }
-            }
-        }
-    }
-    return frame;
-}
-
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cinttypes>
+#include <climits>
+#include <algorithm>
+#include <intrin.h>
+#include "common.h"
+
+
+int get_cpu_features() noexcept
+{
+    int regs[4] = {};
+    int features = 0;
+
+    __cpuid(regs, 0);
+    const int max_leaf = regs[0];
+
+    __cpuid(regs, 1);
+    if (regs[3] & (1 << 26)) features |= CPU_SSE2;
+    if (regs[2] & (1 << 9))  features |= CPU_SSSE3;
+    if (regs[2] & (1 << 19)) features |= CPU_SSE41;
+
+    // AVX2 needs the OS to save the ymm registers (OSXSAVE + XCR0).
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool avx = (regs[2] & (1 << 28)) != 0;
+    if (max_leaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x06) == 0x06) {
+        __cpuidex(regs, 7, 0);
+        if (regs[1] & (1 << 5)) features |= CPU_AVX2;
+    }
+
+    return features;
+}
+
+
+// a stream header longer than this is taken as a broken file.
+constexpr size_t Y4M_HEADER_MAX = 1 << 20;
+
+// FRAME headers are read in pieces of this size.
+constexpr size_t Y4M_FRAME_READ = 128;
+
+
+/*
+  Reads the whole YUV4MPEG2 stream header (up to the first newline) into
+  header. Returns false if the file does not start with the magic.
+*/
+bool read_y4m_header(RawReader& rd, int64_t filesize,
+                     std::vector<char>& header)
+{
+    size_t size = 256;
+    while (true) {
+        size = static_cast<size_t>(std::min<int64_t>(size, filesize));
+        header.assign(size + 1, 0);
+        rd.read(reinterpret_cast<uint8_t*>(header.data()), size, 0);
+        if (strncmp(header.data(), "YUV4MPEG2", 9)) {
+            return false;
+        }
+        if (memchr(header.data(), '\n', size)) {
+            return true;
+        }
+        validate(size == static_cast<size_t>(filesize)
+                 || size >= Y4M_HEADER_MAX, "YUV4MPEG2 header error.");
+        size *= 4;
+    }
+}
+
+
+bool parse_y4m(std::vector<char>& header, VideoInfo& vi,
+               int64_t& header_offset)
+{
+    const char* header_err = "YUV4MPEG2 header error.";
+    const char* unsupported = "This file's YUV4MPEG2 HEADER is unsupported.";
+
+    const char* Y4M_STREAM_MAGIC = "YUV4MPEG2";
+    constexpr size_t st_magic_len = 9;
+
+    char* buff = header.data();
+    const int64_t buffsize = static_cast<int64_t>(header.size());
+
+    if (strncmp(buff, Y4M_STREAM_MAGIC, st_magic_len)) {
+        return false;
+    }
+
+    vi.height = 0;
+    vi.width = 0;
+    strcpy(buff, "i420");
+
+    unsigned int numerator = 0;
+    unsigned int denominator = 0;
+    char ctag[9] = {0};
+    int64_t i;
+    for (i = st_magic_len; i < buffsize && buff[i] != '\n'; ++i) {
+        if (!strncmp(buff + i, " W", 2)) {
+            i += 2;
+            sscanf(buff + i, "%d", &vi.width);
+        }
+
+        if (!strncmp(buff + i, " H", 2)) {
+            i += 2;
+            sscanf(buff + i, "%d", &vi.height);
+        }
+
+        if (!strncmp(buff + i, " I", 2)) {
+            i += 2;
+            // 'm'ixed streams are read as progressive, the I parameter of
+            // each FRAME header is ignored.
+            if (buff[i] == 't') {
+                vi.image_type = VideoInfo::IT_TFF;
+            } else if (buff[i] == 'b') {
+                vi.image_type = VideoInfo::IT_BFF;
+            }
+        }
+
+        if (!strncmp(buff + i, " F", 2)) {
+            i += 2;
+            sscanf(buff + i, "%u:%u", &numerator, &denominator);
+            validate(numerator == 0 || denominator == 0, header_err);
+            vi.SetFPS(numerator, denominator);
+        }
+
+        if (!strncmp(buff + i, " C", 2)) {
+            i += 2;
+            sscanf(buff + i, "%8s", ctag);
+            // high bit depth tags are 420p10, 444p16, mono16 and so on.
+            int bits = ctag[3] == 'p' ? atoi(ctag + 4) : 0;
+            if (!strncmp(ctag, "444alpha", 8)) {
+                // planar, the alpha plane follows Cr.
+                strcpy(buff, "YUVA444");
+            } else if (!strncmp(ctag, "444", 3)) {
+                strcpy(buff, "I444");
+            } else if (!strncmp(ctag, "422", 3)) {
+                strcpy(buff, "I422");
+            } else if (!strncmp(ctag, "411", 3)) {
+                strcpy(buff, "I411");
+                validate(bits > 8, unsupported);
+            } else if (!strncmp(ctag, "420", 3)) {
+                strcpy(buff, "I420");
+            } else if (!strncmp(ctag, "mono", 4)) {
+                strcpy(buff, "GRAY");
+                bits = atoi(ctag + 4);
+            } else {
+                throw std::runtime_error(header_err);
+            }
+            if (bits > 8) {
+                validate(bits != 10 && bits != 12 && bits != 14 && bits != 16,
+                         unsupported);
+                // samples wider than 8bit are little endian.
+                if (buff[0] == 'G') {
+                    sprintf(buff, "GRAY%dLE", bits);
+                } else {
+                    sprintf(buff, "YUV%.3sP%dLE", ctag, bits);
+                }
+            }
+        }
+    }
+
+    validate(!numerator || !denominator || !vi.width || !vi.height, header_err);
+
+    validate(i >= buffsize, header_err);
+    header_offset = i + 1;
+
+    return true;
+}
+
+
+/*
+  Builds the exact offset of every frame of a YUV4MPEG2 stream.
+  Every frame is a FRAME header of any length (it may carry parameters)
+  followed by framesize bytes of data. Only the headers are read: the
+  scanner jumps over the frame data from one header to the next, so the
+  cost does not depend on the frame size.
+  Scanning stops at the first incomplete frame or broken header.
+*/
+int scan_y4m_frames(RawReader& rd, int64_t filesize, int64_t pos,
+                    size_t framesize, FrameIndex& index)
+{
+    const char* Y4M_FRAME_MAGIC = "FRAME";
+    constexpr size_t fr_magic_len = 5;
+
+    std::vector<char> line(Y4M_FRAME_READ);
+    int frames = 0;
+
+    while (pos + static_cast<int64_t>(fr_magic_len + 1 + framesize)
+           <= filesize) {
+        size_t size = static_cast<size_t>(
+            std::min<int64_t>(line.size(), filesize - pos));
+        rd.read(reinterpret_cast<uint8_t*>(line.data()), size, pos);
+        if (strncmp(line.data(), Y4M_FRAME_MAGIC, fr_magic_len)) {
+            break;
+        }
+
+        const char* nl = reinterpret_cast<const char*>(
+            memchr(line.data(), '\n', size));
+        while (!nl && size == line.size() && line.size() < Y4M_HEADER_MAX) {
+            // long frame parameters. read the whole header at once.
+            line.resize(line.size() * 4);
+            size = static_cast<size_t>(
+                std::min<int64_t>(line.size(), filesize - pos));
+            rd.read(reinterpret_cast<uint8_t*>(line.data()), size, pos);
+            nl = reinterpret_cast<const char*>(memchr(line.data(), '\n', size));
+        }
+        if (!nl) {
+            break;
+        }
+
+        const int64_t data = pos + (nl - line.data()) + 1;
+        if (data + static_cast<int64_t>(framesize) > filesize) {
+            break;
+        }
+        index.add(frames++, data, 'K');
+        pos = data + framesize;
+    }
+
+    return frames;
+}
+
+
+
+/*
+  Reads a non-negative decimal (or 0x prefixed hex) number from
+  [p, end). Trailing characters after the digits are ignored.
+*/
+static bool parse_number(const char* p, const char* end, int64_t& num)
+noexcept
+{
+    int64_t n = 0;
+    const char* start;
+    if (end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+        p += 2;
+        for (start = p; p < end; ++p) {
+            int d;
+            if (*p >= '0' && *p <= '9') d = *p - '0';
+            else if (*p >= 'a' && *p <= 'f') d = *p - 'a' + 10;
+            else if (*p >= 'A' && *p <= 'F') d = *p - 'A' + 10;
+            else break;
+            if (n > (INT64_MAX >> 4)) return false;
+            n = n * 16 + d;
+        }
+    } else {
+        for (start = p; p < end && *p >= '0' && *p <= '9'; ++p) {
+            if (n > (INT64_MAX - 9) / 10) return false;
+            n = n * 10 + (*p - '0');
+        }
+    }
+    num = n;
+    return p != start;
+}
+
+
+void set_rawindex(std::vector<rindex>& rawindex, const char* index,
+                  size_t framesize)
+{
+    rawindex.reserve(2);
+
+    if (strlen(index) == 0) {
+        rawindex.emplace_back(0, 0);
+        rawindex.emplace_back(1, framesize);
+        return;
+    }
+
+    std::vector<char> read_buff;
+    const char * pos = strchr(index, '.');
+    if (pos != nullptr) { //assume indexstring is a filename
+        FILE* indexfile = fopen(index, "rb");
+        validate(!indexfile, "Cannot open indexfile.");
+        fseek(indexfile, 0, SEEK_END);
+        read_buff.resize(ftell(indexfile) + 1, 0);
+        fseek(indexfile, 0, SEEK_SET);
+        fread(read_buff.data(), 1, read_buff.size() - 1, indexfile);
+        fclose(indexfile);
+    } else {
+        read_buff.resize(strlen(index) + 1, 0);
+        strcpy(read_buff.data(), index);
+    }
+
+    //read all framenr:bytepos pairs
+    const char* p = read_buff.data();
+    while (true) {
+        while (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t') ++p;
+        const char* end = p;
+        while (*end && *end != ' ' && *end != '\n' && *end != '\r'
+               && *end != '\t') ++end;
+        if (p == end) {
+            break;
+        }
+        const char* p_del = reinterpret_cast<const char*>(
+            memchr(p, ':', end - p));
+        int64_t num1 = -1;
+        int64_t num2 = -1;
+        if (!p_del || !parse_number(p, p_del, num1) || num1 > INT_MAX
+                || !parse_number(p_del + 1, end, num2)) {
+            break;
+        }
+        rawindex.emplace_back(static_cast<int>(num1), num2);
+        p = end;
+    }
+
+    validate(rawindex.size() == 0 || rawindex[0].number != 0,
+             "When using an index: frame 0 is mandatory"); //at least an entries for frame0
+
+}
+
+
+int generate_index(FrameIndex& index, std::vector<rindex>& rawindex,
+                   size_t framesize, int64_t filesize, int maxframe)
+{
+    int frame = 0;          //framenumber
+    int p_ri = 0;           //pointer to raw index
+    int delta = framesize;  //delta between 1 frame
+    int big_delta = 0;      //delta between many e.g. 25 frames
+    int big_steps = 0;      //how many big deltas have occured
+    int big_frame_step = 0; //how many frames is big_delta for?
+    int rimax = rawindex.size() - 1;
+
+    //rawindex[1].bytepos - rawindex[0].bytepos;    //current bytepos delta
+    int64_t bytepos = rawindex[0].bytepos;
+    char type = 'K';
+
+    while ((frame < maxframe) && ((bytepos + static_cast<int64_t>(framesize)) <= filesize)) { //next frame must be readable
+        //until the next entry of the raw index or the next big step, frames
+        //only add delta and nothing else changes. add them at once.
+        int64_t steps = maxframe - frame;
+        const int next = rawindex[p_ri].number;
+        if (next > frame) {
+            steps = std::min<int64_t>(steps, next - frame - 1);
+        } else if (p_ri < rimax) {
+            steps = 0;
+        }
+        if (p_ri > 0) {
+            int64_t big = rawindex[p_ri - 1].number
+                          + static_cast<int64_t>(big_steps) * big_frame_step;
+            if (big > frame) {
+                steps = std::min(steps, big - frame - 1);
+            }
+        }
+        if (delta > 0) {
+            steps = std::min<int64_t>(
+                steps, (filesize - framesize - bytepos) / delta + 1);
+        } else if (delta < 0) {
+            // the loop condition is unsigned, it also ends below zero.
+            steps = std::min<int64_t>(
+                steps, (bytepos + framesize) / -delta + 1);
+        }
+        if (steps > 1) {
+            index.add(frame, bytepos, type, static_cast<int>(steps), delta);
+            frame += static_cast<int>(steps);
+            bytepos += steps * delta;
+            type = 'D';
+            continue;
+        }
+
+        index.add(frame, bytepos, type);
+
+        if ((p_ri < rimax) && (rawindex[p_ri].number <= frame)) {
+            p_ri++;
+            big_steps = 1;
+        }
+        frame++;
+
+        if ((p_ri > 0) && (rawindex[p_ri - 1].number + big_steps * big_frame_step == frame)) {
+            bytepos = rawindex[p_ri - 1].bytepos + big_delta * big_steps;
+            big_steps++;
+            type = 'B';
+        } else {
+            if (rawindex[p_ri].number == frame) {
+                bytepos = rawindex[p_ri].bytepos; //sync if framenumber is given in raw index
+                type = 'K';
+            } else {
+                bytepos = bytepos + delta;
+                type = 'D';
+            }
+        }
+
+        //check for new delta and big_delta
+        if ((p_ri > 0) && (rawindex[p_ri].number == rawindex[p_ri-1].number + 1)) {
+            delta = (int)(rawindex[p_ri].bytepos - rawindex[p_ri - 1].bytepos);
+        } else if (p_ri > 1) {
+            //if more than 1 frame difference and
+            //2 successive equal distances then remember as big_delta
+            //if second delta < first delta then reset
+            if (rawindex[p_ri].number - rawindex[p_ri - 1].number == rawindex[p_ri - 1].number - rawindex[p_ri - 2].number) {
+                big_frame_step = rawindex[p_ri].number - rawindex[p_ri - 1].number;
+                big_delta = (int)(rawindex[p_ri].bytepos - rawindex[p_ri - 1].bytepos);
+            } else {
+                if ((rawindex[p_ri].number - rawindex[p_ri - 1].number) < (rawindex[p_ri - 1].number - rawindex[p_ri - 2].number)) {
+                    big_delta = 0;
+                    big_frame_step = 0;
+                }
+                if (frame >= rawindex[p_ri].number) {
+                    big_delta = 0;
+                    big_frame_step = 0;
+                }
+            }
+        }
+    }
+    return frame;
+}
+
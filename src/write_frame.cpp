@@ -1,130 +1,522 @@
-/*
-RawSource26 - reads raw video data files
-
-Author: Oka Motofumi (chikuzen.mo at gmail dot com)
-
-This program is rewriting of RawSource.dll(original author is Ernst Pech)
-for avisynth2.6x/Avisynth+.
-*/
-
-
-#include <io.h>
-#include <fcntl.h>
-#include <cstdint>
-#include "common.h"
-
-
-void __stdcall
-write_NV420(int fd, PVideoFrame& dst, uint8_t* buff, int* order, int count,
-            ise_t* env) noexcept
-{
-    int width = dst->GetRowSize(PLANAR_Y);
-    int height = dst->GetHeight(PLANAR_Y);
-    uint8_t* dstp = dst->GetWritePtr(PLANAR_Y);
-    int pitch = dst->GetPitch(PLANAR_Y);
-    int read_size = width * height;
-
-    memset(buff, 0, read_size);
-    _read(fd, buff, read_size);
-    env->BitBlt(dstp, pitch, buff, width, width, height);
-
-    read_size /= 2;
-    width /= 2;
-    height /= 2;
-    dstp = dst->GetWritePtr(order[1]);
-    pitch = dst->GetPitch(order[1]);
-    uint8_t* dstp2 = dst->GetWritePtr(order[2]);
-
-    memset(buff, 0, read_size);
-    _read(fd, buff, read_size);
-    for (int i = 0; i < height; i++) {
-        for (int j = 0; j < width; j++) {
-            dstp[j]  = buff[j * 2];
-            dstp2[j] = buff[j * 2 + 1];
-        }
-        buff += width;
-        dstp += pitch;
-        dstp2 += pitch;
-    }
-}
-
-
-void __stdcall
-write_planar(int fd, PVideoFrame& dst, uint8_t* buff, int* order, int count,
-             ise_t* env) noexcept
-{
-    for (int i = 0; i < count; i++) {
-        int debug = order[i];
-        int width = dst->GetRowSize(order[i]);
-        int height = dst->GetHeight(order[i]);
-        uint8_t* dstp = dst->GetWritePtr(order[i]);
-        int pitch = dst->GetPitch(order[i]);
-        int read_size = width * height;
-        memset(buff, 0, read_size);
-        _read(fd, buff, read_size);
-        env->BitBlt(dstp, pitch, buff, width, width, height);
-    }
-}
-
-
-void __stdcall
-write_packed(int fd, PVideoFrame& dst, uint8_t* buff, int* order, int count,
-             ise_t* env) noexcept
-{
-    int width = dst->GetRowSize();
-    int height = dst->GetHeight();
-    uint8_t* dstp = dst->GetWritePtr();
-    int pitch = dst->GetPitch();
-    int read_size = width * height;
-    memset(buff, 0, read_size);
-    _read(fd, buff, read_size);
-    env->BitBlt(dstp, pitch, buff, width, width, height);
-}
-
-
-void __stdcall
-write_packed_reorder(int fd, PVideoFrame& dst, uint8_t* buff, int* order,
-                     int count, ise_t* env) noexcept
-{
-    int width = dst->GetRowSize();
-    int height = dst->GetHeight();
-    uint8_t* dstp = dst->GetWritePtr();
-    int pitch = dst->GetPitch();
-    int read_size = width * height;
-    memset(buff, 0, width * height);
-    _read(fd, buff, read_size);
-
-    for (int i = 0; i < height; i++) {
-        for (int j = 0, time = width / count; j < time; j++) {
-            for (int k = 0; k < count; k++) {
-                dstp[j * count + k] = buff[j * count + order[k]];
-            }
-        }
-        buff += width;
-        dstp += pitch;
-    }
-}
-
-
-void __stdcall
-write_black_frame(PVideoFrame& dst, const VideoInfo& vi) noexcept
-{
-    uint8_t* dstp = dst->GetWritePtr();
-    size_t size = dst->GetPitch() * dst->GetHeight();
-
-    if (vi.IsYUY2()) {
-        uint32_t* d = reinterpret_cast<uint32_t*>(dstp);
-        std::fill(d, d + size / sizeof(uint32_t), 0x80008000);
-        return;
-    }
-
-    memset(dstp, 0, size);
-    if (vi.IsRGB() || vi.IsY8()) {
-        return;
-    }
-
-    size = dst->GetPitch(PLANAR_U) * dst->GetHeight(PLANAR_U);
-    memset(dst->GetWritePtr(PLANAR_U), 0x80, size);
-    memset(dst->GetWritePtr(PLANAR_V), 0x80, size);
-}
-
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <cstdint>
+#include "common.h"
+
+
+static void convert_row16_c(const uint8_t* srcp, uint8_t* dstp, int n,
+                            int fmt)
+{
+    const bool swap = (fmt & SAMPLE_BE) != 0;
+    const int shift = sample_shift(fmt);
+    const uint16_t mask = sample_mask(fmt);
+    const uint16_t* s = reinterpret_cast<const uint16_t*>(srcp);
+    uint16_t* d = reinterpret_cast<uint16_t*>(dstp);
+    for (int x = 0; x < n; ++x) {
+        d[x] = convert_sample(s[x], swap, shift, mask);
+    }
+}
+
+
+static void split_uv8_c(const uint8_t* srcp, uint8_t* dstp0, uint8_t* dstp1,
+                        int n, int)
+{
+    for (int x = 0; x < n; ++x) {
+        dstp0[x] = srcp[x * 2];
+        dstp1[x] = srcp[x * 2 + 1];
+    }
+}
+
+
+static void split_uv16_c(const uint8_t* srcp, uint8_t* dstp0, uint8_t* dstp1,
+                         int n, int fmt)
+{
+    const bool swap = (fmt & SAMPLE_BE) != 0;
+    const int shift = sample_shift(fmt);
+    const uint16_t mask = sample_mask(fmt);
+    const uint16_t* s = reinterpret_cast<const uint16_t*>(srcp);
+    uint16_t* d0 = reinterpret_cast<uint16_t*>(dstp0);
+    uint16_t* d1 = reinterpret_cast<uint16_t*>(dstp1);
+    for (int x = 0; x < n; ++x) {
+        d0[x] = convert_sample(s[x * 2], swap, shift, mask);
+        d1[x] = convert_sample(s[x * 2 + 1], swap, shift, mask);
+    }
+}
+
+
+static const row_funcs funcs_c = {
+    convert_row16_c, split_uv8_c, split_uv16_c
+};
+
+
+/*
+  Reads a 16bit plane which has to be converted (see SAMPLE_MSB/SAMPLE_BE).
+  The conversion is done while the rows are copied from the staging buffer
+  (or the mapping) into the frame.
+*/
+static void convert_plane16(RawReader& rd, int64_t pos, uint8_t* dstp,
+                            int pitch, int rowsize, int height, uint8_t* buff,
+                            int fmt, convert_row_t convert) noexcept
+{
+    const uint8_t* srcp = rd.get(buff, static_cast<size_t>(rowsize) * height,
+                                 pos);
+    for (int y = 0; y < height; ++y) {
+        convert(srcp, dstp, rowsize / 2, fmt);
+        srcp += rowsize;
+        dstp += pitch;
+    }
+}
+
+
+/*
+  16bit planar formats. count is the number of planes and order[3] is
+  the sample format, so a fourth plane is always alpha. Little endian LSB
+  aligned data is read straight into the frame like write_planar() does.
+*/
+void write_planar16_common(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                           uint8_t* buff, int* order, int count,
+                           const row_funcs& funcs) noexcept
+{
+    static thread_local std::vector<read_request> batch;
+    batch.clear();
+
+    const int fmt = order[3];
+    for (int i = 0; i < count; i++) {
+        const int plane = i < 3 ? order[i] : PLANAR_A;
+        int width = dst->GetRowSize(plane);
+        int height = dst->GetHeight(plane);
+        uint8_t* dstp = dst->GetWritePtr(plane);
+        int pitch = dst->GetPitch(plane);
+        if (sample_needs_conversion(fmt)) {
+            convert_plane16(rd, pos, dstp, pitch, width, height, buff, fmt,
+                            funcs.convert16);
+        } else {
+            RawReader::add_plane(batch, dstp, pitch, width, height, pos);
+        }
+        pos += static_cast<int64_t>(width) * height;
+    }
+    rd.read_batch(batch.data(), batch.size());
+}
+
+
+void __stdcall
+write_planar16(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+               int* order, int count, ise_t* env) noexcept
+{
+    write_planar16_common(rd, pos, dst, buff, order, count, funcs_c);
+}
+
+
+/*
+  Semi-planar formats: a luma plane followed by one plane of interleaved
+  chroma (NV12/NV21/NV16, P010/P016/P210/P216).
+  count is the bytes per sample and order[3] is the sample format of
+  16bit data. The luma plane is read straight into the frame unless it
+  has to be converted.
+*/
+void write_semi_planar_common(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                              uint8_t* buff, int* order, int count,
+                              const row_funcs& funcs) noexcept
+{
+    const int fmt = order[3];
+    const int rowsize = dst->GetRowSize(PLANAR_Y);
+    int height = dst->GetHeight(PLANAR_Y);
+    uint8_t* dstp = dst->GetWritePtr(PLANAR_Y);
+    int pitch = dst->GetPitch(PLANAR_Y);
+
+    if (sample_needs_conversion(fmt)) {
+        convert_plane16(rd, pos, dstp, pitch, rowsize, height, buff, fmt,
+                        funcs.convert16);
+    } else {
+        rd.read_plane(dstp, pitch, rowsize, height, pos);
+    }
+    pos += static_cast<int64_t>(rowsize) * height;
+
+    // a row of interleaved chroma is as long as a row of luma.
+    const int width = dst->GetRowSize(order[1]) / count;
+    height = dst->GetHeight(order[1]);
+    dstp = dst->GetWritePtr(order[1]);
+    uint8_t* dstp2 = dst->GetWritePtr(order[2]);
+    pitch = dst->GetPitch(order[1]);
+    split_uv_t split = count == 1 ? funcs.split8 : funcs.split16;
+
+    const uint8_t* srcp = rd.get(buff, static_cast<size_t>(rowsize) * height,
+                                 pos);
+    for (int y = 0; y < height; ++y) {
+        split(srcp, dstp, dstp2, width, fmt);
+        srcp += rowsize;
+        dstp += pitch;
+        dstp2 += pitch;
+    }
+}
+
+
+void __stdcall
+write_semi_planar(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+                  int* order, int count, ise_t* env) noexcept
+{
+    write_semi_planar_common(rd, pos, dst, buff, order, count, funcs_c);
+}
+
+
+// all planes of the frame are read as one batch.
+void __stdcall
+write_planar(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+             int* order, int count, ise_t* env) noexcept
+{
+    static thread_local std::vector<read_request> batch;
+    batch.clear();
+
+    for (int i = 0; i < count; i++) {
+        int width = dst->GetRowSize(order[i]);
+        int height = dst->GetHeight(order[i]);
+        RawReader::add_plane(batch, dst->GetWritePtr(order[i]),
+                             dst->GetPitch(order[i]), width, height, pos);
+        pos += width * height;
+    }
+    rd.read_batch(batch.data(), batch.size());
+}
+
+
+void __stdcall
+write_packed(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+             int* order, int count, ise_t* env) noexcept
+{
+    rd.read_plane(dst->GetWritePtr(), dst->GetPitch(), dst->GetRowSize(),
+                  dst->GetHeight(), pos);
+}
+
+
+void __stdcall
+write_packed_reorder(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                     uint8_t* buff, int* order, int count, ise_t* env) noexcept
+{
+    int width = dst->GetRowSize();
+    int height = dst->GetHeight();
+    uint8_t* dstp = dst->GetWritePtr();
+    int pitch = dst->GetPitch();
+    const uint8_t* srcp = rd.get(buff, static_cast<size_t>(width) * height,
+                                 pos);
+
+    for (int i = 0; i < height; i++) {
+        for (int j = 0, time = width / count; j < time; j++) {
+            for (int k = 0; k < count; k++) {
+                dstp[j * count + k] = srcp[j * count + order[k]];
+            }
+        }
+        srcp += width;
+        dstp += pitch;
+    }
+}
+
+
+// converts the pixels [x, width) of a row.
+void unpack_packed422_row_c(const uint8_t* srcp, uint8_t* dsty, uint8_t* dstu,
+                            uint8_t* dstv, int x, int width, const int* order)
+                            noexcept
+{
+    for (int j = x / 2; j < width / 2; ++j) {
+        const uint8_t* s = srcp + j * 4;
+        dsty[j * 2] = s[order[0]];
+        dstu[j] = s[order[1]];
+        dsty[j * 2 + 1] = s[order[2]];
+        dstv[j] = s[order[3]];
+    }
+}
+
+
+// dstp are the Y, U, V (and A if count is 4) rows.
+void unpack_packed444_row_c(const uint8_t* srcp, uint8_t* const* dstp, int x,
+                            int width, const int* order, int count) noexcept
+{
+    for (; x < width; ++x) {
+        const uint8_t* s = srcp + x * count;
+        for (int k = 0; k < count; ++k) {
+            dstp[k][x] = s[order[k]];
+        }
+    }
+}
+
+
+void __stdcall
+write_packed422(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+                int* order, int count, ise_t* env) noexcept
+{
+    const int width = dst->GetRowSize(PLANAR_Y);
+    const int height = dst->GetHeight(PLANAR_Y);
+    const size_t src_pitch = static_cast<size_t>(width) * 2;
+    uint8_t* dsty = dst->GetWritePtr(PLANAR_Y);
+    uint8_t* dstu = dst->GetWritePtr(PLANAR_U);
+    uint8_t* dstv = dst->GetWritePtr(PLANAR_V);
+    const int pitch_y = dst->GetPitch(PLANAR_Y);
+    const int pitch_uv = dst->GetPitch(PLANAR_U);
+    const uint8_t* srcp = rd.get(buff, src_pitch * height, pos);
+
+    for (int y = 0; y < height; ++y) {
+        unpack_packed422_row_c(srcp, dsty, dstu, dstv, 0, width, order);
+        srcp += src_pitch;
+        dsty += pitch_y;
+        dstu += pitch_uv;
+        dstv += pitch_uv;
+    }
+}
+
+
+static void unpack_packed444_c(const uint8_t* srcp, uint8_t* const* dstp,
+                               int width, const int* order, int count)
+{
+    unpack_packed444_row_c(srcp, dstp, 0, width, order, count);
+}
+
+
+/*
+  Packed 4:4:4 to planes. The rows of packed RGB are bottom-up in the
+  file (like the BGR24/BGR32 frames they are read into otherwise) and
+  planar RGB is top-down, so with rgb the rows are read from the last.
+*/
+void write_packed444_common(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                            uint8_t* buff, const int* order, int count,
+                            bool rgb, unpack444_row_t unpack) noexcept
+{
+    static const int yuv_planes[] = {PLANAR_Y, PLANAR_U, PLANAR_V, PLANAR_A};
+    static const int rgb_planes[] = {PLANAR_G, PLANAR_B, PLANAR_R, PLANAR_A};
+    const int* planes = rgb ? rgb_planes : yuv_planes;
+    const int width = dst->GetRowSize(planes[0]);
+    const int height = dst->GetHeight(planes[0]);
+    const size_t src_pitch = static_cast<size_t>(width) * count;
+    uint8_t* dstp[4];
+    int pitch[4];
+    for (int k = 0; k < count; ++k) {
+        dstp[k] = dst->GetWritePtr(planes[k]);
+        pitch[k] = dst->GetPitch(planes[k]);
+    }
+    const uint8_t* srcp = rd.get(buff, src_pitch * height, pos);
+    ptrdiff_t step = static_cast<ptrdiff_t>(src_pitch);
+    if (rgb) {
+        srcp += src_pitch * (height - 1);
+        step = -step;
+    }
+
+    for (int y = 0; y < height; ++y) {
+        unpack(srcp, dstp, width, order, count);
+        srcp += step;
+        for (int k = 0; k < count; ++k) {
+            dstp[k] += pitch[k];
+        }
+    }
+}
+
+
+void __stdcall
+write_packed444(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+                int* order, int count, ise_t* env) noexcept
+{
+    write_packed444_common(rd, pos, dst, buff, order, count, false,
+                           unpack_packed444_c);
+}
+
+
+void __stdcall
+write_packed_rgbp(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+                  int* order, int count, ise_t* env) noexcept
+{
+    write_packed444_common(rd, pos, dst, buff, order, count, true,
+                           unpack_packed444_c);
+}
+
+
+static inline uint16_t v210_sample(const uint32_t* s, int k)
+{
+    return (s[k / 3] >> (k % 3 * 10)) & 0x3FF;
+}
+
+
+/*
+  v210 row: three 10bit samples in the low 30 bits of every little endian
+  word, in the order Cb Y Cr Y. Converts the pixels [x, width).
+*/
+void unpack_v210_row_c(const uint8_t* srcp, uint16_t* dsty, uint16_t* dstu,
+                       uint16_t* dstv, int x, int width) noexcept
+{
+    const uint32_t* s = reinterpret_cast<const uint32_t*>(srcp);
+    for (int j = x / 2; j < width / 2; ++j) {
+        const int k = j * 4;
+        dstu[j] = v210_sample(s, k);
+        dsty[j * 2] = v210_sample(s, k + 1);
+        dstv[j] = v210_sample(s, k + 2);
+        dsty[j * 2 + 1] = v210_sample(s, k + 3);
+    }
+}
+
+
+// Y210/Y216 row: 16bit words in the order Y Cb Y Cr.
+void unpack_y210_row_c(const uint8_t* srcp, uint16_t* dsty, uint16_t* dstu,
+                       uint16_t* dstv, int x, int width, int fmt) noexcept
+{
+    const int shift = sample_shift(fmt);
+    const uint16_t mask = sample_mask(fmt);
+    const uint16_t* s = reinterpret_cast<const uint16_t*>(srcp);
+    for (int j = x / 2; j < width / 2; ++j) {
+        dsty[j * 2] = convert_sample(s[j * 4], false, shift, mask);
+        dstu[j] = convert_sample(s[j * 4 + 1], false, shift, mask);
+        dsty[j * 2 + 1] = convert_sample(s[j * 4 + 2], false, shift, mask);
+        dstv[j] = convert_sample(s[j * 4 + 3], false, shift, mask);
+    }
+}
+
+
+/*
+  r210/R10k row: one big endian word per pixel. order[0..2] are the bit
+  positions of R, G and B.
+*/
+void unpack_rgb10_row_c(const uint8_t* srcp, uint16_t* dstr, uint16_t* dstg,
+                        uint16_t* dstb, int x, int width, const int* order)
+                        noexcept
+{
+    for (; x < width; ++x) {
+        const uint8_t* p = srcp + x * 4;
+        const uint32_t w = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16)
+                         | (uint32_t(p[2]) << 8) | p[3];
+        dstr[x] = (w >> order[0]) & 0x3FF;
+        dstg[x] = (w >> order[1]) & 0x3FF;
+        dstb[x] = (w >> order[2]) & 0x3FF;
+    }
+}
+
+
+/*
+  Word packed 10bit formats are unpacked to 16bit planar frames.
+  v210 and r210 rows are padded, so the source pitch is not the width.
+*/
+void __stdcall
+write_v210(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+           int* order, int count, ise_t* env) noexcept
+{
+    const int width = dst->GetRowSize(PLANAR_Y) / 2;
+    const int height = dst->GetHeight(PLANAR_Y);
+    const size_t src_pitch = v210_row_size(width);
+    uint8_t* dsty = dst->GetWritePtr(PLANAR_Y);
+    uint8_t* dstu = dst->GetWritePtr(PLANAR_U);
+    uint8_t* dstv = dst->GetWritePtr(PLANAR_V);
+    const int pitch_y = dst->GetPitch(PLANAR_Y);
+    const int pitch_uv = dst->GetPitch(PLANAR_U);
+    const uint8_t* srcp = rd.get(buff, src_pitch * height, pos);
+
+    for (int y = 0; y < height; ++y) {
+        unpack_v210_row_c(srcp, reinterpret_cast<uint16_t*>(dsty),
+                          reinterpret_cast<uint16_t*>(dstu),
+                          reinterpret_cast<uint16_t*>(dstv), 0, width);
+        srcp += src_pitch;
+        dsty += pitch_y;
+        dstu += pitch_uv;
+        dstv += pitch_uv;
+    }
+}
+
+
+void __stdcall
+write_y210(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+           int* order, int count, ise_t* env) noexcept
+{
+    const int width = dst->GetRowSize(PLANAR_Y) / 2;
+    const int height = dst->GetHeight(PLANAR_Y);
+    const size_t src_pitch = static_cast<size_t>(width) * 4;
+    uint8_t* dsty = dst->GetWritePtr(PLANAR_Y);
+    uint8_t* dstu = dst->GetWritePtr(PLANAR_U);
+    uint8_t* dstv = dst->GetWritePtr(PLANAR_V);
+    const int pitch_y = dst->GetPitch(PLANAR_Y);
+    const int pitch_uv = dst->GetPitch(PLANAR_U);
+    const uint8_t* srcp = rd.get(buff, src_pitch * height, pos);
+
+    for (int y = 0; y < height; ++y) {
+        unpack_y210_row_c(srcp, reinterpret_cast<uint16_t*>(dsty),
+                          reinterpret_cast<uint16_t*>(dstu),
+                          reinterpret_cast<uint16_t*>(dstv), 0, width,
+                          order[3]);
+        srcp += src_pitch;
+        dsty += pitch_y;
+        dstu += pitch_uv;
+        dstv += pitch_uv;
+    }
+}
+
+
+void __stdcall
+write_rgb10(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+            int* order, int count, ise_t* env) noexcept
+{
+    const int width = dst->GetRowSize(PLANAR_G) / 2;
+    const int height = dst->GetHeight(PLANAR_G);
+    const size_t src_pitch = rgb10_row_size(width, order[3]);
+    uint8_t* dstr = dst->GetWritePtr(PLANAR_R);
+    uint8_t* dstg = dst->GetWritePtr(PLANAR_G);
+    uint8_t* dstb = dst->GetWritePtr(PLANAR_B);
+    const int pitch = dst->GetPitch(PLANAR_G);
+    const uint8_t* srcp = rd.get(buff, src_pitch * height, pos);
+
+    for (int y = 0; y < height; ++y) {
+        unpack_rgb10_row_c(srcp, reinterpret_cast<uint16_t*>(dstr),
+                           reinterpret_cast<uint16_t*>(dstg),
+                           reinterpret_cast<uint16_t*>(dstb), 0, width, order);
+        srcp += src_pitch;
+        dstr += pitch;
+        dstg += pitch;
+        dstb += pitch;
+    }
+}
+
+
+void __stdcall
+write_black_frame(PVideoFrame& dst, const VideoInfo& vi) noexcept
+{
+    uint8_t* dstp = dst->GetWritePtr();
+    size_t size = dst->GetPitch() * dst->GetHeight();
+
+    if (vi.IsYUY2()) {
+        uint32_t* d = reinterpret_cast<uint32_t*>(dstp);
+        std::fill(d, d + size / sizeof(uint32_t), 0x80008000);
+        return;
+    }
+
+    memset(dstp, 0, size);
+    if (vi.IsPlanarRGB() || vi.IsPlanarRGBA()) {
+        memset(dst->GetWritePtr(PLANAR_B), 0, size);
+        memset(dst->GetWritePtr(PLANAR_R), 0, size);
+        if (vi.IsPlanarRGBA() && vi.ComponentSize() == 2) {
+            const uint16_t opaque = (1 << vi.BitsPerComponent()) - 1;
+            uint16_t* d = reinterpret_cast<uint16_t*>(
+                dst->GetWritePtr(PLANAR_A));
+            std::fill(d, d + size / sizeof(uint16_t), opaque);
+        } else if (vi.IsPlanarRGBA()) {
+            memset(dst->GetWritePtr(PLANAR_A), 0xFF, size);
+        }
+        return;
+    }
+    if (vi.IsRGB() || vi.IsY()) {
+        return;
+    }
+    if (vi.IsYUVA()) {
+        memset(dst->GetWritePtr(PLANAR_A), 0xFF, size);
+    }
+
+    size = dst->GetPitch(PLANAR_U) * dst->GetHeight(PLANAR_U);
+    if (vi.ComponentSize() == 2) {
+        const uint16_t grey = 1 << (vi.BitsPerComponent() - 1);
+        for (int p : {PLANAR_U, PLANAR_V}) {
+            uint16_t* d = reinterpret_cast<uint16_t*>(dst->GetWritePtr(p));
+            std::fill(d, d + size / sizeof(uint16_t), grey);
+        }
+        return;
+    }
+    memset(dst->GetWritePtr(PLANAR_U), 0x80, size);
+    memset(dst->GetWritePtr(PLANAR_V), 0x80, size);
+}
+
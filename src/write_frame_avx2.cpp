@@ -0,0 +1,281 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <cstdint>
+#include <immintrin.h>
+#include "common.h"
+
+
+/*
+  AVX2 version of write_packed_reorder.
+  vpshufb shuffles inside each 128bit lane. For 32bit pixels both lanes
+  are contiguous. For 24bit pixels each lane holds 5 pixels (15 bytes),
+  so the lanes are loaded and stored separately at 15 bytes apart.
+*/
+void __stdcall
+write_packed_reorder_avx2(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                          uint8_t* buff, int* order, int count, ise_t* env)
+                          noexcept
+{
+    int width = dst->GetRowSize();
+    int height = dst->GetHeight();
+    uint8_t* dstp = dst->GetWritePtr();
+    int pitch = dst->GetPitch();
+    const uint8_t* srcp = rd.get(buff, static_cast<size_t>(width) * height,
+                                 pos);
+
+    const int step = 16 / count * count;
+    alignas(32) int8_t shuffle[32];
+    for (int i = 0; i < 16; ++i) {
+        shuffle[i] = shuffle[i + 16] = static_cast<int8_t>(
+            i < step ? i / count * count + order[i % count] : i);
+    }
+    const __m256i mask = _mm256_load_si256(reinterpret_cast<__m256i*>(shuffle));
+
+    for (int y = 0; y < height; ++y) {
+        int x = 0;
+        if (step == 16) {
+            for (; x + 32 <= width; x += 32) {
+                __m256i s = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i*>(srcp + x));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(dstp + x),
+                                    _mm256_shuffle_epi8(s, mask));
+            }
+        } else {
+            for (; x + step + 16 <= width; x += step * 2) {
+                __m256i s = _mm256_inserti128_si256(
+                    _mm256_castsi128_si256(_mm_loadu_si128(
+                        reinterpret_cast<const __m128i*>(srcp + x))),
+                    _mm_loadu_si128(
+                        reinterpret_cast<const __m128i*>(srcp + x + step)),
+                    1);
+                s = _mm256_shuffle_epi8(s, mask);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dstp + x),
+                                 _mm256_castsi256_si128(s));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dstp + x + step),
+                                 _mm256_extracti128_si256(s, 1));
+            }
+        }
+        for (; x + count <= width; x += count) {
+            for (int k = 0; k < count; ++k) {
+                dstp[x + k] = srcp[x + order[k]];
+            }
+        }
+        srcp += width;
+        dstp += pitch;
+    }
+    _mm256_zeroupper();
+}
+
+
+/*
+  Big endian words are swapped by vpshufb. The swap is folded into the
+  shuffle which deinterleaves UV, so it costs nothing there.
+*/
+static void convert_row16_avx2(const uint8_t* srcp, uint8_t* dstp, int n,
+                               int fmt)
+{
+    const bool swap = (fmt & SAMPLE_BE) != 0;
+    const int shift = sample_shift(fmt);
+    const uint16_t mask = sample_mask(fmt);
+    const __m128i sh = _mm_cvtsi32_si128(shift);
+    const __m256i mk = _mm256_set1_epi16(static_cast<short>(mask));
+    const __m256i order = _mm256_setr_epi8(
+        1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+        1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    const uint16_t* s = reinterpret_cast<const uint16_t*>(srcp);
+    uint16_t* d = reinterpret_cast<uint16_t*>(dstp);
+
+    int x = 0;
+    for (; x + 16 <= n; x += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + x));
+        if (swap) {
+            v = _mm256_shuffle_epi8(v, order);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + x),
+                            _mm256_and_si256(_mm256_srl_epi16(v, sh), mk));
+    }
+    for (; x < n; ++x) {
+        d[x] = convert_sample(s[x], swap, shift, mask);
+    }
+}
+
+
+// packus works per 128bit lane, so the quadwords are put back in order.
+static void split_uv8_avx2(const uint8_t* srcp, uint8_t* dstp0,
+                           uint8_t* dstp1, int n, int)
+{
+    const __m256i mask = _mm256_set1_epi16(0x00FF);
+
+    int x = 0;
+    for (; x + 32 <= n; x += 32) {
+        __m256i a = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(srcp + x * 2));
+        __m256i b = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(srcp + x * 2 + 32));
+        __m256i u = _mm256_packus_epi16(_mm256_and_si256(a, mask),
+                                        _mm256_and_si256(b, mask));
+        __m256i v = _mm256_packus_epi16(_mm256_srli_epi16(a, 8),
+                                        _mm256_srli_epi16(b, 8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dstp0 + x),
+                            _mm256_permute4x64_epi64(u, _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dstp1 + x),
+                            _mm256_permute4x64_epi64(v, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    for (; x < n; ++x) {
+        dstp0[x] = srcp[x * 2];
+        dstp1[x] = srcp[x * 2 + 1];
+    }
+}
+
+
+/*
+  vpshufb groups U and V of each lane, vpermq gathers U into the low lane
+  and V into the high lane, and two registers are joined by vperm2i128.
+*/
+static void split_uv16_avx2(const uint8_t* srcp, uint8_t* dstp0,
+                            uint8_t* dstp1, int n, int fmt)
+{
+    const bool swap = (fmt & SAMPLE_BE) != 0;
+    const int shift = sample_shift(fmt);
+    const uint16_t mask = sample_mask(fmt);
+    const __m128i sh = _mm_cvtsi32_si128(shift);
+    const __m256i mk = _mm256_set1_epi16(static_cast<short>(mask));
+    const __m256i order = swap ?
+        _mm256_setr_epi8(
+            1, 0, 5, 4, 9, 8, 13, 12, 3, 2, 7, 6, 11, 10, 15, 14,
+            1, 0, 5, 4, 9, 8, 13, 12, 3, 2, 7, 6, 11, 10, 15, 14) :
+        _mm256_setr_epi8(
+            0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15,
+            0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 6, 7, 10, 11, 14, 15);
+    const uint16_t* s = reinterpret_cast<const uint16_t*>(srcp);
+    uint16_t* d0 = reinterpret_cast<uint16_t*>(dstp0);
+    uint16_t* d1 = reinterpret_cast<uint16_t*>(dstp1);
+
+    int x = 0;
+    for (; x + 16 <= n; x += 16) {
+        __m256i a = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(s + x * 2));
+        __m256i b = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(s + x * 2 + 16));
+        a = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(a, order),
+                                     _MM_SHUFFLE(3, 1, 2, 0));
+        b = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(b, order),
+                                     _MM_SHUFFLE(3, 1, 2, 0));
+        __m256i u = _mm256_permute2x128_si256(a, b, 0x20);
+        __m256i v = _mm256_permute2x128_si256(a, b, 0x31);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d0 + x),
+                            _mm256_and_si256(_mm256_srl_epi16(u, sh), mk));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(d1 + x),
+                            _mm256_and_si256(_mm256_srl_epi16(v, sh), mk));
+    }
+    for (; x < n; ++x) {
+        d0[x] = convert_sample(s[x * 2], swap, shift, mask);
+        d1[x] = convert_sample(s[x * 2 + 1], swap, shift, mask);
+    }
+}
+
+
+static const row_funcs funcs_avx2 = {
+    convert_row16_avx2, split_uv8_avx2, split_uv16_avx2
+};
+
+
+void __stdcall
+write_planar16_avx2(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                    uint8_t* buff, int* order, int count, ise_t* env)
+                    noexcept
+{
+    write_planar16_common(rd, pos, dst, buff, order, count, funcs_avx2);
+    _mm256_zeroupper();
+}
+
+
+void __stdcall
+write_semi_planar_avx2(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                       uint8_t* buff, int* order, int count, ise_t* env)
+                       noexcept
+{
+    write_semi_planar_common(rd, pos, dst, buff, order, count, funcs_avx2);
+    _mm256_zeroupper();
+}
+
+
+/*
+  Like the SSSE3 version, with the pixels 0-15 in the low lane and 16-31
+  in the high lane of each register, so the transposed lanes are 32
+  contiguous samples of a plane.
+*/
+static void unpack_packed444_row_avx2(const uint8_t* srcp,
+                                      uint8_t* const* dstp, int width,
+                                      const int* order, int count)
+{
+    alignas(32) int8_t shuffle[32];
+    for (int k = 0; k < 4; ++k) {
+        for (int i = 0; i < 4; ++i) {
+            shuffle[k * 4 + i] = shuffle[16 + k * 4 + i] = static_cast<int8_t>(
+                k < count ? i * count + order[k] : -1);
+        }
+    }
+    const __m256i mask = _mm256_load_si256(reinterpret_cast<__m256i*>(shuffle));
+    const int step = count * 4;
+    auto load = [&](const uint8_t* s) {
+        return _mm256_shuffle_epi8(_mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(s))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + step * 4)),
+            1), mask);
+    };
+
+    int x = 0;
+    for (; (x + 28) * count + 16 <= width * count; x += 32) {
+        const uint8_t* s = srcp + x * count;
+        __m256i a = load(s);
+        __m256i b = load(s + step);
+        __m256i c = load(s + step * 2);
+        __m256i d = load(s + step * 3);
+        __m256i yu_ab = _mm256_unpacklo_epi32(a, b);
+        __m256i yu_cd = _mm256_unpacklo_epi32(c, d);
+        __m256i va_ab = _mm256_unpackhi_epi32(a, b);
+        __m256i va_cd = _mm256_unpackhi_epi32(c, d);
+        const __m256i planes[4] = {
+            _mm256_unpacklo_epi64(yu_ab, yu_cd),
+            _mm256_unpackhi_epi64(yu_ab, yu_cd),
+            _mm256_unpacklo_epi64(va_ab, va_cd),
+            _mm256_unpackhi_epi64(va_ab, va_cd),
+        };
+        for (int k = 0; k < count; ++k) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dstp[k] + x),
+                                planes[k]);
+        }
+    }
+    _mm256_zeroupper();
+    unpack_packed444_row_c(srcp, dstp, x, width, order, count);
+}
+
+
+void __stdcall
+write_packed444_avx2(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                     uint8_t* buff, int* order, int count, ise_t* env)
+                     noexcept
+{
+    write_packed444_common(rd, pos, dst, buff, order, count, false,
+                           unpack_packed444_row_avx2);
+}
+
+
+void __stdcall
+write_packed_rgbp_avx2(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                       uint8_t* buff, int* order, int count, ise_t* env)
+                       noexcept
+{
+    write_packed444_common(rd, pos, dst, buff, order, count, true,
+                           unpack_packed444_row_avx2);
+}
@@ -0,0 +1,501 @@
+/*
+RawSource26 - reads raw video data files
+
+Author: Oka Motofumi (chikuzen.mo at gmail dot com)
+
+This program is rewriting of RawSource.dll(original author is Ernst Pech)
+for avisynth2.6x/Avisynth+.
+*/
+
+
+#include <cstdint>
+#include <tmmintrin.h>
+#include "common.h"
+
+
+/*
+  pshufb version of write_packed_reorder.
+  One xmm holds 16 / count whole pixels (4 for 32bit, 5 for 24bit), so
+  the loop advances by step bytes and the unused tail of each store is
+  overwritten by the next one.
+*/
+void __stdcall
+write_packed_reorder_ssse3(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                           uint8_t* buff, int* order, int count, ise_t* env)
+                           noexcept
+{
+    int width = dst->GetRowSize();
+    int height = dst->GetHeight();
+    uint8_t* dstp = dst->GetWritePtr();
+    int pitch = dst->GetPitch();
+    const uint8_t* srcp = rd.get(buff, static_cast<size_t>(width) * height,
+                                 pos);
+
+    const int step = 16 / count * count;
+    alignas(16) int8_t shuffle[16];
+    for (int i = 0; i < 16; ++i) {
+        shuffle[i] = static_cast<int8_t>(
+            i < step ? i / count * count + order[i % count] : i);
+    }
+    const __m128i mask = _mm_load_si128(reinterpret_cast<__m128i*>(shuffle));
+
+    for (int y = 0; y < height; ++y) {
+        int x = 0;
+        for (; x + 16 <= width; x += step) {
+            __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcp + x));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dstp + x),
+                             _mm_shuffle_epi8(s, mask));
+        }
+        for (; x + count <= width; x += count) {
+            for (int k = 0; k < count; ++k) {
+                dstp[x + k] = srcp[x + order[k]];
+            }
+        }
+        srcp += width;
+        dstp += pitch;
+    }
+}
+
+
+static inline __m128i convert16_sse2(__m128i v, bool swap, __m128i shift,
+                                     __m128i mask)
+{
+    if (swap) {
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    }
+    return _mm_and_si128(_mm_srl_epi16(v, shift), mask);
+}
+
+
+static void convert_row16_sse2(const uint8_t* srcp, uint8_t* dstp, int n,
+                               int fmt)
+{
+    const bool swap = (fmt & SAMPLE_BE) != 0;
+    const int shift = sample_shift(fmt);
+    const uint16_t mask = sample_mask(fmt);
+    const __m128i sh = _mm_cvtsi32_si128(shift);
+    const __m128i mk = _mm_set1_epi16(static_cast<short>(mask));
+    const uint16_t* s = reinterpret_cast<const uint16_t*>(srcp);
+    uint16_t* d = reinterpret_cast<uint16_t*>(dstp);
+
+    int x = 0;
+    for (; x + 8 <= n; x += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + x));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d + x),
+                         convert16_sse2(v, swap, sh, mk));
+    }
+    for (; x < n; ++x) {
+        d[x] = convert_sample(s[x], swap, shift, mask);
+    }
+}
+
+
+// even bytes are masked out and odd bytes are shifted down, then packed.
+static void split_uv8_sse2(const uint8_t* srcp, uint8_t* dstp0,
+                           uint8_t* dstp1, int n, int)
+{
+    const __m128i mask = _mm_set1_epi16(0x00FF);
+
+    int x = 0;
+    for (; x + 16 <= n; x += 16) {
+        __m128i a = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(srcp + x * 2));
+        __m128i b = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(srcp + x * 2 + 16));
+        __m128i u = _mm_packus_epi16(_mm_and_si128(a, mask),
+                                     _mm_and_si128(b, mask));
+        __m128i v = _mm_packus_epi16(_mm_srli_epi16(a, 8),
+                                     _mm_srli_epi16(b, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dstp0 + x), u);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dstp1 + x), v);
+    }
+    for (; x < n; ++x) {
+        dstp0[x] = srcp[x * 2];
+        dstp1[x] = srcp[x * 2 + 1];
+    }
+}
+
+
+/*
+  Each register of 4 UV pairs is shuffled to U0-U3 V0-V3, then the low and
+  high halves of two registers are joined. packus_epi32 would need SSE4.1
+  and packs_epi32 saturates 16bit samples above 0x7FFF.
+*/
+static void split_uv16_sse2(const uint8_t* srcp, uint8_t* dstp0,
+                            uint8_t* dstp1, int n, int fmt)
+{
+    const bool swap = (fmt & SAMPLE_BE) != 0;
+    const int shift = sample_shift(fmt);
+    const uint16_t mask = sample_mask(fmt);
+    const __m128i sh = _mm_cvtsi32_si128(shift);
+    const __m128i mk = _mm_set1_epi16(static_cast<short>(mask));
+    const uint16_t* s = reinterpret_cast<const uint16_t*>(srcp);
+    uint16_t* d0 = reinterpret_cast<uint16_t*>(dstp0);
+    uint16_t* d1 = reinterpret_cast<uint16_t*>(dstp1);
+
+    int x = 0;
+    for (; x + 8 <= n; x += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + x * 2));
+        __m128i b = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(s + x * 2 + 8));
+        a = _mm_shufflelo_epi16(a, _MM_SHUFFLE(3, 1, 2, 0));
+        a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(3, 1, 2, 0));
+        a = _mm_shuffle_epi32(a, _MM_SHUFFLE(3, 1, 2, 0));
+        b = _mm_shufflelo_epi16(b, _MM_SHUFFLE(3, 1, 2, 0));
+        b = _mm_shufflehi_epi16(b, _MM_SHUFFLE(3, 1, 2, 0));
+        b = _mm_shuffle_epi32(b, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d0 + x),
+                         convert16_sse2(_mm_unpacklo_epi64(a, b), swap, sh, mk));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(d1 + x),
+                         convert16_sse2(_mm_unpackhi_epi64(a, b), swap, sh, mk));
+    }
+    for (; x < n; ++x) {
+        d0[x] = convert_sample(s[x * 2], swap, shift, mask);
+        d1[x] = convert_sample(s[x * 2 + 1], swap, shift, mask);
+    }
+}
+
+
+static const row_funcs funcs_sse2 = {
+    convert_row16_sse2, split_uv8_sse2, split_uv16_sse2
+};
+
+
+void __stdcall
+write_planar16_sse2(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                    uint8_t* buff, int* order, int count, ise_t* env)
+                    noexcept
+{
+    write_planar16_common(rd, pos, dst, buff, order, count, funcs_sse2);
+}
+
+
+void __stdcall
+write_semi_planar_sse2(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                       uint8_t* buff, int* order, int count, ise_t* env)
+                       noexcept
+{
+    write_semi_planar_common(rd, pos, dst, buff, order, count, funcs_sse2);
+}
+
+
+/*
+  Each word of v210 holds three samples. They are masked out to three
+  registers (bits 0, 10 and 20), the first two are merged into 16bit words,
+  and pshufb picks Y, Cb and Cr of 6 pixels from those.
+*/
+static void unpack_v210_row_ssse3(const uint8_t* srcp, uint16_t* dsty,
+                                  uint16_t* dstu, uint16_t* dstv, int width)
+{
+    const __m128i mask = _mm_set1_epi32(0x3FF);
+    const __m128i y_ab = _mm_setr_epi8(
+        2, 3, 4, 5, -1, -1, 10, 11, 12, 13, -1, -1, -1, -1, -1, -1);
+    const __m128i y_c = _mm_setr_epi8(
+        -1, -1, -1, -1, 4, 5, -1, -1, -1, -1, 12, 13, -1, -1, -1, -1);
+    const __m128i u_ab = _mm_setr_epi8(
+        0, 1, 6, 7, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i u_c = _mm_setr_epi8(
+        -1, -1, -1, -1, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i v_ab = _mm_setr_epi8(
+        -1, -1, 8, 9, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i v_c = _mm_setr_epi8(
+        0, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+
+    // stores are 8 samples wide, the unused tail is overwritten by the next.
+    int x = 0;
+    for (; x + 16 <= width; x += 6) {
+        __m128i s = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(srcp + x / 6 * 16));
+        __m128i a = _mm_and_si128(s, mask);
+        __m128i b = _mm_and_si128(_mm_srli_epi32(s, 10), mask);
+        __m128i c = _mm_and_si128(_mm_srli_epi32(s, 20), mask);
+        __m128i ab = _mm_or_si128(a, _mm_slli_epi32(b, 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dsty + x),
+                         _mm_or_si128(_mm_shuffle_epi8(ab, y_ab),
+                                      _mm_shuffle_epi8(c, y_c)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dstu + x / 2),
+                         _mm_or_si128(_mm_shuffle_epi8(ab, u_ab),
+                                      _mm_shuffle_epi8(c, u_c)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dstv + x / 2),
+                         _mm_or_si128(_mm_shuffle_epi8(ab, v_ab),
+                                      _mm_shuffle_epi8(c, v_c)));
+    }
+    unpack_v210_row_c(srcp, dsty, dstu, dstv, x, width);
+}
+
+
+// pshufb groups Y and CbCr of 4 pixels, two registers are joined.
+static void unpack_y210_row_ssse3(const uint8_t* srcp, uint16_t* dsty,
+                                  uint16_t* dstu, uint16_t* dstv, int width,
+                                  int fmt)
+{
+    const __m128i order = _mm_setr_epi8(
+        0, 1, 4, 5, 8, 9, 12, 13, 2, 3, 10, 11, 6, 7, 14, 15);
+    const __m128i sh = _mm_cvtsi32_si128(sample_shift(fmt));
+    const __m128i mk = _mm_set1_epi16(static_cast<short>(sample_mask(fmt)));
+    const uint16_t* s = reinterpret_cast<const uint16_t*>(srcp);
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(s + x * 2)), order);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(s + x * 2 + 8)), order);
+        __m128i y = _mm_unpacklo_epi64(a, b);
+        __m128i uv = _mm_shuffle_epi32(_mm_unpackhi_epi64(a, b),
+                                       _MM_SHUFFLE(3, 1, 2, 0));
+        y = _mm_and_si128(_mm_srl_epi16(y, sh), mk);
+        uv = _mm_and_si128(_mm_srl_epi16(uv, sh), mk);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dsty + x), y);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dstu + x / 2), uv);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dstv + x / 2),
+                         _mm_unpackhi_epi64(uv, uv));
+    }
+    unpack_y210_row_c(srcp, dsty, dstu, dstv, x, width, fmt);
+}
+
+
+/*
+  The big endian words are swapped by pshufb, then every component is
+  shifted out and two registers are packed to 16bit. packs_epi32 does not
+  saturate 10bit values.
+*/
+static void unpack_rgb10_row_ssse3(const uint8_t* srcp, uint16_t* dstr,
+                                   uint16_t* dstg, uint16_t* dstb, int width,
+                                   const int* order)
+{
+    const __m128i swap = _mm_setr_epi8(
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    const __m128i mask = _mm_set1_epi32(0x3FF);
+    const __m128i shift[3] = {
+        _mm_cvtsi32_si128(order[0]),
+        _mm_cvtsi32_si128(order[1]),
+        _mm_cvtsi32_si128(order[2]),
+    };
+    uint16_t* dstp[3] = {dstr, dstg, dstb};
+
+    int x = 0;
+    for (; x + 8 <= width; x += 8) {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(srcp + x * 4)), swap);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(srcp + x * 4 + 16)), swap);
+        for (int i = 0; i < 3; ++i) {
+            __m128i c = _mm_packs_epi32(
+                _mm_and_si128(_mm_srl_epi32(a, shift[i]), mask),
+                _mm_and_si128(_mm_srl_epi32(b, shift[i]), mask));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dstp[i] + x), c);
+        }
+    }
+    unpack_rgb10_row_c(srcp, dstr, dstg, dstb, x, width, order);
+}
+
+
+void __stdcall
+write_v210_ssse3(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+                 int* order, int count, ise_t* env) noexcept
+{
+    const int width = dst->GetRowSize(PLANAR_Y) / 2;
+    const int height = dst->GetHeight(PLANAR_Y);
+    const size_t src_pitch = v210_row_size(width);
+    uint8_t* dsty = dst->GetWritePtr(PLANAR_Y);
+    uint8_t* dstu = dst->GetWritePtr(PLANAR_U);
+    uint8_t* dstv = dst->GetWritePtr(PLANAR_V);
+    const int pitch_y = dst->GetPitch(PLANAR_Y);
+    const int pitch_uv = dst->GetPitch(PLANAR_U);
+    const uint8_t* srcp = rd.get(buff, src_pitch * height, pos);
+
+    for (int y = 0; y < height; ++y) {
+        unpack_v210_row_ssse3(srcp, reinterpret_cast<uint16_t*>(dsty),
+                              reinterpret_cast<uint16_t*>(dstu),
+                              reinterpret_cast<uint16_t*>(dstv), width);
+        srcp += src_pitch;
+        dsty += pitch_y;
+        dstu += pitch_uv;
+        dstv += pitch_uv;
+    }
+}
+
+
+void __stdcall
+write_y210_ssse3(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+                 int* order, int count, ise_t* env) noexcept
+{
+    const int width = dst->GetRowSize(PLANAR_Y) / 2;
+    const int height = dst->GetHeight(PLANAR_Y);
+    const size_t src_pitch = static_cast<size_t>(width) * 4;
+    uint8_t* dsty = dst->GetWritePtr(PLANAR_Y);
+    uint8_t* dstu = dst->GetWritePtr(PLANAR_U);
+    uint8_t* dstv = dst->GetWritePtr(PLANAR_V);
+    const int pitch_y = dst->GetPitch(PLANAR_Y);
+    const int pitch_uv = dst->GetPitch(PLANAR_U);
+    const uint8_t* srcp = rd.get(buff, src_pitch * height, pos);
+
+    for (int y = 0; y < height; ++y) {
+        unpack_y210_row_ssse3(srcp, reinterpret_cast<uint16_t*>(dsty),
+                              reinterpret_cast<uint16_t*>(dstu),
+                              reinterpret_cast<uint16_t*>(dstv), width,
+                              order[3]);
+        srcp += src_pitch;
+        dsty += pitch_y;
+        dstu += pitch_uv;
+        dstv += pitch_uv;
+    }
+}
+
+
+void __stdcall
+write_rgb10_ssse3(RawReader& rd, int64_t pos, PVideoFrame& dst, uint8_t* buff,
+                  int* order, int count, ise_t* env) noexcept
+{
+    const int width = dst->GetRowSize(PLANAR_G) / 2;
+    const int height = dst->GetHeight(PLANAR_G);
+    const size_t src_pitch = rgb10_row_size(width, order[3]);
+    uint8_t* dstr = dst->GetWritePtr(PLANAR_R);
+    uint8_t* dstg = dst->GetWritePtr(PLANAR_G);
+    uint8_t* dstb = dst->GetWritePtr(PLANAR_B);
+    const int pitch = dst->GetPitch(PLANAR_G);
+    const uint8_t* srcp = rd.get(buff, src_pitch * height, pos);
+
+    for (int y = 0; y < height; ++y) {
+        unpack_rgb10_row_ssse3(srcp, reinterpret_cast<uint16_t*>(dstr),
+                               reinterpret_cast<uint16_t*>(dstg),
+                               reinterpret_cast<uint16_t*>(dstb), width,
+                               order);
+        srcp += src_pitch;
+        dstr += pitch;
+        dstg += pitch;
+        dstb += pitch;
+    }
+}
+
+
+/*
+  pshufb groups Y and UV of 8 pixels of each register, two registers give
+  16 Y and 8 U and V.
+*/
+static void unpack_packed422_row_ssse3(const uint8_t* srcp, uint8_t* dsty,
+                                       uint8_t* dstu, uint8_t* dstv,
+                                       int width, const int* order)
+{
+    alignas(16) int8_t shuffle[16];
+    for (int i = 0; i < 4; ++i) {
+        shuffle[i * 2] = static_cast<int8_t>(i * 4 + order[0]);
+        shuffle[i * 2 + 1] = static_cast<int8_t>(i * 4 + order[2]);
+        shuffle[8 + i] = static_cast<int8_t>(i * 4 + order[1]);
+        shuffle[12 + i] = static_cast<int8_t>(i * 4 + order[3]);
+    }
+    const __m128i mask = _mm_load_si128(reinterpret_cast<__m128i*>(shuffle));
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(srcp + x * 2)), mask);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(srcp + x * 2 + 16)), mask);
+        __m128i uv = _mm_shuffle_epi32(_mm_unpackhi_epi64(a, b),
+                                       _MM_SHUFFLE(3, 1, 2, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dsty + x),
+                         _mm_unpacklo_epi64(a, b));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dstu + x / 2), uv);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dstv + x / 2),
+                         _mm_unpackhi_epi64(uv, uv));
+    }
+    unpack_packed422_row_c(srcp, dsty, dstu, dstv, x, width, order);
+}
+
+
+/*
+  pshufb sorts the 4 pixels of a register to Y0-3 U0-3 V0-3 A0-3 (A is
+  zero with 3 bytes per pixel), then 4 registers are transposed like a
+  4x4 matrix of dwords. The loads are count * 4 bytes apart, the last one
+  reads up to 4 bytes beyond its pixels, so the loop stops before the end
+  of the row.
+*/
+static void unpack_packed444_row_ssse3(const uint8_t* srcp,
+                                       uint8_t* const* dstp, int width,
+                                       const int* order, int count)
+{
+    alignas(16) int8_t shuffle[16];
+    for (int k = 0; k < 4; ++k) {
+        for (int i = 0; i < 4; ++i) {
+            shuffle[k * 4 + i] = static_cast<int8_t>(
+                k < count ? i * count + order[k] : -1);
+        }
+    }
+    const __m128i mask = _mm_load_si128(reinterpret_cast<__m128i*>(shuffle));
+    const int step = count * 4;
+
+    int x = 0;
+    for (; (x + 12) * count + 16 <= width * count; x += 16) {
+        const uint8_t* s = srcp + x * count;
+        __m128i a = _mm_shuffle_epi8(_mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(s)), mask);
+        __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(s + step)), mask);
+        __m128i c = _mm_shuffle_epi8(_mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(s + step * 2)), mask);
+        __m128i d = _mm_shuffle_epi8(_mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(s + step * 3)), mask);
+        __m128i yu_ab = _mm_unpacklo_epi32(a, b);
+        __m128i yu_cd = _mm_unpacklo_epi32(c, d);
+        __m128i va_ab = _mm_unpackhi_epi32(a, b);
+        __m128i va_cd = _mm_unpackhi_epi32(c, d);
+        const __m128i planes[4] = {
+            _mm_unpacklo_epi64(yu_ab, yu_cd),
+            _mm_unpackhi_epi64(yu_ab, yu_cd),
+            _mm_unpacklo_epi64(va_ab, va_cd),
+            _mm_unpackhi_epi64(va_ab, va_cd),
+        };
+        for (int k = 0; k < count; ++k) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dstp[k] + x),
+                             planes[k]);
+        }
+    }
+    unpack_packed444_row_c(srcp, dstp, x, width, order, count);
+}
+
+
+void __stdcall
+write_packed422_ssse3(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                      uint8_t* buff, int* order, int count, ise_t* env)
+                      noexcept
+{
+    const int width = dst->GetRowSize(PLANAR_Y);
+    const int height = dst->GetHeight(PLANAR_Y);
+    const size_t src_pitch = static_cast<size_t>(width) * 2;
+    uint8_t* dsty = dst->GetWritePtr(PLANAR_Y);
+    uint8_t* dstu = dst->GetWritePtr(PLANAR_U);
+    uint8_t* dstv = dst->GetWritePtr(PLANAR_V);
+    const int pitch_y = dst->GetPitch(PLANAR_Y);
+    const int pitch_uv = dst->GetPitch(PLANAR_U);
+    const uint8_t* srcp = rd.get(buff, src_pitch * height, pos);
+
+    for (int y = 0; y < height; ++y) {
+        unpack_packed422_row_ssse3(srcp, dsty, dstu, dstv, width, order);
+        srcp += src_pitch;
+        dsty += pitch_y;
+        dstu += pitch_uv;
+        dstv += pitch_uv;
+    }
+}
+
+
+void __stdcall
+write_packed444_ssse3(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                      uint8_t* buff, int* order, int count, ise_t* env)
+                      noexcept
+{
+    write_packed444_common(rd, pos, dst, buff, order, count, false,
+                           unpack_packed444_row_ssse3);
+}
+
+
+void __stdcall
+write_packed_rgbp_ssse3(RawReader& rd, int64_t pos, PVideoFrame& dst,
+                        uint8_t* buff, int* order, int count, ise_t* env)
+                        noexcept
+{
+    write_packed444_common(rd, pos, dst, buff, order, count, true,
+                           unpack_packed444_row_ssse3);
+}